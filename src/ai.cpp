@@ -17,11 +17,17 @@
     along with rokuyon. If not, see <https://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
 #include <atomic>
-#include <cstring>
-#include <queue>
+#include <chrono>
+#include <cmath>
 #include <thread>
-#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
 
 #include "ai.h"
 #include "core.h"
@@ -30,49 +36,208 @@
 #include "mi.h"
 #include "settings.h"
 
-#define MAX_BUFFERS 4
 #define SAMPLE_COUNT 1024
 #define OUTPUT_RATE 48000
-#define OUTPUT_SIZE SAMPLE_COUNT * sizeof(uint32_t)
+#define RING_SIZE 0x4000
+#define FILTER_TAPS 8
+#define FILTER_PHASES 0x100
 
 struct Samples {
     uint32_t address;
     uint32_t count;
 };
 
+enum Resampler {
+    RESAMPLE_NEAREST = 0,
+    RESAMPLE_LINEAR,
+    RESAMPLE_CUBIC,
+    RESAMPLE_SINC
+};
+
 namespace AI {
-    uint32_t bufferOut[SAMPLE_COUNT];
-    std::atomic<bool> ready;
+    // Stereo samples at the input rate, written by the emulator and read by the audio callback
+    // The first few samples are mirrored past the end so filters can read across the wrap
+    uint32_t ring[RING_SIZE + FILTER_TAPS];
+    std::atomic<uint32_t> ringWrite;
+    std::atomic<uint32_t> ringRead;
+    std::atomic<uint32_t> inputRate;
+
+    // Output frames played by the audio callback and emulated by the core, for speed limiting
+    std::atomic<uint32_t> outputFrames;
+    uint32_t emulatedFrames;
+
+    uint32_t lastSample;
+    uint32_t position;
+
+    // Filter coefficients in 1.14 fixed point for each fractional sample position
+    int16_t linearFilter[FILTER_PHASES][4];
+    int16_t cubicFilter[FILTER_PHASES][4];
+    int16_t sincFilter[FILTER_PHASES][8];
+    bool filtersReady;
 
     Samples samples[2];
-    std::queue<std::vector<uint32_t>> buffers;
-    uint32_t offset;
 
     uint32_t dramAddr;
     uint32_t control;
     uint32_t frequency;
     uint32_t status;
 
+    inline int16_t clamp16(int32_t value) {
+        // Saturate a value to the signed 16-bit range
+        return std::max(-0x8000, std::min(0x7FFF, value));
+    }
+
+#if defined(__SSE2__)
+    inline uint32_t filter4(const uint32_t *src, const int16_t *coefs) {
+        // Apply 4 filter taps to 4 stereo frames, grouping channels so pairs of taps can be multiplied at once
+        __m128i s = _mm_loadu_si128((const __m128i*)src);
+        __m128i h = _mm_loadl_epi64((const __m128i*)coefs);
+        s = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, 0xD8), 0xD8);
+        __m128i p = _mm_madd_epi16(s, _mm_unpacklo_epi32(h, h));
+        p = _mm_add_epi32(p, _mm_shuffle_epi32(p, 0x4E));
+        p = _mm_srai_epi32(_mm_add_epi32(p, _mm_set1_epi32(0x2000)), 14);
+        return _mm_cvtsi128_si32(_mm_packs_epi32(p, p));
+    }
+
+    inline uint32_t filter8(const uint32_t *src, const int16_t *coefs) {
+        // Apply 8 filter taps to 8 stereo frames, grouping channels so pairs of taps can be multiplied at once
+        __m128i s0 = _mm_loadu_si128((const __m128i*)&src[0]);
+        __m128i s1 = _mm_loadu_si128((const __m128i*)&src[4]);
+        __m128i h = _mm_loadu_si128((const __m128i*)coefs);
+        s0 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s0, 0xD8), 0xD8);
+        s1 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s1, 0xD8), 0xD8);
+        __m128i p = _mm_add_epi32(_mm_madd_epi16(s0, _mm_unpacklo_epi32(h, h)),
+            _mm_madd_epi16(s1, _mm_unpackhi_epi32(h, h)));
+        p = _mm_add_epi32(p, _mm_shuffle_epi32(p, 0x4E));
+        p = _mm_srai_epi32(_mm_add_epi32(p, _mm_set1_epi32(0x2000)), 14);
+        return _mm_cvtsi128_si32(_mm_packs_epi32(p, p));
+    }
+#elif defined(__aarch64__)
+    inline uint32_t filter4(const uint32_t *src, const int16_t *coefs) {
+        // Apply 4 filter taps to 4 stereo frames, splitting the channels with a deinterleaving load
+        int16x4x2_t s = vld2_s16((const int16_t*)src);
+        int16x4_t h = vld1_s16(coefs);
+        int32_t l = (vaddvq_s32(vmull_s16(s.val[0], h)) + 0x2000) >> 14;
+        int32_t r = (vaddvq_s32(vmull_s16(s.val[1], h)) + 0x2000) >> 14;
+        return uint16_t(clamp16(l)) | (uint16_t(clamp16(r)) << 16);
+    }
+
+    inline uint32_t filter8(const uint32_t *src, const int16_t *coefs) {
+        // Apply 8 filter taps to 8 stereo frames, splitting the channels with a deinterleaving load
+        int16x8x2_t s = vld2q_s16((const int16_t*)src);
+        int16x8_t h = vld1q_s16(coefs);
+        int32x4_t l = vmlal_s16(vmull_s16(vget_low_s16(s.val[0]), vget_low_s16(h)), vget_high_s16(s.val[0]), vget_high_s16(h));
+        int32x4_t r = vmlal_s16(vmull_s16(vget_low_s16(s.val[1]), vget_low_s16(h)), vget_high_s16(s.val[1]), vget_high_s16(h));
+        return uint16_t(clamp16((vaddvq_s32(l) + 0x2000) >> 14)) | (uint16_t(clamp16((vaddvq_s32(r) + 0x2000) >> 14)) << 16);
+    }
+#else
+    template <int taps> inline uint32_t filter(const uint32_t *src, const int16_t *coefs) {
+        // Apply filter taps to stereo frames one channel at a time
+        int32_t l = 0x2000, r = 0x2000;
+        for (int i = 0; i < taps; i++) {
+            l += int16_t(src[i] >> 0) * coefs[i];
+            r += int16_t(src[i] >> 16) * coefs[i];
+        }
+        return uint16_t(clamp16(l >> 14)) | (uint16_t(clamp16(r >> 14)) << 16);
+    }
+
+    inline uint32_t filter4(const uint32_t *src, const int16_t *coefs) { return filter<4>(src, coefs); }
+    inline uint32_t filter8(const uint32_t *src, const int16_t *coefs) { return filter<8>(src, coefs); }
+#endif
+
+    template <Resampler type> uint32_t resample(uint32_t *out, uint32_t read, uint32_t count, uint32_t step);
+    void initFilters();
     void createBuffer();
     void submitBuffer();
     void processBuffer();
 }
 
 void AI::fillBuffer(uint32_t *out) {
-    // Try to wait until a buffer is ready, but don't stall the audio callback too long
-    std::chrono::steady_clock::time_point waitTime = std::chrono::steady_clock::now();
-    while (!ready.load()) {
-        if (std::chrono::steady_clock::now() - waitTime > std::chrono::microseconds(1000000 / 60)) {
-            // If a buffer isn't ready in time, fill the output with the last played sample
-            for (int i = 0; i < SAMPLE_COUNT; i++)
-                out[i] = bufferOut[SAMPLE_COUNT - 1];
-            return;
+    // Get the range of queued samples and the rate they were submitted at
+    uint32_t read = ringRead.load(std::memory_order_relaxed);
+    uint32_t count = ringWrite.load(std::memory_order_acquire) - read;
+    uint32_t rate = inputRate.load(std::memory_order_relaxed);
+
+    if (rate) {
+        // Nudge the resampling ratio by up to 0.5% to keep the queue near 2 output buffers of latency
+        float target = float(SAMPLE_COUNT * 2) * rate / OUTPUT_RATE;
+        float error = std::max(-1.0f, std::min(1.0f, (count - target) / target));
+        uint32_t step = uint32_t(float(rate) / OUTPUT_RATE * (1.0f + error * 0.005f) * 0x10000);
+
+        // Resample the queued samples with the selected filter
+        uint32_t i;
+        switch (Settings::audioResampler) {
+            case RESAMPLE_NEAREST: i = resample<RESAMPLE_NEAREST>(out, read, count, step); break;
+            case RESAMPLE_CUBIC: i = resample<RESAMPLE_CUBIC>(out, read, count, step); break;
+            case RESAMPLE_SINC: i = resample<RESAMPLE_SINC>(out, read, count, step); break;
+            default: i = resample<RESAMPLE_LINEAR>(out, read, count, step); break;
         }
+        if (i > 0) lastSample = out[i - 1];
+
+        // Mark the samples that were passed as used
+        uint32_t used = std::min(position >> 16, count);
+        ringRead.store(read + used, std::memory_order_release);
+        position -= used << 16;
+
+        // Fill the rest of the output with the last played sample if the queue ran dry
+        for (; i < SAMPLE_COUNT; i++)
+            out[i] = lastSample;
+    }
+    else {
+        // Fill the output with the last played sample if nothing has been submitted
+        for (int i = 0; i < SAMPLE_COUNT; i++)
+            out[i] = lastSample;
     }
 
-    // Output the buffer and mark it as used
-    memcpy(out, bufferOut, OUTPUT_SIZE);
-    ready.store(false);
+    // Count the output frames for the speed limiter
+    outputFrames.fetch_add(SAMPLE_COUNT, std::memory_order_release);
+}
+
+template <Resampler type> uint32_t AI::resample(uint32_t *out, uint32_t read, uint32_t count, uint32_t step) {
+    // Step through the queued samples in 16.16 fixed point, stopping early if they run out
+    // Each output is centered 3 frames ahead of the position so every filter's taps are queued
+    uint32_t i = 0;
+    for (; i < SAMPLE_COUNT && (position >> 16) + FILTER_TAPS <= count; i++, position += step) {
+        const uint32_t *src = &ring[(read + (position >> 16)) & (RING_SIZE - 1)];
+        uint32_t phase = (position & 0xFFFF) * FILTER_PHASES >> 16;
+        switch (type) {
+            case RESAMPLE_NEAREST: out[i] = src[3]; break;
+            case RESAMPLE_LINEAR: out[i] = filter4(&src[2], linearFilter[phase]); break;
+            case RESAMPLE_CUBIC: out[i] = filter4(&src[2], cubicFilter[phase]); break;
+            case RESAMPLE_SINC: out[i] = filter8(&src[0], sincFilter[phase]); break;
+        }
+    }
+    return i;
+}
+
+void AI::initFilters() {
+    // Build coefficients for each filter at every fractional position between frames
+    for (int i = 0; i < FILTER_PHASES; i++) {
+        double f = double(i) / FILTER_PHASES;
+        double linear[4] = { 0, 1 - f, f, 0 };
+        double cubic[4] = { // Catmull-Rom spline
+            (-f * f * f + 2 * f * f - f) / 2,
+            (3 * f * f * f - 5 * f * f + 2) / 2,
+            (-3 * f * f * f + 4 * f * f + f) / 2,
+            (f * f * f - f * f) / 2
+        };
+        double sinc[8];
+        for (int j = 0; j < 8; j++) { // Lanczos window with 4 lobes
+            double x = (j - 3) - f;
+            sinc[j] = (x == 0) ? 1 : (4 * sin(M_PI * x) * sin(M_PI * x / 4) / (M_PI * M_PI * x * x));
+        }
+
+        // Normalize the coefficients so each filter has unity gain
+        double sum = 0;
+        for (int j = 0; j < 8; j++) sum += sinc[j];
+        for (int j = 0; j < 4; j++) {
+            linearFilter[i][j] = lround(linear[j] * 0x4000);
+            cubicFilter[i][j] = lround(cubic[j] * 0x4000);
+        }
+        for (int j = 0; j < 8; j++)
+            sincFilter[i][j] = lround(sinc[j] / sum * 0x4000);
+    }
+    filtersReady = true;
 }
 
 void AI::reset() {
@@ -82,6 +247,13 @@ void AI::reset() {
     frequency = 0;
     status = 0;
 
+    // Prepare the resampling filters the first time
+    if (!filtersReady)
+        initFilters();
+
+    // Start the speed limiter in sync with the audio output
+    emulatedFrames = outputFrames.load(std::memory_order_acquire);
+
     // Schedule the first audio buffer to output
     Core::schedule(createBuffer, (uint64_t)SAMPLE_COUNT * (93750000 * 2) / OUTPUT_RATE);
 }
@@ -147,35 +319,17 @@ void AI::write(uint32_t address, uint32_t value) {
 }
 
 void AI::createBuffer() {
-    // Wait until the previous buffer has been used
-    while (Settings::fpsLimiter && Core::running && ready.load())
-        std::this_thread::yield();
-
-    memset(bufferOut, 0, OUTPUT_SIZE);
-    size_t count = 0;
-
-    while (!buffers.empty() && count < OUTPUT_SIZE) {
-        // Get the current queued buffer and the size of its remaining samples
-        std::vector<uint32_t> &buffer = buffers.front();
-        size_t size = (buffer.size() - offset) * sizeof(uint32_t);
-
-        if (size <= OUTPUT_SIZE - count) {
-            // Copy all of the remaining queued samples to the output buffer
-            memcpy(&bufferOut[count / sizeof(uint32_t)], &buffer[offset], size);
-            count += size;
-            offset = 0;
-            buffers.pop();
-        }
-        else {
-            // Copy as many queued samples that can fit to the output buffer
-            memcpy(&bufferOut[count / sizeof(uint32_t)], &buffer[offset], OUTPUT_SIZE - count);
-            offset += (OUTPUT_SIZE - count) / sizeof(uint32_t);
-            break;
-        }
-    }
+    // Count a buffer's worth of emulated output, catching up if the audio output has pulled ahead
+    emulatedFrames += SAMPLE_COUNT;
+    if (int32_t(outputFrames.load(std::memory_order_acquire) - emulatedFrames) > 0)
+        emulatedFrames = outputFrames.load(std::memory_order_acquire);
+
+    // Sleep while emulation is more than 2 buffers ahead of the audio output
+    while (Settings::fpsLimiter && Core::running &&
+        int32_t(emulatedFrames - outputFrames.load(std::memory_order_acquire)) > SAMPLE_COUNT * 2)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
 
-    // Mark the buffer as ready and schedule the next one
-    ready.store(true);
+    // Schedule the next buffer
     Core::schedule(createBuffer, (uint64_t)SAMPLE_COUNT * (93750000 * 2) / OUTPUT_RATE);
 }
 
@@ -183,22 +337,26 @@ void AI::submitBuffer() {
     LOG_INFO("Submitting %d AI samples from RDRAM 0x%X at frequency %dHz\n",
         samples[0].count, samples[0].address, frequency);
 
-    if (buffers.size() < MAX_BUFFERS) {
-        // Create a new audio buffer based on sample count and frequency
-        size_t count = samples[0].count * OUTPUT_RATE / frequency;
-        std::vector<uint32_t> buffer(count);
-
-        // Copy samples to the buffer, scaled from their original frequency
-        for (size_t i = 0; i < count; i++) {
-            uint32_t address = samples[0].address + (i * samples[0].count / count) * 4;
-            uint32_t value = Memory::read<uint32_t>(0xA0000000 + address);
-            buffer[i] = (value << 16) | (value >> 16);
-        }
-
-        // Add the buffer to the output queue
-        buffers.push(buffer);
+    // Limit the samples to the free space in the queue, dropping the rest if the output is behind
+    uint32_t write = ringWrite.load(std::memory_order_relaxed);
+    uint32_t space = RING_SIZE - (write - ringRead.load(std::memory_order_acquire));
+    uint32_t count = std::min(samples[0].count, space);
+
+    // Copy samples to the queue with their channels swapped to host order, reading RDRAM directly if possible
+    uint32_t *src = (samples[0].address & 0x3) ? nullptr :
+        (uint32_t*)Memory::getRdram(samples[0].address, count * 4);
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t value = src ? src[i] : Memory::read<uint32_t>(0xA0000000 + samples[0].address + i * 4);
+        uint32_t index = (write + i) & (RING_SIZE - 1);
+        ring[index] = (value << 16) | (value >> 16);
+        if (index < FILTER_TAPS)
+            ring[RING_SIZE + index] = ring[index];
     }
 
+    // Publish the samples and the rate to play them at
+    inputRate.store(frequency, std::memory_order_relaxed);
+    ringWrite.store(write + count, std::memory_order_release);
+
     // Schedule the logical completion of the AI DMA based on sample count and frequency
     Core::schedule(processBuffer, (uint64_t)samples[0].count * (93750000 * 2) / frequency);
 }
@@ -18,6 +18,7 @@
 */
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <condition_variable>
 #include <cstring>
@@ -27,8 +28,10 @@
 #include "core.h"
 #include "ai.h"
 #include "cpu.h"
+#include "cpu_cache.h"
 #include "cpu_cp0.h"
 #include "cpu_cp1.h"
+#include "cpu_jit.h"
 #include "log.h"
 #include "memory.h"
 #include "mi.h"
@@ -38,33 +41,47 @@
 #include "rsp.h"
 #include "rsp_cp0.h"
 #include "rsp_cp2.h"
+#include "rsp_hle.h"
+#include "rsp_jit.h"
+#include "settings.h"
 #include "si.h"
 #include "vi.h"
 
-struct Task {
-    Task(void (*function)(), uint32_t cycles):
-        function(function), cycles(cycles) {}
+enum RspState {
+    RSP_IDLE = 0,
+    RSP_RUN,
+    RSP_SYNC,
+    RSP_SERVICE,
+    RSP_EXIT
+};
 
+struct Task {
     void (*function)();
     uint32_t cycles;
-
-    bool operator<(const Task &task) const {
-        return cycles < task.cycles;
-    }
+    uint64_t order;
+    size_t index;
 };
 
 namespace Core {
     std::thread *emuThread;
     std::thread *saveThread;
+    std::thread *rspThread;
     std::condition_variable condVar;
+    std::condition_variable rspCondVar;
     std::mutex waitMutex;
     std::mutex saveMutex;
+    std::mutex rspMutex;
+    std::atomic<RspState> rspState;
+    uint32_t rspTarget;
 
     bool running;
     bool cpuRunning;
     bool rspRunning;
 
     std::vector<Task> tasks;
+    std::vector<int> queue;
+    std::vector<int> freeTasks;
+    uint64_t taskOrder;
     uint32_t globalCycles;
     uint32_t cpuCycles;
     uint32_t rspCycles;
@@ -81,9 +98,18 @@ namespace Core {
     bool saveDirty;
 
     void runLoop();
+    void rspLoop();
+    uint32_t runCpu();
+    uint32_t runRsp();
+    void serviceRsp();
     void saveLoop();
     void updateSave();
     void resetCycles();
+
+    bool taskBefore(int a, int b);
+    void siftUp(size_t i);
+    void siftDown(size_t i);
+    void removeTask(size_t i);
 }
 
 bool Core::bootRom(const std::string &path) {
@@ -99,10 +125,16 @@ bool Core::bootRom(const std::string &path) {
     fseek(romFile, 0, SEEK_END);
     romSize = ftell(romFile);
     fseek(romFile, 0, SEEK_SET);
-    rom = new uint8_t[romSize];
+    rom = new uint8_t[(romSize + 3) & ~3]();
     fread(rom, sizeof(uint8_t), romSize, romFile);
     fclose(romFile);
 
+    // Convert the ROM from big-endian to host-endian words, so it can be accessed natively
+    for (uint32_t i = 0; i < romSize; i += 4) {
+        std::swap(rom[i + 0], rom[i + 3]);
+        std::swap(rom[i + 1], rom[i + 2]);
+    }
+
     // Derive the save path from the ROM path
     savePath = path.substr(0, path.rfind(".")) + ".sav";
     if (save) delete[] save;
@@ -127,6 +159,9 @@ bool Core::bootRom(const std::string &path) {
     // Reset the scheduler
     cpuRunning = true;
     tasks.clear();
+    queue.clear();
+    freeTasks.clear();
+    taskOrder = 0;
     globalCycles = 0;
     cpuCycles = 0;
     rspCycles = 0;
@@ -136,8 +171,10 @@ bool Core::bootRom(const std::string &path) {
     Memory::reset();
     AI::reset();
     CPU::reset();
+    CPU_CACHE::reset();
     CPU_CP0::reset();
     CPU_CP1::reset();
+    CPU_JIT::reset();
     MI::reset();
     PI::reset();
     SI::reset();
@@ -147,6 +184,8 @@ bool Core::bootRom(const std::string &path) {
     RSP::reset();
     RSP_CP0::reset();
     RSP_CP2::reset();
+    RSP_HLE::reset();
+    RSP_JIT::reset();
 
     // Start the emulator
     start();
@@ -181,6 +220,9 @@ void Core::start() {
     // Start the threads if emulation wasn't running
     if (!running) {
         running = true;
+        rspState = RSP_IDLE;
+        if (Settings::threadedRsp)
+            rspThread = new std::thread(rspLoop);
         emuThread = new std::thread(runLoop);
         saveThread = new std::thread(saveLoop);
     }
@@ -200,40 +242,166 @@ void Core::stop() {
         delete emuThread;
         delete saveThread;
         RDP::finishThread();
+
+        if (rspThread) {
+            // Stop the RSP thread if it was running
+            {
+                std::lock_guard<std::mutex> guard(rspMutex);
+                rspState = RSP_EXIT;
+                rspCondVar.notify_all();
+            }
+            rspThread->join();
+            delete rspThread;
+            rspThread = nullptr;
+        }
     }
 }
 
 void Core::runLoop() {
     while (running) {
-        // Run the CPUs until the next scheduled task
-        while (tasks[0].cycles > globalCycles) {
-            // Run a CPU opcode if ready and schedule the next one
-            if (cpuRunning && globalCycles >= cpuCycles) {
-                CPU::runOpcode();
-                cpuCycles = globalCycles + 2;
+        // The RSP thread always runs in batches, using the long sync quantum if exact sync is set
+        uint32_t quantum = Settings::syncQuantum ? Settings::syncQuantum : (rspThread ? 1536 : 0);
+
+        if (quantum) {
+            // Run the CPUs in batches until the next scheduled task, or the end of the sync quantum
+            uint32_t target = std::min<uint32_t>(tasks[queue[0]].cycles, globalCycles + quantum);
+            cpuCycles = std::max(cpuCycles, globalCycles);
+            rspCycles = std::max(rspCycles, globalCycles);
+
+            if (rspThread) {
+                // Start the RSP batch on its own thread, so it can run alongside the CPU
+                if (rspRunning && rspCycles < target) {
+                    std::lock_guard<std::mutex> guard(rspMutex);
+                    rspTarget = target;
+                    rspState = RSP_RUN;
+                    rspCondVar.notify_all();
+                }
+            }
+            else {
+                // Run the RSP for the batch first, with time held at the start of it
+                while (rspRunning && rspCycles < target)
+                    rspCycles += runRsp();
             }
 
-            // Run an RSP opcode if ready and schedule the next one
-            if (rspRunning && globalCycles >= rspCycles) {
-                RSP::runOpcode();
-                rspCycles = globalCycles + 3;
+            // Run the CPU for the batch, moving time along with it for accurate timer reads
+            // The batch is cut short if the CPU schedules a task that should happen sooner
+            while (cpuRunning && cpuCycles < target) {
+                globalCycles = cpuCycles;
+                cpuCycles += runCpu();
+                target = std::min<uint32_t>(tasks[queue[0]].cycles, target);
+
+                // Run an opcode for the RSP thread if it's waiting to sync
+                if (rspState == RSP_SYNC)
+                    serviceRsp();
             }
 
-            // Jump to the next soonest opcode
-            globalCycles = std::min<uint32_t>(cpuRunning ? cpuCycles : -1, rspRunning ? rspCycles : -1);
+            // Wait for the RSP batch to finish, and jump to the end of the batch
+            syncRsp();
+            globalCycles = target;
         }
+        else {
+            // Run the CPUs until the next scheduled task, interleaving them one opcode at a time
+            while (tasks[queue[0]].cycles > globalCycles) {
+                // Run a CPU opcode if ready and schedule the next one
+                if (cpuRunning && globalCycles >= cpuCycles)
+                    cpuCycles = globalCycles + runCpu();
+
+                // Run an RSP opcode if ready and schedule the next one
+                if (rspRunning && globalCycles >= rspCycles)
+                    rspCycles = globalCycles + runRsp();
+
+                // Jump to the next soonest opcode
+                globalCycles = std::min<uint32_t>(cpuRunning ? cpuCycles : -1, rspRunning ? rspCycles : -1);
+            }
+
+            // Jump to the next scheduled task
+            globalCycles = tasks[queue[0]].cycles;
+        }
+
+        // Run all tasks that are scheduled now, removing them first so their handles can be reused
+        while (tasks[queue[0]].cycles <= globalCycles) {
+            void (*function)() = tasks[queue[0]].function;
+            removeTask(0);
+            (*function)();
+        }
+    }
+}
+
+void Core::rspLoop() {
+    std::unique_lock<std::mutex> lock(rspMutex);
+    while (true) {
+        // Wait for a batch to run, or for the thread to be stopped
+        rspCondVar.wait(lock, [&]{ return rspState != RSP_IDLE; });
+        if (rspState == RSP_EXIT) return;
+        lock.unlock();
+
+        // Run the RSP for the batch, handing opcodes that access shared state to the emulator thread
+        while (rspRunning && rspCycles < rspTarget) {
+            if (RSP::needsSync()) {
+                lock.lock();
+                rspState = RSP_SYNC;
+                rspCondVar.notify_all();
+                rspCondVar.wait(lock, [&]{ return rspState == RSP_RUN; });
+                lock.unlock();
+                rspCycles += 3;
+            }
+            else {
+                rspCycles += runRsp();
+            }
+        }
+
+        // Signal that the batch is done
+        lock.lock();
+        rspState = RSP_IDLE;
+        rspCondVar.notify_all();
+    }
+}
 
-        // Jump to the next scheduled task
-        globalCycles = tasks[0].cycles;
+void Core::serviceRsp() {
+    // Run an opcode that the RSP thread handed over, then let the thread continue
+    rspState = RSP_SERVICE;
+    RSP::runOpcode();
+    std::lock_guard<std::mutex> guard(rspMutex);
+    rspState = RSP_RUN;
+    rspCondVar.notify_all();
+}
 
-        // Run all tasks that are scheduled now
-        while (tasks[0].cycles <= globalCycles) {
-            (*tasks[0].function)();
-            tasks.erase(tasks.begin());
+void Core::syncRsp() {
+    // Skip syncing if the RSP isn't threaded, or if this is an opcode being run for it
+    if (!rspThread || rspState == RSP_SERVICE)
+        return;
+
+    // Wait for the RSP thread to finish its batch, running any opcodes it hands over
+    std::unique_lock<std::mutex> lock(rspMutex);
+    while (rspState != RSP_IDLE) {
+        if (rspState == RSP_SYNC) {
+            lock.unlock();
+            serviceRsp();
+            lock.lock();
+            continue;
         }
+        rspCondVar.wait(lock);
     }
 }
 
+uint32_t Core::runCpu() {
+    // Run a CPU opcode, or a block of them with the JIT or cache, and return how many cycles it took
+    if (Settings::cpuJit)
+        return CPU_JIT::runBlock() * 2;
+    else if (Settings::cachedInterp)
+        return CPU_CACHE::runBlock() * 2;
+    CPU::runOpcode();
+    return 2;
+}
+
+uint32_t Core::runRsp() {
+    // Run an RSP opcode, or a block of them with the JIT, and return how many cycles it took
+    if (Settings::rspJit)
+        return RSP_JIT::runBlock() * 3;
+    RSP::runOpcode();
+    return 3;
+}
+
 void Core::saveLoop() {
     while (running) {
         // Every few seconds, check if the save file should be updated
@@ -284,8 +452,8 @@ void Core::updateSave() {
 void Core::resetCycles() {
     // Reset the cycle counts to prevent overflow
     CPU_CP0::resetCycles();
-    for (size_t i = 0; i < tasks.size(); i++)
-        tasks[i].cycles -= globalCycles;
+    for (size_t i = 0; i < queue.size(); i++)
+        tasks[queue[i]].cycles -= globalCycles;
     cpuCycles -= std::min(globalCycles, cpuCycles);
     rspCycles -= std::min(globalCycles, rspCycles);
     globalCycles -= globalCycles;
@@ -294,10 +462,83 @@ void Core::resetCycles() {
     schedule(resetCycles, 0x7FFFFFFF);
 }
 
-void Core::schedule(void (*function)(), uint32_t cycles) {
-    // Add a task to the scheduler, sorted by least to most cycles until execution
+int Core::schedule(void (*function)(), uint32_t cycles) {
+    // Get a free task handle, or make a new one if there are none
+    int task;
+    if (freeTasks.empty()) {
+        task = tasks.size();
+        tasks.push_back(Task());
+    }
+    else {
+        task = freeTasks.back();
+        freeTasks.pop_back();
+    }
+
+    // Add the task to the scheduler queue, and return its handle
     // Cycles run at 93.75 * 2 MHz
-    Task task(function, globalCycles + cycles);
-    auto it = std::upper_bound(tasks.cbegin(), tasks.cend(), task);
-    tasks.insert(it, task);
+    tasks[task].function = function;
+    tasks[task].cycles = globalCycles + cycles;
+    tasks[task].order = taskOrder++;
+    queue.push_back(task);
+    siftUp(queue.size() - 1);
+    return task;
+}
+
+void Core::reschedule(int task, uint32_t cycles) {
+    // Move a pending task to a new cycle, as if it was just scheduled
+    tasks[task].cycles = globalCycles + cycles;
+    tasks[task].order = taskOrder++;
+    siftUp(tasks[task].index);
+    siftDown(tasks[task].index);
+}
+
+void Core::cancel(int task) {
+    // Remove a pending task from the scheduler queue
+    removeTask(tasks[task].index);
+}
+
+bool Core::taskBefore(int a, int b) {
+    // Order tasks by cycle, and then by when they were scheduled
+    if (tasks[a].cycles != tasks[b].cycles)
+        return tasks[a].cycles < tasks[b].cycles;
+    return tasks[a].order < tasks[b].order;
+}
+
+void Core::siftUp(size_t i) {
+    // Move a task up the queue heap until its parent comes before it
+    int task = queue[i];
+    while (i > 0 && taskBefore(task, queue[(i - 1) >> 1])) {
+        queue[i] = queue[(i - 1) >> 1];
+        tasks[queue[i]].index = i;
+        i = (i - 1) >> 1;
+    }
+    queue[i] = task;
+    tasks[task].index = i;
+}
+
+void Core::siftDown(size_t i) {
+    // Move a task down the queue heap until both of its children come after it
+    int task = queue[i];
+    while (true) {
+        size_t child = (i << 1) + 1;
+        if (child >= queue.size()) break;
+        if (child + 1 < queue.size() && taskBefore(queue[child + 1], queue[child])) child++;
+        if (!taskBefore(queue[child], task)) break;
+        queue[i] = queue[child];
+        tasks[queue[i]].index = i;
+        i = child;
+    }
+    queue[i] = task;
+    tasks[task].index = i;
+}
+
+void Core::removeTask(size_t i) {
+    // Free the task's handle and fill its spot in the queue heap with the last task
+    freeTasks.push_back(queue[i]);
+    int last = queue.back();
+    queue.pop_back();
+    if (i == queue.size()) return;
+    queue[i] = last;
+    siftUp(i);
+    siftDown(tasks[last].index);
 }
@@ -41,5 +41,8 @@ namespace Core {
 
     void countFrame();
     void writeSave(uint32_t address, uint8_t value);
-    void schedule(void (*function)(), uint32_t cycles);
+    void syncRsp();
+    int schedule(void (*function)(), uint32_t cycles);
+    void reschedule(int task, uint32_t cycles);
+    void cancel(int task);
 }
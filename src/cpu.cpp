@@ -40,10 +40,6 @@ namespace CPU {
     uint32_t nextOpcode;
     uint32_t delaySlot;
 
-    extern void (*immInstrs[])(uint32_t);
-    extern void (*regInstrs[])(uint32_t);
-    extern void (*extInstrs[])(uint32_t);
-
     void j(uint32_t opcode);
     void jal(uint32_t opcode);
     void beq(uint32_t opcode);
@@ -227,6 +223,33 @@ void CPU::runOpcode() {
         delaySlot = -1;
 }
 
+int CPU::branchType(uint32_t opcode) {
+    // Classify an opcode as a regular branch (1), a likely branch (2), or neither (0)
+    switch (opcode >> 26) {
+        case 0x00: // JR, JALR
+            return ((opcode & 0x3E) == 0x08) ? 1 : 0;
+
+        case 0x01: // REGIMM
+            switch ((opcode >> 16) & 0x1F) {
+                case 0x00: case 0x01: case 0x10: case 0x11: return 1;
+                case 0x02: case 0x03: case 0x12: case 0x13: return 2;
+                default: return 0;
+            }
+
+        case 0x11: // BC1F, BC1T, BC1FL, BC1TL
+            return (((opcode >> 21) & 0x1F) == 0x08) ? (((opcode >> 17) & 0x1) + 1) : 0;
+
+        case 0x02: case 0x03: case 0x04: case 0x05: case 0x06: case 0x07:
+            return 1;
+
+        case 0x14: case 0x15: case 0x16: case 0x17:
+            return 2;
+
+        default:
+            return 0;
+    }
+}
+
 void CPU::j(uint32_t opcode) {
     // Jump to an immediate value
     delaySlot = programCounter;
@@ -22,11 +22,18 @@
 #include <cstdint>
 
 namespace CPU {
+    extern uint64_t registersR[33];
     extern uint64_t *registersW[32];
+    extern uint64_t hi, lo;
     extern uint32_t programCounter;
     extern uint32_t nextOpcode;
     extern uint32_t delaySlot;
 
+    extern void (*immInstrs[])(uint32_t);
+    extern void (*regInstrs[])(uint32_t);
+    extern void (*extInstrs[])(uint32_t);
+
     void reset();
     void runOpcode();
+    int branchType(uint32_t opcode);
 }
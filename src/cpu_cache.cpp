@@ -0,0 +1,574 @@
+/*
+    Copyright 2022-2026 Hydr8gon
+
+    This file is part of rokuyon.
+
+    rokuyon is free software: you can redistribute it and/or modify it
+    under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    rokuyon is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with rokuyon. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <cstring>
+
+#include "cpu_cache.h"
+#include "cpu.h"
+#include "memory.h"
+
+#define MAX_OPCODES 0x40000
+#define MAX_BLOCKS 0x10000
+#define BLOCK_SIZE 64
+
+struct CachedOpcode {
+    void (*function)(CachedOpcode &op);
+    void (*handler)(uint32_t);
+    uint64_t *rs;
+    uint64_t *rt;
+    uint64_t *dst;
+    int64_t imm;
+    uint32_t opcode;
+    bool check;
+};
+
+struct CachedBlock {
+    CachedOpcode *opcodes;
+    uint32_t address;
+    uint32_t first;
+    uint32_t size;
+    uint32_t count;
+    int branch;
+};
+
+namespace CPU_CACHE {
+    CachedOpcode opcodes[MAX_OPCODES];
+    CachedBlock blockPool[MAX_BLOCKS];
+    CachedBlock emptyBlock;
+    uint32_t opcodeCount;
+    uint32_t blockCount;
+
+    CachedBlock **blocks[0x1000];
+    bool pageUsed[0x1000];
+
+    uint32_t interpret();
+    void clearBlocks();
+    CachedBlock *compileBlock(uint32_t address);
+    void decode(CachedOpcode &op, uint32_t opcode);
+
+    void call(CachedOpcode &op);
+    void addiu(CachedOpcode &op);
+    void daddiu(CachedOpcode &op);
+    void slti(CachedOpcode &op);
+    void sltiu(CachedOpcode &op);
+    void andi(CachedOpcode &op);
+    void ori(CachedOpcode &op);
+    void xori(CachedOpcode &op);
+    void lui(CachedOpcode &op);
+    void lb(CachedOpcode &op);
+    void lh(CachedOpcode &op);
+    void lw(CachedOpcode &op);
+    void lbu(CachedOpcode &op);
+    void lhu(CachedOpcode &op);
+    void lwu(CachedOpcode &op);
+    void ld(CachedOpcode &op);
+    void sb(CachedOpcode &op);
+    void sh(CachedOpcode &op);
+    void sw(CachedOpcode &op);
+    void sd(CachedOpcode &op);
+    void sll(CachedOpcode &op);
+    void srl(CachedOpcode &op);
+    void sra(CachedOpcode &op);
+    void sllv(CachedOpcode &op);
+    void srlv(CachedOpcode &op);
+    void srav(CachedOpcode &op);
+    void move(CachedOpcode &op);
+    void dsllv(CachedOpcode &op);
+    void dsrlv(CachedOpcode &op);
+    void dsrav(CachedOpcode &op);
+    void addu(CachedOpcode &op);
+    void subu(CachedOpcode &op);
+    void and_(CachedOpcode &op);
+    void or_(CachedOpcode &op);
+    void xor_(CachedOpcode &op);
+    void nor(CachedOpcode &op);
+    void slt(CachedOpcode &op);
+    void sltu(CachedOpcode &op);
+    void daddu(CachedOpcode &op);
+    void dsubu(CachedOpcode &op);
+    void dsll(CachedOpcode &op);
+    void dsrl(CachedOpcode &op);
+    void dsra(CachedOpcode &op);
+}
+
+void CPU_CACHE::reset() {
+    // Start with an empty cache
+    clearBlocks();
+}
+
+uint32_t CPU_CACHE::runBlock() {
+    // Fall back to the interpreter if a block can't start here
+    // Blocks begin on an already-fetched opcode and only cover RDRAM, so they can be invalidated by page
+    uint32_t address = CPU::programCounter;
+    if (CPU::delaySlot != (uint32_t)-1 || !CPU::nextOpcode || (address & 0x3) ||
+        (address & 0xC0000000) != 0x80000000 || (address & 0x1FFFFFFF) >= 0x800000)
+        return interpret();
+
+    // Apply pending invalidations, then look up the block for the current address with kseg0 and kseg1 kept separate
+    Memory::updateCode();
+    uint32_t page = ((address >> 18) & 0x800) | ((address & 0x7FFFFF) >> 12);
+    if (!blocks[page]) blocks[page] = new CachedBlock*[0x400]();
+    CachedBlock *&entry = blocks[page][(address & 0xFFF) >> 2];
+
+    // Decode the block if it doesn't exist yet
+    // The page is tracked first, so writes from other threads during decoding still invalidate it
+    if (!entry) {
+        Memory::trackCode(address);
+        entry = compileBlock(address);
+        pageUsed[page] = true;
+    }
+
+    // Use the interpreter if the block is empty or the pipeline holds a different opcode than memory
+    // The latter can happen after unusual control flow, like a branch in a delay slot
+    CachedBlock *block = entry;
+    if (!block->count || CPU::nextOpcode != block->first)
+        return interpret();
+
+    // Run the opcodes leading up to the end of the block
+    CachedOpcode *op = block->opcodes;
+    for (uint32_t i = 0; i < block->size; i++, op++) {
+        if (op->check) {
+            // Set the program counter as it would be in the pipeline, and stop if an exception changes it
+            uint32_t pc = address + (i << 2) + 4;
+            CPU::programCounter = pc;
+            (*op->function)(*op);
+            if (CPU::programCounter != pc)
+                return i + 1;
+        }
+        else {
+            // Run opcodes that can't cause exceptions directly
+            (*op->function)(*op);
+        }
+    }
+
+    // Exit to the next opcode, fetching it into the pipeline
+    if (!block->branch) {
+        CPU::programCounter = address + (block->size << 2);
+        CPU::nextOpcode = Memory::read<uint32_t>(CPU::programCounter);
+        return block->count;
+    }
+
+    // Call the branch handler with the delay slot opcode in the pipeline
+    CPU::programCounter = address + (block->size << 2) + 4;
+    CPU::nextOpcode = op[1].opcode;
+    (*op->function)(*op);
+
+    // Exit if a CP1 branch triggered an exception instead of branching
+    if (CPU::delaySlot == (uint32_t)-1)
+        return block->size + 1;
+
+    // Move to the delay slot, fetching the opcode after it
+    // Run the delay slot opcode unless a likely branch discarded it
+    bool discard = (block->branch == 2 && !CPU::nextOpcode);
+    CPU::programCounter += 4;
+    CPU::nextOpcode = Memory::read<uint32_t>(CPU::programCounter);
+    if (!discard) (*op[1].function)(op[1]);
+
+    // Clear the delay slot address after it executes
+    CPU::delaySlot = -1;
+    return block->count;
+}
+
+void CPU_CACHE::invalidate(uint32_t pAddr) {
+    // Clear cached blocks in both the kseg0 and kseg1 mirrors of a written RDRAM page
+    // This is only called by Memory::updateCode, so the tables are never changed off the emulator thread
+    uint32_t page = (pAddr >> 12) & 0x7FF;
+    if (pageUsed[page]) {
+        pageUsed[page] = false;
+        memset(blocks[page], 0, 0x400 * sizeof(CachedBlock*));
+    }
+    if (pageUsed[page | 0x800]) {
+        pageUsed[page | 0x800] = false;
+        memset(blocks[page | 0x800], 0, 0x400 * sizeof(CachedBlock*));
+    }
+}
+
+uint32_t CPU_CACHE::interpret() {
+    // Run a single opcode with the interpreter, in place of a block
+    CPU::runOpcode();
+    return 1;
+}
+
+void CPU_CACHE::clearBlocks() {
+    // Remove all blocks and reuse the pools from the start
+    for (int i = 0; i < 0x1000; i++) {
+        if (pageUsed[i]) {
+            pageUsed[i] = false;
+            memset(blocks[i], 0, 0x400 * sizeof(CachedBlock*));
+        }
+    }
+    opcodeCount = 0;
+    blockCount = 0;
+}
+
+CachedBlock *CPU_CACHE::compileBlock(uint32_t address) {
+    // Start fresh if the pools are close to full
+    // Blocks are only freed here, so ones that are invalidated while running stay intact
+    if (opcodeCount > MAX_OPCODES - BLOCK_SIZE - 1 || blockCount == MAX_BLOCKS)
+        clearBlocks();
+
+    // Set up a new block
+    CachedBlock *block = &blockPool[blockCount];
+    block->opcodes = &opcodes[opcodeCount];
+    block->address = address;
+    block->first = Memory::read<uint32_t>(address);
+    block->size = 0;
+    block->branch = 0;
+
+    // Decode opcodes until a branch, a block-ending opcode, or a page boundary
+    for (;; address += 4) {
+        uint32_t opcode = Memory::read<uint32_t>(address);
+
+        if (int branch = CPU::branchType(opcode)) {
+            // Stop before branches whose delay slot can't be decoded alongside them
+            // Idle loops are also left to the interpreter so it can halt the CPU
+            if ((address & 0xFFF) == 0xFFC) break;
+            uint32_t delay = Memory::read<uint32_t>(address + 4);
+            if (CPU::branchType(delay) || (delay >> 21) == 0x210 || (opcode == 0x1000FFFF && !delay))
+                break;
+
+            // Finish the block with the branch and its delay slot
+            decode(block->opcodes[block->size], opcode);
+            decode(block->opcodes[block->size + 1], delay);
+            block->branch = branch;
+            break;
+        }
+
+        // Decode an opcode and move on
+        decode(block->opcodes[block->size++], opcode);
+
+        // End the block after CP0 opcodes, system calls, and breakpoints so events aren't delayed
+        if ((opcode >> 26) == 0x10 || (opcode & 0xFC00003E) == 0xC || block->size == BLOCK_SIZE || !((address + 4) & 0xFFF))
+            break;
+    }
+
+    // Use a shared empty block if nothing could be decoded
+    block->count = block->size + (block->branch ? 2 : 0);
+    if (!block->count)
+        return &emptyBlock;
+
+    // Claim space in the pools
+    opcodeCount += block->count;
+    blockCount++;
+    return block;
+}
+
+void CPU_CACHE::decode(CachedOpcode &op, uint32_t opcode) {
+    // Extract the operands of an opcode, with destinations mapped so writes to r0 are redirected
+    op.rs = &CPU::registersR[(opcode >> 21) & 0x1F];
+    op.rt = &CPU::registersR[(opcode >> 16) & 0x1F];
+    op.dst = CPU::registersW[(opcode >> 11) & 0x1F];
+    op.imm = (int16_t)opcode;
+    op.opcode = opcode;
+    op.check = false;
+
+    // Look up a cached version of simple opcodes, keyed like the interpreter tables
+    // Immediate-type opcodes are keyed by bits 26-31, and register-type by bits 0-5 plus 0x40
+    switch ((opcode >> 26) ? (opcode >> 26) : (0x40 | (opcode & 0x3F))) {
+        case 0x09: op.function = addiu; break;
+        case 0x0A: op.function = slti; break;
+        case 0x0B: op.function = sltiu; break;
+        case 0x0C: op.function = andi; break;
+        case 0x0D: op.function = ori; break;
+        case 0x0E: op.function = xori; break;
+        case 0x0F: op.function = lui; break;
+        case 0x19: op.function = daddiu; break;
+        case 0x20: op.function = lb; break;
+        case 0x21: op.function = lh; break;
+        case 0x23: op.function = lw; break;
+        case 0x24: op.function = lbu; break;
+        case 0x25: op.function = lhu; break;
+        case 0x27: op.function = lwu; break;
+        case 0x28: op.function = sb; break;
+        case 0x29: op.function = sh; break;
+        case 0x2B: op.function = sw; break;
+        case 0x37: op.function = ld; break;
+        case 0x3F: op.function = sd; break;
+        case 0x40: op.function = sll; break;
+        case 0x42: op.function = srl; break;
+        case 0x43: op.function = sra; break;
+        case 0x44: op.function = sllv; break;
+        case 0x46: op.function = srlv; break;
+        case 0x47: op.function = srav; break;
+        case 0x50: op.function = move; op.rs = &CPU::hi; break; // MFHI
+        case 0x51: op.function = move; op.dst = &CPU::hi; break; // MTHI
+        case 0x52: op.function = move; op.rs = &CPU::lo; break; // MFLO
+        case 0x53: op.function = move; op.dst = &CPU::lo; break; // MTLO
+        case 0x54: op.function = dsllv; break;
+        case 0x56: op.function = dsrlv; break;
+        case 0x57: op.function = dsrav; break;
+        case 0x61: op.function = addu; break;
+        case 0x63: op.function = subu; break;
+        case 0x64: op.function = and_; break;
+        case 0x65: op.function = or_; break;
+        case 0x66: op.function = xor_; break;
+        case 0x67: op.function = nor; break;
+        case 0x6A: op.function = slt; break;
+        case 0x6B: op.function = sltu; break;
+        case 0x6D: op.function = daddu; break;
+        case 0x6F: op.function = dsubu; break;
+        case 0x78: op.function = dsll; break;
+        case 0x7A: op.function = dsrl; break;
+        case 0x7B: op.function = dsra; break;
+        case 0x7C: op.function = dsll; break; // DSLL32
+        case 0x7E: op.function = dsrl; break; // DSRL32
+        case 0x7F: op.function = dsra; break; // DSRA32
+
+        default:
+            // Fall back to the interpreter handler for everything else
+            op.function = call;
+            op.check = true;
+            switch (opcode >> 26) {
+                default: op.handler = CPU::immInstrs[opcode >> 26]; break;
+                case 0: op.handler = CPU::regInstrs[opcode & 0x3F]; break;
+                case 1: op.handler = CPU::extInstrs[(opcode >> 16) & 0x1F]; break;
+            }
+            return;
+    }
+
+    // Adjust operands based on the opcode type
+    if (opcode >> 26) {
+        // Immediate-type opcodes write to RT, and some use a zero-extended immediate
+        op.dst = CPU::registersW[(opcode >> 16) & 0x1F];
+        if ((opcode >> 26) >= 0x0C && (opcode >> 26) <= 0x0E)
+            op.imm = opcode & 0xFFFF;
+
+        // Loads and stores can cause exceptions
+        op.check = ((opcode >> 26) >= 0x20);
+    }
+    else if ((opcode & 0x3C) == 0x00 || (opcode & 0x38) == 0x38) {
+        // Shifts by an immediate add the shift amount to any base value
+        op.imm = (((opcode & 0x3F) >= 0x3C) ? 32 : 0) + ((opcode >> 6) & 0x1F);
+    }
+}
+
+void CPU_CACHE::call(CachedOpcode &op) {
+    // Run an opcode with its interpreter handler
+    (*op.handler)(op.opcode);
+}
+
+void CPU_CACHE::addiu(CachedOpcode &op) {
+    // Add a signed 16-bit immediate to a register and store the lower result
+    *op.dst = (int32_t)(*op.rs + op.imm);
+}
+
+void CPU_CACHE::daddiu(CachedOpcode &op) {
+    // Add a signed 16-bit immediate to a register and store the result
+    *op.dst = *op.rs + op.imm;
+}
+
+void CPU_CACHE::slti(CachedOpcode &op) {
+    // Check if a signed register is less than a signed 16-bit immediate, and store the result
+    *op.dst = (int64_t)*op.rs < op.imm;
+}
+
+void CPU_CACHE::sltiu(CachedOpcode &op) {
+    // Check if a register is less than a signed 16-bit immediate, and store the result
+    *op.dst = *op.rs < (uint64_t)op.imm;
+}
+
+void CPU_CACHE::andi(CachedOpcode &op) {
+    // Bitwise and a register with a 16-bit immediate and store the result
+    *op.dst = *op.rs & op.imm;
+}
+
+void CPU_CACHE::ori(CachedOpcode &op) {
+    // Bitwise or a register with a 16-bit immediate and store the result
+    *op.dst = *op.rs | op.imm;
+}
+
+void CPU_CACHE::xori(CachedOpcode &op) {
+    // Bitwise exclusive or a register with a 16-bit immediate and store the result
+    *op.dst = *op.rs ^ op.imm;
+}
+
+void CPU_CACHE::lui(CachedOpcode &op) {
+    // Load a 16-bit immediate into the upper 16 bits of a register
+    *op.dst = (int32_t)(op.opcode << 16);
+}
+
+void CPU_CACHE::lb(CachedOpcode &op) {
+    // Load a signed byte from memory at base register plus immeditate offset
+    *op.dst = (int8_t)Memory::read<uint8_t>(*op.rs + op.imm);
+}
+
+void CPU_CACHE::lh(CachedOpcode &op) {
+    // Load a signed half-word from memory at base register plus immeditate offset
+    *op.dst = (int16_t)Memory::read<uint16_t>(*op.rs + op.imm);
+}
+
+void CPU_CACHE::lw(CachedOpcode &op) {
+    // Load a signed word from memory at base register plus immeditate offset
+    *op.dst = (int32_t)Memory::read<uint32_t>(*op.rs + op.imm);
+}
+
+void CPU_CACHE::lbu(CachedOpcode &op) {
+    // Load a byte from memory at base register plus immeditate offset
+    *op.dst = Memory::read<uint8_t>(*op.rs + op.imm);
+}
+
+void CPU_CACHE::lhu(CachedOpcode &op) {
+    // Load a half-word from memory at base register plus immeditate offset
+    *op.dst = Memory::read<uint16_t>(*op.rs + op.imm);
+}
+
+void CPU_CACHE::lwu(CachedOpcode &op) {
+    // Load a word from memory at base register plus immeditate offset
+    *op.dst = Memory::read<uint32_t>(*op.rs + op.imm);
+}
+
+void CPU_CACHE::ld(CachedOpcode &op) {
+    // Load a double-word from memory at base register plus immeditate offset
+    *op.dst = Memory::read<uint64_t>(*op.rs + op.imm);
+}
+
+void CPU_CACHE::sb(CachedOpcode &op) {
+    // Store a byte to memory at base register plus immeditate offset
+    Memory::write<uint8_t>(*op.rs + op.imm, *op.rt);
+}
+
+void CPU_CACHE::sh(CachedOpcode &op) {
+    // Store a half-word to memory at base register plus immeditate offset
+    Memory::write<uint16_t>(*op.rs + op.imm, *op.rt);
+}
+
+void CPU_CACHE::sw(CachedOpcode &op) {
+    // Store a word to memory at base register plus immeditate offset
+    Memory::write<uint32_t>(*op.rs + op.imm, *op.rt);
+}
+
+void CPU_CACHE::sd(CachedOpcode &op) {
+    // Store a double-word to memory at base register plus immeditate offset
+    Memory::write<uint64_t>(*op.rs + op.imm, *op.rt);
+}
+
+void CPU_CACHE::sll(CachedOpcode &op) {
+    // Shift a register left by a 5-bit immediate and store the lower result
+    *op.dst = (int32_t)(*op.rt << op.imm);
+}
+
+void CPU_CACHE::srl(CachedOpcode &op) {
+    // Shift a register right by a 5-bit immediate and store the lower result
+    *op.dst = (int32_t)((uint32_t)*op.rt >> op.imm);
+}
+
+void CPU_CACHE::sra(CachedOpcode &op) {
+    // Shift a register right by a 5-bit immediate and store the lower signed result
+    *op.dst = (int32_t)((int64_t)*op.rt >> op.imm);
+}
+
+void CPU_CACHE::sllv(CachedOpcode &op) {
+    // Shift a register left by a register and store the lower result
+    *op.dst = (int32_t)(*op.rt << (*op.rs & 0x1F));
+}
+
+void CPU_CACHE::srlv(CachedOpcode &op) {
+    // Shift a register right by a register and store the lower result
+    *op.dst = (int32_t)((uint32_t)*op.rt >> (*op.rs & 0x1F));
+}
+
+void CPU_CACHE::srav(CachedOpcode &op) {
+    // Shift a register right by a register and store the lower signed result
+    *op.dst = (int32_t)((int64_t)*op.rt >> (*op.rs & 0x1F));
+}
+
+void CPU_CACHE::move(CachedOpcode &op) {
+    // Copy a value between a register and the high or low word of the mult/div result
+    *op.dst = *op.rs;
+}
+
+void CPU_CACHE::dsllv(CachedOpcode &op) {
+    // Shift a register left by a register and store the result
+    *op.dst = *op.rt << (*op.rs & 0x3F);
+}
+
+void CPU_CACHE::dsrlv(CachedOpcode &op) {
+    // Shift a register right by a register and store the result
+    *op.dst = *op.rt >> (*op.rs & 0x3F);
+}
+
+void CPU_CACHE::dsrav(CachedOpcode &op) {
+    // Shift a register right by a register and store the signed result
+    *op.dst = (int64_t)*op.rt >> (*op.rs & 0x3F);
+}
+
+void CPU_CACHE::addu(CachedOpcode &op) {
+    // Add a register to a register and store the lower result
+    *op.dst = (int32_t)(*op.rs + *op.rt);
+}
+
+void CPU_CACHE::subu(CachedOpcode &op) {
+    // Subtract a register from a register and store the lower result
+    *op.dst = (int32_t)(*op.rs - *op.rt);
+}
+
+void CPU_CACHE::and_(CachedOpcode &op) {
+    // Bitwise and a register with a register and store the result
+    *op.dst = *op.rs & *op.rt;
+}
+
+void CPU_CACHE::or_(CachedOpcode &op) {
+    // Bitwise or a register with a register and store the result
+    *op.dst = *op.rs | *op.rt;
+}
+
+void CPU_CACHE::xor_(CachedOpcode &op) {
+    // Bitwise exclusive or a register with a register and store the result
+    *op.dst = *op.rs ^ *op.rt;
+}
+
+void CPU_CACHE::nor(CachedOpcode &op) {
+    // Bitwise or a register with a register and store the negated result
+    *op.dst = ~(*op.rs | *op.rt);
+}
+
+void CPU_CACHE::slt(CachedOpcode &op) {
+    // Check if a signed register is less than another signed register, and store the result
+    *op.dst = (int64_t)*op.rs < (int64_t)*op.rt;
+}
+
+void CPU_CACHE::sltu(CachedOpcode &op) {
+    // Check if a register is less than another register, and store the result
+    *op.dst = *op.rs < *op.rt;
+}
+
+void CPU_CACHE::daddu(CachedOpcode &op) {
+    // Add a register to a register and store the result
+    *op.dst = *op.rs + *op.rt;
+}
+
+void CPU_CACHE::dsubu(CachedOpcode &op) {
+    // Subtract a register from a register and store the result
+    *op.dst = *op.rs - *op.rt;
+}
+
+void CPU_CACHE::dsll(CachedOpcode &op) {
+    // Shift a register left by an immediate and store the result
+    *op.dst = *op.rt << op.imm;
+}
+
+void CPU_CACHE::dsrl(CachedOpcode &op) {
+    // Shift a register right by an immediate and store the result
+    *op.dst = *op.rt >> op.imm;
+}
+
+void CPU_CACHE::dsra(CachedOpcode &op) {
+    // Shift a register right by an immediate and store the signed result
+    *op.dst = (int64_t)*op.rt >> op.imm;
+}
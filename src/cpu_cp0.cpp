@@ -42,7 +42,7 @@ namespace CPU_CP0 {
 
     bool irqPending;
     uint32_t startCycles;
-    uint32_t endCycles;
+    int countTask;
 
     void scheduleCount();
     void updateCount();
@@ -83,7 +83,7 @@ void CPU_CP0::reset() {
     epc = 0;
     errorEpc = 0;
     irqPending = false;
-    endCycles = -1;
+    countTask = -1;
     scheduleCount();
 }
 
@@ -233,37 +233,33 @@ void CPU_CP0::write(int index, int32_t value) {
 void CPU_CP0::resetCycles() {
     // Adjust the cycle counts for a cycle reset
     startCycles -= Core::globalCycles;
-    endCycles -= Core::globalCycles;
 }
 
 void CPU_CP0::scheduleCount() {
     // Assuming count is updated, schedule its next update
     // This is done as close to match as possible, with a limit to prevent cycle overflow
     startCycles = Core::globalCycles;
-    uint32_t cycles = startCycles + std::min<uint32_t>((compare - count) << 2, 0x40000000);
-    cycles += (startCycles == cycles) << 2;
-
-    // Only reschedule if the update is sooner than what's already scheduled
-    // This helps prevent overloading the scheduler when registers are used excessively
-    if (endCycles > cycles) {
-        Core::schedule(updateCount, cycles - startCycles);
-        endCycles = cycles;
-    }
+    uint32_t cycles = std::min<uint32_t>((compare - count) << 2, 0x40000000);
+    cycles += (cycles == 0) << 2;
+
+    // Move the pending update if there is one, so only one is ever in the scheduler
+    if (countTask != -1)
+        Core::reschedule(countTask, cycles);
+    else
+        countTask = Core::schedule(updateCount, cycles);
 }
 
 void CPU_CP0::updateCount() {
-    // Ignore the update if it was rescheduled
-    if (Core::globalCycles != endCycles)
-        return;
+    // Release the handle of the update that just ran
+    countTask = -1;
 
     // Update count and request a timer interrupt if it matches compare
-    if ((count += ((endCycles - startCycles) >> 2)) == compare) {
+    if ((count += ((Core::globalCycles - startCycles) >> 2)) == compare) {
         cause |= 0x8000;
         checkInterrupts();
     }
 
-    // Schedule the next update unconditionally
-    endCycles = -1;
+    // Schedule the next update
     scheduleCount();
 }
 
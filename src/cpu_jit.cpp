@@ -0,0 +1,702 @@
+/*
+    Copyright 2022-2026 Hydr8gon
+
+    This file is part of rokuyon.
+
+    rokuyon is free software: you can redistribute it and/or modify it
+    under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    rokuyon is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with rokuyon. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <cstring>
+
+#include "cpu_jit.h"
+#include "cpu.h"
+#include "log.h"
+#include "memory.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#define CODE_SIZE 0x1000000
+#define BLOCK_SIZE 64
+
+typedef uint32_t (*Block)();
+typedef void (*Instr)(uint32_t);
+
+namespace CPU_JIT {
+    uint8_t *codeBuffer;
+    uint8_t *codePtr;
+    uint8_t *epilogue;
+
+    Block *blocks[0x1000];
+    bool pageUsed[0x1000];
+
+    uint32_t interpret();
+    void fetchNext();
+    void clearBlocks();
+    Block compileBlock(uint32_t address);
+
+    Instr getInstr(uint32_t opcode);
+    bool compileAlu(uint32_t opcode);
+    void compileCall(uint32_t opcode, uint32_t address, uint32_t count);
+    void compileBranch(uint32_t opcode, uint32_t delay, uint32_t address, uint32_t count);
+    void compileExit(uint32_t count);
+
+    void emit8(uint8_t value);
+    void emit32(uint32_t value);
+    void emit64(uint64_t value);
+    void emitMem(uint8_t rex, uint8_t op, uint8_t reg, void *ptr);
+    void emitLoad(uint8_t reg, void *ptr);
+    void emitStore(void *ptr);
+    void emitStoreImm(void *ptr, uint32_t value);
+    void emitCmpImm(void *ptr, uint32_t value);
+    void emitCall(uintptr_t function, uint32_t arg);
+    void emitImm(uint8_t op, uint32_t value);
+    void emitReg(uint8_t op);
+    void emitShift(bool wide, uint8_t ext, int amount);
+    void emitSet(uint8_t cond);
+    void emitExtend();
+}
+
+void CPU_JIT::reset() {
+    // Allocate executable memory for compiled code on first use
+    if (!codeBuffer) {
+#ifdef _WIN32
+        codeBuffer = (uint8_t*)VirtualAlloc(nullptr, CODE_SIZE, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
+#else
+        void *buffer = mmap(nullptr, CODE_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        codeBuffer = (buffer != MAP_FAILED) ? (uint8_t*)buffer : nullptr;
+#endif
+        if (!codeBuffer)
+            LOG_WARN("Failed to allocate JIT memory; falling back to the interpreter\n");
+    }
+
+    // Start with an empty code buffer
+    clearBlocks();
+}
+
+uint32_t CPU_JIT::runBlock() {
+    // Fall back to the interpreter if a block can't start here
+    // Blocks begin on an already-fetched opcode and only cover RDRAM, so they can be invalidated by page
+    uint32_t address = CPU::programCounter;
+    if (!codeBuffer || CPU::delaySlot != (uint32_t)-1 || !CPU::nextOpcode || (address & 0x3) ||
+        (address & 0xC0000000) != 0x80000000 || (address & 0x1FFFFFFF) >= 0x800000)
+        return interpret();
+
+    // Apply pending invalidations, then look up the block for the current address with kseg0 and kseg1 kept separate
+    Memory::updateCode();
+    uint32_t page = ((address >> 18) & 0x800) | ((address & 0x7FFFFF) >> 12);
+    if (!blocks[page]) blocks[page] = new Block[0x400]();
+    Block &block = blocks[page][(address & 0xFFF) >> 2];
+
+    // Compile the block if it doesn't exist yet, and run it
+    // The page is tracked first, so writes from other threads during compiling still invalidate it
+    if (!block) {
+        Memory::trackCode(address);
+        block = compileBlock(address);
+        pageUsed[page] = true;
+    }
+    if (uint32_t count = (*block)())
+        return count;
+    return interpret();
+}
+
+void CPU_JIT::invalidate(uint32_t pAddr) {
+    // Clear compiled blocks in both the kseg0 and kseg1 mirrors of a written RDRAM page
+    // This is only called by Memory::updateCode, so the tables are never changed off the emulator thread
+    uint32_t page = (pAddr >> 12) & 0x7FF;
+    if (pageUsed[page]) {
+        pageUsed[page] = false;
+        memset(blocks[page], 0, 0x400 * sizeof(Block));
+    }
+    if (pageUsed[page | 0x800]) {
+        pageUsed[page | 0x800] = false;
+        memset(blocks[page | 0x800], 0, 0x400 * sizeof(Block));
+    }
+}
+
+uint32_t CPU_JIT::interpret() {
+    // Run a single opcode with the interpreter, in place of a block
+    CPU::runOpcode();
+    return 1;
+}
+
+void CPU_JIT::fetchNext() {
+    // Fetch the next opcode into the pipeline, as the interpreter would before executing
+    CPU::nextOpcode = Memory::read<uint32_t>(CPU::programCounter);
+}
+
+void CPU_JIT::clearBlocks() {
+    // Remove all blocks and reuse the code buffer from the start
+    for (int i = 0; i < 0x1000; i++) {
+        if (pageUsed[i]) {
+            pageUsed[i] = false;
+            memset(blocks[i], 0, 0x400 * sizeof(Block));
+        }
+    }
+    codePtr = codeBuffer;
+}
+
+Block CPU_JIT::compileBlock(uint32_t address) {
+    // Start fresh if the code buffer is close to full
+    if (codePtr - codeBuffer > CODE_SIZE - 0x10000)
+        clearBlocks();
+
+    // Emit an epilogue for exits to jump back to
+    uint8_t *start = codePtr;
+    epilogue = codePtr;
+    emit32(0x20C48348); // add rsp,32
+    emit8(0x5B); // pop rbx
+    emit8(0xC3); // ret
+
+    // Emit a prologue that keeps the CPU register base in RBX, with shadow space for calls
+    Block block = (Block)codePtr;
+    emit8(0x53); // push rbx
+    emit32(0x20EC8348); // sub rsp,32
+    emit8(0x48); // mov rbx,registersR
+    emit8(0xBB);
+    emit64((uintptr_t)CPU::registersR);
+
+    // Exit without running anything if the pipeline holds a different opcode than memory
+    // This can happen after unusual control flow, like a branch in a delay slot
+    emitCmpImm(&CPU::nextOpcode, Memory::read<uint32_t>(address));
+    emit8(0x74); // je over the exit
+    emit8(10);
+    compileExit(0);
+
+    // Compile opcodes until a branch, a block-ending opcode, or a page boundary
+    uint32_t count = 0;
+    for (;; address += 4) {
+        uint32_t opcode = Memory::read<uint32_t>(address);
+
+        if (CPU::branchType(opcode)) {
+            // Stop before branches whose delay slot can't be compiled alongside them
+            // Idle loops are also left to the interpreter so it can halt the CPU
+            if ((address & 0xFFF) == 0xFFC) break;
+            uint32_t delay = Memory::read<uint32_t>(address + 4);
+            if (CPU::branchType(delay) || (delay >> 21) == 0x210 || (opcode == 0x1000FFFF && !delay))
+                break;
+
+            // Finish the block with the branch and its delay slot
+            compileBranch(opcode, delay, address, count);
+            return block;
+        }
+
+        // Emit an opcode inline if possible, or fall back to its interpreter handler
+        if (!compileAlu(opcode))
+            compileCall(opcode, address, count);
+        count++;
+
+        // End the block after CP0 opcodes, system calls, and breakpoints so events aren't delayed
+        if ((opcode >> 26) == 0x10 || (opcode & 0xFC00003E) == 0xC || count == BLOCK_SIZE || !((address + 4) & 0xFFF)) {
+            address += 4;
+            break;
+        }
+    }
+
+    // Discard the block and use the interpreter if nothing could be compiled
+    if (!count) {
+        codePtr = start;
+        return interpret;
+    }
+
+    // Exit to the next opcode, fetching it into the pipeline
+    emitStoreImm(&CPU::programCounter, address);
+    emitCall((uintptr_t)fetchNext, 0);
+    compileExit(count);
+    return block;
+}
+
+Instr CPU_JIT::getInstr(uint32_t opcode) {
+    // Look up the interpreter handler for an opcode
+    switch (opcode >> 26) {
+        default: return CPU::immInstrs[opcode >> 26];
+        case 0: return CPU::regInstrs[opcode & 0x3F];
+        case 1: return CPU::extInstrs[(opcode >> 16) & 0x1F];
+    }
+}
+
+bool CPU_JIT::compileAlu(uint32_t opcode) {
+    // Get the operands of the opcode
+    uint64_t *rs = &CPU::registersR[(opcode >> 21) & 0x1F];
+    uint64_t *rt = &CPU::registersR[(opcode >> 16) & 0x1F];
+    uint64_t *rd = &CPU::registersR[(opcode >> 11) & 0x1F];
+    uint8_t sa = (opcode >> 6) & 0x1F;
+    uint8_t *start = codePtr;
+    uint64_t *dest;
+
+    // Emit simple opcodes that can't cause exceptions, calculating the result in RAX
+    // Immediate-type opcodes are keyed by bits 26-31, and register-type by bits 0-5 plus 0x40
+    switch ((opcode >> 26) ? (opcode >> 26) : (0x40 | (opcode & 0x3F))) {
+        case 0x09: // ADDIU
+            emitLoad(0, rs);
+            emitImm(0x05, (int16_t)opcode);
+            emitExtend();
+            dest = rt;
+            break;
+
+        case 0x0A: // SLTI
+            emitLoad(0, rs);
+            emitImm(0x3D, (int16_t)opcode);
+            emitSet(0x9C);
+            dest = rt;
+            break;
+
+        case 0x0B: // SLTIU
+            emitLoad(0, rs);
+            emitImm(0x3D, (int16_t)opcode);
+            emitSet(0x92);
+            dest = rt;
+            break;
+
+        case 0x0C: // ANDI
+            emitLoad(0, rs);
+            emitImm(0x25, opcode & 0xFFFF);
+            dest = rt;
+            break;
+
+        case 0x0D: // ORI
+            emitLoad(0, rs);
+            emitImm(0x0D, opcode & 0xFFFF);
+            dest = rt;
+            break;
+
+        case 0x0E: // XORI
+            emitLoad(0, rs);
+            emitImm(0x35, opcode & 0xFFFF);
+            dest = rt;
+            break;
+
+        case 0x0F: // LUI
+            emit8(0x48); // mov rax,imm
+            emit8(0xC7);
+            emit8(0xC0);
+            emit32(opcode << 16);
+            dest = rt;
+            break;
+
+        case 0x19: // DADDIU
+            emitLoad(0, rs);
+            emitImm(0x05, (int16_t)opcode);
+            dest = rt;
+            break;
+
+        case 0x40: // SLL
+            emitLoad(0, rt);
+            emitShift(false, 4, sa);
+            emitExtend();
+            dest = rd;
+            break;
+
+        case 0x42: // SRL
+            emitLoad(0, rt);
+            emitShift(false, 5, sa);
+            emitExtend();
+            dest = rd;
+            break;
+
+        case 0x43: // SRA
+            emitLoad(0, rt);
+            emitShift(true, 7, sa);
+            emitExtend();
+            dest = rd;
+            break;
+
+        case 0x44: // SLLV
+            emitLoad(1, rs);
+            emitLoad(0, rt);
+            emitShift(false, 4, -1);
+            emitExtend();
+            dest = rd;
+            break;
+
+        case 0x46: // SRLV
+            emitLoad(1, rs);
+            emitLoad(0, rt);
+            emitShift(false, 5, -1);
+            emitExtend();
+            dest = rd;
+            break;
+
+        case 0x47: // SRAV
+            emitLoad(1, rs);
+            emit8(0x83); // and ecx,0x1F
+            emit8(0xE1);
+            emit8(0x1F);
+            emitLoad(0, rt);
+            emitShift(true, 7, -1);
+            emitExtend();
+            dest = rd;
+            break;
+
+        case 0x50: // MFHI
+            emitLoad(0, &CPU::hi);
+            dest = rd;
+            break;
+
+        case 0x51: // MTHI
+            emitLoad(0, rs);
+            dest = &CPU::hi;
+            break;
+
+        case 0x52: // MFLO
+            emitLoad(0, &CPU::lo);
+            dest = rd;
+            break;
+
+        case 0x53: // MTLO
+            emitLoad(0, rs);
+            dest = &CPU::lo;
+            break;
+
+        case 0x54: // DSLLV
+            emitLoad(1, rs);
+            emitLoad(0, rt);
+            emitShift(true, 4, -1);
+            dest = rd;
+            break;
+
+        case 0x56: // DSRLV
+            emitLoad(1, rs);
+            emitLoad(0, rt);
+            emitShift(true, 5, -1);
+            dest = rd;
+            break;
+
+        case 0x57: // DSRAV
+            emitLoad(1, rs);
+            emitLoad(0, rt);
+            emitShift(true, 7, -1);
+            dest = rd;
+            break;
+
+        case 0x61: // ADDU
+            emitLoad(0, rs);
+            emitLoad(1, rt);
+            emitReg(0x01);
+            emitExtend();
+            dest = rd;
+            break;
+
+        case 0x63: // SUBU
+            emitLoad(0, rs);
+            emitLoad(1, rt);
+            emitReg(0x29);
+            emitExtend();
+            dest = rd;
+            break;
+
+        case 0x64: // AND
+            emitLoad(0, rs);
+            emitLoad(1, rt);
+            emitReg(0x21);
+            dest = rd;
+            break;
+
+        case 0x65: // OR
+            emitLoad(0, rs);
+            emitLoad(1, rt);
+            emitReg(0x09);
+            dest = rd;
+            break;
+
+        case 0x66: // XOR
+            emitLoad(0, rs);
+            emitLoad(1, rt);
+            emitReg(0x31);
+            dest = rd;
+            break;
+
+        case 0x67: // NOR
+            emitLoad(0, rs);
+            emitLoad(1, rt);
+            emitReg(0x09);
+            emit8(0x48); // not rax
+            emit8(0xF7);
+            emit8(0xD0);
+            dest = rd;
+            break;
+
+        case 0x6A: // SLT
+            emitLoad(0, rs);
+            emitLoad(1, rt);
+            emitReg(0x39);
+            emitSet(0x9C);
+            dest = rd;
+            break;
+
+        case 0x6B: // SLTU
+            emitLoad(0, rs);
+            emitLoad(1, rt);
+            emitReg(0x39);
+            emitSet(0x92);
+            dest = rd;
+            break;
+
+        case 0x6D: // DADDU
+            emitLoad(0, rs);
+            emitLoad(1, rt);
+            emitReg(0x01);
+            dest = rd;
+            break;
+
+        case 0x6F: // DSUBU
+            emitLoad(0, rs);
+            emitLoad(1, rt);
+            emitReg(0x29);
+            dest = rd;
+            break;
+
+        case 0x78: // DSLL
+            emitLoad(0, rt);
+            emitShift(true, 4, sa);
+            dest = rd;
+            break;
+
+        case 0x7A: // DSRL
+            emitLoad(0, rt);
+            emitShift(true, 5, sa);
+            dest = rd;
+            break;
+
+        case 0x7B: // DSRA
+            emitLoad(0, rt);
+            emitShift(true, 7, sa);
+            dest = rd;
+            break;
+
+        case 0x7C: // DSLL32
+            emitLoad(0, rt);
+            emitShift(true, 4, sa + 32);
+            dest = rd;
+            break;
+
+        case 0x7E: // DSRL32
+            emitLoad(0, rt);
+            emitShift(true, 5, sa + 32);
+            dest = rd;
+            break;
+
+        case 0x7F: // DSRA32
+            emitLoad(0, rt);
+            emitShift(true, 7, sa + 32);
+            dest = rd;
+            break;
+
+        default:
+            return false;
+    }
+
+    // Store the result, or discard the opcode entirely if it writes to r0
+    if (dest == &CPU::registersR[0])
+        codePtr = start;
+    else
+        emitStore(dest);
+    return true;
+}
+
+void CPU_JIT::compileCall(uint32_t opcode, uint32_t address, uint32_t count) {
+    // Call an interpreter handler with the program counter set as it would be in the pipeline
+    emitStoreImm(&CPU::programCounter, address + 4);
+    emitCall((uintptr_t)getInstr(opcode), opcode);
+
+    // Exit the block if the program counter changed, which means an exception or return occurred
+    emitCmpImm(&CPU::programCounter, address + 4);
+    emit8(0x74); // je over the exit
+    emit8(10);
+    compileExit(count + 1);
+}
+
+void CPU_JIT::compileBranch(uint32_t opcode, uint32_t delay, uint32_t address, uint32_t count) {
+    // Call the branch handler with the delay slot opcode in the pipeline
+    emitStoreImm(&CPU::programCounter, address + 4);
+    emitStoreImm(&CPU::nextOpcode, delay);
+    emitCall((uintptr_t)getInstr(opcode), opcode);
+
+    // Exit the block if a CP1 branch triggered an exception instead of branching
+    if ((opcode >> 26) == 0x11) {
+        emitCmpImm(&CPU::delaySlot, -1);
+        emit8(0x75); // jne over the exit
+        emit8(10);
+        compileExit(count + 1);
+    }
+
+    // Check if a likely branch discarded its delay slot opcode
+    uint8_t *discard = nullptr;
+    if (CPU::branchType(opcode) == 2 && delay) {
+        emitCmpImm(&CPU::nextOpcode, 0);
+        emit8(0x0F); // je discard
+        emit8(0x84);
+        discard = codePtr;
+        emit32(0);
+    }
+
+    // Move to the delay slot, fetching the opcode after it, and run the delay slot opcode
+    emitMem(0, 0x83, 0, &CPU::programCounter); // add [programCounter],4
+    emit8(4);
+    emitCall((uintptr_t)fetchNext, 0);
+    if (delay && !compileAlu(delay))
+        emitCall((uintptr_t)getInstr(delay), delay);
+
+    if (discard) {
+        // Skip over the discard path
+        emit8(0xE9); // jmp done
+        uint8_t *done = codePtr;
+        emit32(0);
+
+        // Move past the discarded delay slot without running it
+        *(uint32_t*)discard = codePtr - (discard + 4);
+        emitMem(0, 0x83, 0, &CPU::programCounter); // add [programCounter],4
+        emit8(4);
+        emitCall((uintptr_t)fetchNext, 0);
+        *(uint32_t*)done = codePtr - (done + 4);
+    }
+
+    // Clear the delay slot address after it executes and exit the block
+    emitStoreImm(&CPU::delaySlot, -1);
+    compileExit(count + 2);
+}
+
+void CPU_JIT::compileExit(uint32_t count) {
+    // Return the number of opcodes run through the epilogue (always 10 bytes)
+    emit8(0xB8); // mov eax,count
+    emit32(count);
+    emit8(0xE9); // jmp epilogue
+    emit32(epilogue - (codePtr + 4));
+}
+
+void CPU_JIT::emit8(uint8_t value) {
+    // Write a byte to the code buffer
+    *codePtr++ = value;
+}
+
+void CPU_JIT::emit32(uint32_t value) {
+    // Write a little-endian word to the code buffer
+    memcpy(codePtr, &value, sizeof(value));
+    codePtr += sizeof(value);
+}
+
+void CPU_JIT::emit64(uint64_t value) {
+    // Write a little-endian double word to the code buffer
+    memcpy(codePtr, &value, sizeof(value));
+    codePtr += sizeof(value);
+}
+
+void CPU_JIT::emitMem(uint8_t rex, uint8_t op, uint8_t reg, void *ptr) {
+    // Emit an opcode that addresses CPU state relative to the register base in RBX
+    if (rex) emit8(rex);
+    emit8(op);
+    emit8(0x83 | (reg << 3));
+    emit32((uint8_t*)ptr - (uint8_t*)CPU::registersR);
+}
+
+void CPU_JIT::emitLoad(uint8_t reg, void *ptr) {
+    // Load a 64-bit value into RAX (0) or RCX (1)
+    emitMem(0x48, 0x8B, reg, ptr);
+}
+
+void CPU_JIT::emitStore(void *ptr) {
+    // Store a 64-bit value from RAX
+    emitMem(0x48, 0x89, 0, ptr);
+}
+
+void CPU_JIT::emitStoreImm(void *ptr, uint32_t value) {
+    // Store a 32-bit immediate
+    emitMem(0, 0xC7, 0, ptr);
+    emit32(value);
+}
+
+void CPU_JIT::emitCmpImm(void *ptr, uint32_t value) {
+    // Compare a 32-bit value with an immediate
+    emitMem(0, 0x81, 7, ptr);
+    emit32(value);
+}
+
+void CPU_JIT::emitCall(uintptr_t function, uint32_t arg) {
+    // Pass an argument in the first parameter register for the host ABI
+#ifdef _WIN32
+    emit8(0xB9); // mov ecx,arg
+#else
+    emit8(0xBF); // mov edi,arg
+#endif
+    emit32(arg);
+
+    // Call a function through RAX
+    emit8(0x48); // mov rax,function
+    emit8(0xB8);
+    emit64(function);
+    emit8(0xFF); // call rax
+    emit8(0xD0);
+}
+
+void CPU_JIT::emitImm(uint8_t op, uint32_t value) {
+    // Emit a 64-bit ALU opcode on RAX with a sign-extended 32-bit immediate
+    emit8(0x48);
+    emit8(op);
+    emit32(value);
+}
+
+void CPU_JIT::emitReg(uint8_t op) {
+    // Emit a 64-bit ALU opcode on RAX with RCX
+    emit8(0x48);
+    emit8(op);
+    emit8(0xC8);
+}
+
+void CPU_JIT::emitShift(bool wide, uint8_t ext, int amount) {
+    // Emit a 32-bit or 64-bit shift on RAX, by an immediate or by CL if negative
+    if (wide) emit8(0x48);
+    emit8((amount < 0) ? 0xD3 : 0xC1);
+    emit8(0xC0 | (ext << 3));
+    if (amount >= 0) emit8(amount);
+}
+
+void CPU_JIT::emitSet(uint8_t cond) {
+    // Set RAX to 1 or 0 based on a condition from the last comparison
+    emit8(0x0F); // setcc al
+    emit8(cond);
+    emit8(0xC0);
+    emit8(0x0F); // movzx eax,al
+    emit8(0xB6);
+    emit8(0xC0);
+}
+
+void CPU_JIT::emitExtend() {
+    // Sign-extend the lower 32 bits of RAX
+    emit8(0x48); // movsxd rax,eax
+    emit8(0x63);
+    emit8(0xC0);
+}
+
+#else
+
+void CPU_JIT::reset() {
+    // The JIT is only available on x86-64 hosts
+}
+
+uint32_t CPU_JIT::runBlock() {
+    // Fall back to the interpreter on hosts without JIT support
+    CPU::runOpcode();
+    return 1;
+}
+
+void CPU_JIT::invalidate(uint32_t pAddr) {
+    // There are no compiled blocks to invalidate
+}
+
+#endif
@@ -76,13 +76,14 @@ void ryCanvas::draw(wxPaintEvent &event) {
     glClear(GL_COLOR_BUFFER_BIT);
 
     if (Core::running || frame->isPaused()) {
-        // At the swap interval, get the framebuffer as a texture
+        // At the swap interval, get the framebuffer as a texture, or show the previous one again
         if (++frameCount >= swapInterval) {
-            if (_Framebuffer *fb = VI::getFramebuffer()) {
+            _Framebuffer *fb = VI::getFramebuffer();
+            VI::frameShown(fb != nullptr);
+            if (fb) {
                 glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, fb->width,
                     fb->height, 0, GL_RGBA, GL_UNSIGNED_BYTE, fb->data);
                 frameCount = 0;
-                delete fb;
             }
         }
 
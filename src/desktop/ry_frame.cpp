@@ -35,8 +35,22 @@ enum FrameEvent {
     INPUT_BINDINGS,
     FPS_LIMITER,
     EXPANSION_PAK,
+    CACHED_INTERP,
+    CPU_JIT,
+    RSP_JIT,
+    GFX_HLE,
+    AUDIO_HLE,
+    SYNC_EXACT,
+    SYNC_SHORT,
+    SYNC_LONG,
+    THREADED_RSP,
     THREADED_RDP,
+    PARALLEL_RDP,
     TEX_FILTER,
+    AUDIO_NEAREST,
+    AUDIO_LINEAR,
+    AUDIO_CUBIC,
+    AUDIO_SINC,
     UPDATE_JOY
 };
 
@@ -50,8 +64,22 @@ EVT_MENU(STOP, ryFrame::stop)
 EVT_MENU(INPUT_BINDINGS, ryFrame::inputSettings)
 EVT_MENU(FPS_LIMITER, ryFrame::toggleFpsLimit)
 EVT_MENU(EXPANSION_PAK, ryFrame::toggleExpanPak)
+EVT_MENU(CACHED_INTERP, ryFrame::toggleCacheInt)
+EVT_MENU(CPU_JIT, ryFrame::toggleCpuJit)
+EVT_MENU(RSP_JIT, ryFrame::toggleRspJit)
+EVT_MENU(GFX_HLE, ryFrame::toggleGfxHle)
+EVT_MENU(AUDIO_HLE, ryFrame::toggleAudioHle)
+EVT_MENU(SYNC_EXACT, ryFrame::setSyncQuantum)
+EVT_MENU(SYNC_SHORT, ryFrame::setSyncQuantum)
+EVT_MENU(SYNC_LONG, ryFrame::setSyncQuantum)
+EVT_MENU(THREADED_RSP, ryFrame::toggleThreadRsp)
 EVT_MENU(THREADED_RDP, ryFrame::toggleThreadRdp)
+EVT_MENU(PARALLEL_RDP, ryFrame::toggleParallelRdp)
 EVT_MENU(TEX_FILTER, ryFrame::toggleTexFilter)
+EVT_MENU(AUDIO_NEAREST, ryFrame::setResampler)
+EVT_MENU(AUDIO_LINEAR, ryFrame::setResampler)
+EVT_MENU(AUDIO_CUBIC, ryFrame::setResampler)
+EVT_MENU(AUDIO_SINC, ryFrame::setResampler)
 EVT_TIMER(UPDATE_JOY, ryFrame::updateJoystick)
 EVT_DROP_FILES(ryFrame::dropFiles)
 EVT_CLOSE(ryFrame::close)
@@ -72,6 +100,19 @@ ryFrame::ryFrame(std::string path): wxFrame(nullptr, wxID_ANY, "rokuyon") {
     systemMenu->Append(STOP, "&Stop");
     updateMenu();
 
+    // Set up the CPU/RSP sync submenu
+    wxMenu *syncMenu = new wxMenu();
+    syncMenu->AppendRadioItem(SYNC_EXACT, "&Exact");
+    syncMenu->AppendRadioItem(SYNC_SHORT, "&Short Batches");
+    syncMenu->AppendRadioItem(SYNC_LONG, "&Long Batches");
+
+    // Set up the audio resampler submenu
+    wxMenu *audioMenu = new wxMenu();
+    audioMenu->AppendRadioItem(AUDIO_NEAREST, "&Nearest");
+    audioMenu->AppendRadioItem(AUDIO_LINEAR, "&Linear");
+    audioMenu->AppendRadioItem(AUDIO_CUBIC, "&Cubic");
+    audioMenu->AppendRadioItem(AUDIO_SINC, "&Sinc");
+
     // Set up the settings menu
     wxMenu *settingsMenu = new wxMenu();
     settingsMenu->Append(INPUT_BINDINGS, "&Input Bindings");
@@ -79,14 +120,32 @@ ryFrame::ryFrame(std::string path): wxFrame(nullptr, wxID_ANY, "rokuyon") {
     settingsMenu->AppendCheckItem(FPS_LIMITER, "&FPS Limiter");
     settingsMenu->AppendCheckItem(EXPANSION_PAK, "&Expansion Pak");
     settingsMenu->AppendSeparator();
+    settingsMenu->AppendCheckItem(CACHED_INTERP, "&Cached Interpreter");
+    settingsMenu->AppendCheckItem(CPU_JIT, "&CPU JIT");
+    settingsMenu->AppendCheckItem(RSP_JIT, "RSP &JIT");
+    settingsMenu->AppendCheckItem(GFX_HLE, "Graphics &HLE");
+    settingsMenu->AppendCheckItem(AUDIO_HLE, "&Audio HLE");
+    settingsMenu->AppendSubMenu(syncMenu, "CPU/RSP &Sync");
+    settingsMenu->AppendCheckItem(THREADED_RSP, "Threaded &RSP");
     settingsMenu->AppendCheckItem(THREADED_RDP, "&Threaded RDP");
+    settingsMenu->AppendCheckItem(PARALLEL_RDP, "&Parallel RDP");
     settingsMenu->AppendCheckItem(TEX_FILTER, "&Texture Filter");
+    settingsMenu->AppendSubMenu(audioMenu, "Audio Res&ampler");
 
     // Set the initial checkbox states
     settingsMenu->Check(FPS_LIMITER, Settings::fpsLimiter);
     settingsMenu->Check(EXPANSION_PAK, Settings::expansionPak);
+    settingsMenu->Check(CACHED_INTERP, Settings::cachedInterp);
+    settingsMenu->Check(CPU_JIT, Settings::cpuJit);
+    settingsMenu->Check(RSP_JIT, Settings::rspJit);
+    settingsMenu->Check(GFX_HLE, Settings::gfxHle);
+    settingsMenu->Check(AUDIO_HLE, Settings::audioHle);
+    settingsMenu->Check((Settings::syncQuantum >= 1536) ? SYNC_LONG : (Settings::syncQuantum ? SYNC_SHORT : SYNC_EXACT), true);
+    settingsMenu->Check(THREADED_RSP, Settings::threadedRsp);
     settingsMenu->Check(THREADED_RDP, Settings::threadedRdp);
+    settingsMenu->Check(PARALLEL_RDP, Settings::parallelRdp);
     settingsMenu->Check(TEX_FILTER, Settings::texFilter);
+    settingsMenu->Check((Settings::audioResampler & ~0x3) ? AUDIO_LINEAR : (AUDIO_NEAREST + Settings::audioResampler), true);
 
     // Set up the menu bar
     wxMenuBar *menuBar = new wxMenuBar();
@@ -297,18 +356,76 @@ void ryFrame::toggleExpanPak(wxCommandEvent &event) {
     Settings::save();
 }
 
+void ryFrame::toggleCacheInt(wxCommandEvent &event) {
+    // Toggle the cached interpreter setting
+    Settings::cachedInterp = !Settings::cachedInterp;
+    Settings::save();
+}
+
+void ryFrame::toggleCpuJit(wxCommandEvent &event) {
+    // Toggle the CPU JIT setting
+    Settings::cpuJit = !Settings::cpuJit;
+    Settings::save();
+}
+
+void ryFrame::toggleRspJit(wxCommandEvent &event) {
+    // Toggle the RSP JIT setting
+    Settings::rspJit = !Settings::rspJit;
+    Settings::save();
+}
+
+void ryFrame::toggleGfxHle(wxCommandEvent &event) {
+    // Toggle the graphics HLE setting
+    Settings::gfxHle = !Settings::gfxHle;
+    Settings::save();
+}
+
+void ryFrame::toggleAudioHle(wxCommandEvent &event) {
+    // Toggle the audio HLE setting
+    Settings::audioHle = !Settings::audioHle;
+    Settings::save();
+}
+
+void ryFrame::setSyncQuantum(wxCommandEvent &event) {
+    // Set how many cycles the CPU and RSP can run in a batch before syncing, or 0 to interleave opcodes
+    switch (event.GetId()) {
+        case SYNC_EXACT: Settings::syncQuantum = 0; break;
+        case SYNC_SHORT: Settings::syncQuantum = 192; break;
+        case SYNC_LONG: Settings::syncQuantum = 1536; break;
+    }
+    Settings::save();
+}
+
+void ryFrame::toggleThreadRsp(wxCommandEvent &event) {
+    // Toggle the threaded RSP setting
+    Settings::threadedRsp = !Settings::threadedRsp;
+    Settings::save();
+}
+
 void ryFrame::toggleThreadRdp(wxCommandEvent &event) {
     // Toggle the threaded RDP setting
     Settings::threadedRdp = !Settings::threadedRdp;
     Settings::save();
 }
 
+void ryFrame::toggleParallelRdp(wxCommandEvent &event) {
+    // Toggle the parallel RDP setting
+    Settings::parallelRdp = !Settings::parallelRdp;
+    Settings::save();
+}
+
 void ryFrame::toggleTexFilter(wxCommandEvent &event) {
     // Toggle the texture filter setting
     Settings::texFilter = !Settings::texFilter;
     Settings::save();
 }
 
+void ryFrame::setResampler(wxCommandEvent &event) {
+    // Set the filter used to resample audio to the output rate
+    Settings::audioResampler = event.GetId() - AUDIO_NEAREST;
+    Settings::save();
+}
+
 void ryFrame::updateJoystick(wxTimerEvent &event) {
     // Check the status of mapped joystick inputs
     int stickX = 0, stickY = 0;
@@ -62,8 +62,17 @@ private:
     void inputSettings(wxCommandEvent &event);
     void toggleFpsLimit(wxCommandEvent &event);
     void toggleExpanPak(wxCommandEvent &event);
+    void toggleCacheInt(wxCommandEvent &event);
+    void toggleCpuJit(wxCommandEvent &event);
+    void toggleRspJit(wxCommandEvent &event);
+    void toggleGfxHle(wxCommandEvent &event);
+    void toggleAudioHle(wxCommandEvent &event);
+    void setSyncQuantum(wxCommandEvent &event);
+    void toggleThreadRsp(wxCommandEvent &event);
     void toggleThreadRdp(wxCommandEvent &event);
+    void toggleParallelRdp(wxCommandEvent &event);
     void toggleTexFilter(wxCommandEvent &event);
+    void setResampler(wxCommandEvent &event);
     void updateJoystick(wxTimerEvent &event);
     void dropFiles(wxDropFilesEvent &event);
     void close(wxCloseEvent &event);
@@ -18,18 +18,23 @@
 */
 
 #include <algorithm>
+#include <atomic>
 #include <cstring>
+#include <vector>
 
 #include "memory.h"
 #include "ai.h"
 #include "core.h"
+#include "cpu_cache.h"
 #include "cpu_cp0.h"
+#include "cpu_jit.h"
 #include "log.h"
 #include "mi.h"
 #include "pi.h"
 #include "pif.h"
 #include "rdp.h"
 #include "rsp.h"
+#include "rsp_jit.h"
 #include "rsp_cp0.h"
 #include "settings.h"
 #include "si.h"
@@ -50,19 +55,42 @@ struct TLBEntry {
     uint32_t pageMask;
 };
 
+struct DmaRange {
+    uint8_t *data;
+    uint32_t offset;
+    uint32_t size;
+    bool swizzled;
+};
+
 namespace Memory {
+    // RDRAM, RSP memory and ROM are stored in host-endian words, so narrower accesses are swizzled
     uint8_t rdram[0x800000]; // 8MB RDRAM
     uint8_t rspMem[0x2000]; // 4KB RSP DMEM + 4KB RSP IMEM
     TLBEntry entries[32];
     uint32_t ramSize;
 
+    uint8_t *readMap[0x100000];
+    uint8_t *writeMap[0x100000];
+    std::vector<uint32_t> tlbPages;
+    std::atomic<bool> codePages[0x800];
+    std::atomic<uint32_t> dirtyPages[0x800 / 32];
+    std::atomic<bool> dirty;
+
     uint8_t writeBuf[0x80];
     uint64_t status;
     uint32_t writeOfs;
     uint32_t eraseOfs;
     FlashState state;
 
+    uint8_t *getPage(uint32_t pAddr, bool write);
+    bool getDmaRange(uint32_t address, bool write, DmaRange &range);
+    void copyRange(DmaRange &dst, DmaRange &src, uint32_t size);
+    void mapPage(uint32_t pAddr);
+    void mapTlb();
     void writeFlash(uint32_t value);
+
+    template <typename T> T readHost(uint8_t *mem, uint32_t offset);
+    template <typename T> void writeHost(uint8_t *mem, uint32_t offset, T value);
 }
 
 void Memory::reset() {
@@ -75,9 +103,216 @@ void Memory::reset() {
     eraseOfs = 0;
     state = FLASH_NONE;
 
+    // Clear code tracking and any invalidations that were still pending
+    for (int i = 0; i < 0x800; i++)
+        codePages[i] = false;
+    for (int i = 0; i < 0x800 / 32; i++)
+        dirtyPages[i] = 0;
+    dirty = false;
+
     // Map TLB entries to inaccessible locations
     for (int i = 0; i < 32; i++)
         entries[i].entryHi = 0x80000000;
+
+    // Build the fast lookup tables, with only the kseg0 and kseg1 mirrors mapped at first
+    memset(readMap, 0, sizeof(readMap));
+    memset(writeMap, 0, sizeof(writeMap));
+    tlbPages.clear();
+    for (uint32_t pAddr = 0; pAddr < 0x20000000; pAddr += 0x1000)
+        mapPage(pAddr);
+}
+
+uint8_t *Memory::getPage(uint32_t pAddr, bool write) {
+    // Get a host pointer to a physical page if it can be accessed directly, or null if it needs the slow path
+    // RDRAM pages with cached code and RSP IMEM are left out for writes, so the slow path can invalidate them
+    if (pAddr < ramSize)
+        return (write && codePages[pAddr >> 12]) ? nullptr : &rdram[pAddr];
+    else if (pAddr >= 0x4000000 && pAddr < 0x4040000)
+        return (write && (pAddr & 0x1000)) ? nullptr : &rspMem[pAddr & 0x1000];
+    else if (!write && pAddr >= 0x10000000 && pAddr - 0x10000000 + 0x1000 <= std::min(Core::romSize, 0xFC00000U))
+        return &Core::rom[pAddr - 0x10000000];
+    return nullptr;
+}
+
+void Memory::mapPage(uint32_t pAddr) {
+    // Update the kseg0 and kseg1 mirrors of a physical page in the fast lookup tables
+    uint32_t index = (pAddr & 0x1FFFFFFF) >> 12;
+    readMap[0x80000 | index] = readMap[0xA0000 | index] = getPage(index << 12, false);
+    writeMap[0x80000 | index] = writeMap[0xA0000 | index] = getPage(index << 12, true);
+}
+
+void Memory::mapTlb() {
+    // Clear the previous TLB mappings from the fast lookup tables
+    for (size_t i = 0; i < tlbPages.size(); i++)
+        readMap[tlbPages[i]] = writeMap[tlbPages[i]] = nullptr;
+    tlbPages.clear();
+
+    // Map the pages of each TLB entry, in reverse so lower entries take priority like in the slow path
+    for (int i = 31; i >= 0; i--) {
+        uint32_t vAddr = entries[i].entryHi & 0xFFFFE000;
+        uint32_t mask = entries[i].pageMask | 0x1FFF;
+
+        for (uint32_t offset = 0; offset <= mask; offset += 0x1000) {
+            // Skip addresses in kseg0 and kseg1, since they never use the TLB
+            uint32_t address = vAddr + offset;
+            if ((address & 0xC0000000) == 0x80000000)
+                continue;
+
+            // Choose between the even or odd physical pages, and only allow writes if the page is dirty
+            uint32_t entryLo = (offset <= (mask >> 1)) ? entries[i].entryLo0 : entries[i].entryLo1;
+            uint32_t pAddr = ((entryLo & 0x3FFFFC0) << 6) + (address & (mask >> 1));
+            readMap[address >> 12] = getPage(pAddr, false);
+            writeMap[address >> 12] = (entryLo & 0x4) ? getPage(pAddr, true) : nullptr;
+            tlbPages.push_back(address >> 12);
+        }
+    }
+}
+
+void Memory::trackCode(uint32_t pAddr) {
+    // Mark an RDRAM page as having cached code, so writes to it go through the slow path
+    uint32_t page = (pAddr >> 12) & 0x7FF;
+    if (codePages[page]) return;
+    codePages[page] = true;
+    mapPage(page << 12);
+    if (!tlbPages.empty()) mapTlb();
+}
+
+void Memory::invalidate(uint32_t pAddr) {
+    // Mark an RDRAM page with cached code as written, so the emulator thread can invalidate it later
+    // This can be called from the RSP and RDP threads, so it must not touch the code or lookup tables
+    // The fence orders the caller's write before the check, pairing with the store in trackCode
+    uint32_t page = (pAddr >> 12) & 0x7FF;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!codePages[page]) return;
+    dirtyPages[page >> 5].fetch_or(1 << (page & 0x1F), std::memory_order_release);
+    dirty = true;
+}
+
+void Memory::updateCode() {
+    // Invalidate code cached from RDRAM pages that were written since the last update
+    // This runs on the emulator thread before each block lookup, since it owns all of the tables
+    if (!dirty) return;
+    dirty = false;
+    bool remap = false;
+
+    for (uint32_t i = 0; i < 0x800 / 32; i++) {
+        uint32_t bits = dirtyPages[i].exchange(0, std::memory_order_acquire);
+        for (uint32_t page = i << 5; bits; page++, bits >>= 1) {
+            // Let writes to each page use the fast path again, until code is cached from it again
+            if (!(bits & 0x1) || !codePages[page]) continue;
+            codePages[page] = false;
+            CPU_CACHE::invalidate(page << 12);
+            CPU_JIT::invalidate(page << 12);
+            mapPage(page << 12);
+            remap = true;
+        }
+    }
+
+    // Update the TLB mappings once for all of the pages
+    if (remap && !tlbPages.empty())
+        mapTlb();
+}
+
+uint8_t *Memory::getRdram(uint32_t pAddr, uint32_t size) {
+    // Get a host pointer to a range of RDRAM if it's in bounds and has no cached code to invalidate
+    // The data is stored in host-endian words, so narrower accesses must be swizzled by the caller
+    if (!size || pAddr >= ramSize || size > ramSize - pAddr) return nullptr;
+    for (uint32_t page = pAddr >> 12; page <= (pAddr + size - 1) >> 12; page++)
+        if (codePages[page]) return nullptr;
+    return &rdram[pAddr];
+}
+
+bool Memory::getDmaRange(uint32_t address, bool write, DmaRange &range) {
+    // Resolve a kseg0 or kseg1 address to a block of host memory that a DMA can access in bulk
+    // Anything with side effects beyond code invalidation or PIF commands is left to the slow path
+    if ((address & 0xC0000000) != 0x80000000) return false;
+    uint32_t pAddr = address & 0x1FFFFFFF;
+    uint32_t romEnd = 0x10000000 + std::min(Core::romSize, 0xFC00000U);
+
+    if (pAddr < ramSize) { // RDRAM
+        range = { rdram, pAddr, ramSize - pAddr, true };
+    }
+    else if (pAddr >= 0x4000000 && pAddr < 0x4040000) { // RSP DMEM/IMEM
+        range = { rspMem, pAddr & 0x1FFF, 0x2000 - (pAddr & 0x1FFF), true };
+    }
+    else if (!write && pAddr >= 0x10000000 && pAddr < romEnd) { // Cart ROM
+        range = { Core::rom, pAddr - 0x10000000, romEnd - pAddr, true };
+    }
+    else if (pAddr >= (write ? 0x1FC007C0 : 0x1FC00000) && pAddr < 0x1FC00800) { // PIF ROM/RAM
+        range = { PIF::memory, pAddr & 0x7FF, 0x800 - (pAddr & 0x7FF), false };
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+void Memory::copyRange(DmaRange &dst, DmaRange &src, uint32_t size) {
+    // Copy bytes between blocks of host memory, handling word order in bulk where alignment allows
+    uint8_t *d = &dst.data[dst.offset];
+    uint8_t *s = &src.data[src.offset];
+    uint32_t i = 0;
+
+    if (dst.swizzled && src.swizzled && !(dst.offset & 0x3)) {
+        if (!(src.offset & 0x3)) {
+            // Copy whole words directly when both ends share the same alignment
+            memcpy(d, s, size & ~0x3);
+            i = size & ~0x3;
+        }
+        else if (size >= 8) {
+            // Build each destination word from the two source words it straddles
+            uint32_t shift = (src.offset & 0x3) * 8;
+            const uint8_t *w = s - (src.offset & 0x3);
+            for (; i + 8 <= size; i += 4) {
+                uint32_t hi, lo;
+                memcpy(&hi, &w[i], 4);
+                memcpy(&lo, &w[i + 4], 4);
+                uint32_t value = (hi << shift) | (lo >> (32 - shift));
+                memcpy(&d[i], &value, 4);
+            }
+        }
+    }
+    else if (dst.swizzled != src.swizzled && !(dst.offset & 0x3) && !(src.offset & 0x3)) {
+        // Byte-swap whole words between host-endian and big-endian memory
+        for (; i + 4 <= size; i += 4) {
+            uint32_t value;
+            memcpy(&value, &s[i], 4);
+            value = (value << 24) | ((value << 8) & 0xFF0000) | ((value >> 8) & 0xFF00) | (value >> 24);
+            memcpy(&d[i], &value, 4);
+        }
+    }
+
+    // Copy any remaining bytes one at a time, swizzling addresses in host-endian memory
+    for (; i < size; i++) {
+        uint32_t dOfs = (dst.offset + i) ^ (dst.swizzled ? 3 : 0);
+        uint32_t sOfs = (src.offset + i) ^ (src.swizzled ? 3 : 0);
+        dst.data[dOfs] = src.data[sOfs];
+    }
+}
+
+uint32_t Memory::copyDma(uint32_t dstAddr, uint32_t srcAddr, uint32_t size) {
+    // Resolve both ends of a DMA once, returning 0 so the caller can use the slow path if either fails
+    DmaRange dst, src;
+    if (!size || !getDmaRange(dstAddr, true, dst) || !getDmaRange(srcAddr, false, src))
+        return 0;
+
+    // Clip the transfer to the end of either block, leaving the rest for another call
+    size = std::min(size, std::min(dst.size, src.size));
+
+    // Copy the data, and invalidate any cached code that was overwritten
+    copyRange(dst, src, size);
+    if (dst.data == rdram) {
+        for (uint32_t page = dst.offset >> 12; page <= (dst.offset + size - 1) >> 12; page++)
+            invalidate(page << 12);
+    }
+    else if (dst.data == rspMem && dst.offset + size > 0x1000) {
+        RSP_JIT::invalidate();
+    }
+
+    // Call the PIF if its command byte was written
+    if (dst.data == PIF::memory && dst.offset + size == 0x800)
+        PIF::runCommand();
+    return size;
 }
 
 void Memory::getEntry(uint32_t index, uint32_t &entryLo0, uint32_t &entryLo1, uint32_t &entryHi, uint32_t &pageMask) {
@@ -96,6 +331,77 @@ void Memory::setEntry(uint32_t index, uint32_t entryLo0, uint32_t entryLo1, uint
     entry.entryLo1 = entryLo1;
     entry.entryHi = entryHi;
     entry.pageMask = pageMask;
+
+    // Rebuild the TLB mappings in the fast lookup tables
+    mapTlb();
+}
+
+template <typename T> T Memory::readHost(uint8_t *mem, uint32_t offset) {
+    // Read a misaligned value byte by byte, swizzling each address within its word
+    if (offset & (sizeof(T) - 1)) {
+        T value = 0;
+        for (size_t i = 0; i < sizeof(T); i++)
+            value |= (T)mem[(offset + i) ^ 3] << ((sizeof(T) - 1 - i) * 8);
+        return value;
+    }
+
+    // Read an aligned value natively, swizzling narrower values and combining words for wider ones
+    switch (sizeof(T)) {
+    case sizeof(uint8_t):
+        return mem[offset ^ 3];
+
+    case sizeof(uint16_t): {
+        uint16_t value;
+        memcpy(&value, &mem[offset ^ 2], sizeof(value));
+        return value;
+    }
+
+    case sizeof(uint32_t): {
+        uint32_t value;
+        memcpy(&value, &mem[offset], sizeof(value));
+        return value;
+    }
+
+    default: {
+        uint32_t value[2];
+        memcpy(value, &mem[offset], sizeof(value));
+        return ((uint64_t)value[0] << 32) | value[1];
+    }
+    }
+}
+
+template <typename T> void Memory::writeHost(uint8_t *mem, uint32_t offset, T value) {
+    // Write a misaligned value byte by byte, swizzling each address within its word
+    if (offset & (sizeof(T) - 1)) {
+        for (size_t i = 0; i < sizeof(T); i++)
+            mem[(offset + i) ^ 3] = value >> ((sizeof(T) - 1 - i) * 8);
+        return;
+    }
+
+    // Write an aligned value natively, swizzling narrower values and splitting wider ones into words
+    switch (sizeof(T)) {
+    case sizeof(uint8_t):
+        mem[offset ^ 3] = value;
+        return;
+
+    case sizeof(uint16_t): {
+        uint16_t data = value;
+        memcpy(&mem[offset ^ 2], &data, sizeof(data));
+        return;
+    }
+
+    case sizeof(uint32_t): {
+        uint32_t data = value;
+        memcpy(&mem[offset], &data, sizeof(data));
+        return;
+    }
+
+    default: {
+        uint32_t data[2] = { (uint32_t)((uint64_t)value >> 32), (uint32_t)value };
+        memcpy(&mem[offset], data, sizeof(data));
+        return;
+    }
+    }
 }
 
 template uint8_t Memory::read(uint32_t address);
@@ -103,9 +409,14 @@ template uint16_t Memory::read(uint32_t address);
 template uint32_t Memory::read(uint32_t address);
 template uint64_t Memory::read(uint32_t address);
 template <typename T> T Memory::read(uint32_t address) {
-    uint8_t *data = nullptr;
+    uint8_t *data = readMap[address >> 12];
     uint32_t pAddr = 0x80000000;
 
+    // Access directly mapped pages with a single lookup, leaving I/O and misaligned addresses to the slow path
+    if (data && !(address & (sizeof(T) - 1)))
+        return readHost<T>(data, address & 0xFFF);
+    data = nullptr;
+
     // Get a physical address from a virtual one
     if ((address & 0xC0000000) == 0x80000000) { // kseg0, kseg1
         // Mask the virtual address to get a physical one
@@ -137,15 +448,17 @@ template <typename T> T Memory::read(uint32_t address) {
 lookup:
     // Look up the physical address
     if (pAddr < ramSize) {
-        // Get a pointer to data in RDRAM
+        // Read a value from RDRAM
         // TODO: figure out RDRAM registers and how they affect mapping
-        data = &rdram[pAddr];
+        return readHost<T>(rdram, pAddr);
     }
     else if (pAddr >= 0x4000000 && pAddr < 0x4040000) {
-        // Read a value from RSP DMEM/IMEM, with wraparound
+        // Read a value from RSP DMEM/IMEM, with wraparound if it's misaligned
+        if (!(pAddr & (sizeof(T) - 1)))
+            return readHost<T>(rspMem, pAddr & 0x1FFF);
         T value = 0;
         for (size_t i = 0; i < sizeof(T); i++)
-            value |= (T)rspMem[(pAddr & 0x1000) | ((pAddr + i) & 0xFFF)] << ((sizeof(T) - 1 - i) * 8);
+            value |= (T)rspMem[((pAddr & 0x1000) | ((pAddr + i) & 0xFFF)) ^ 3] << ((sizeof(T) - 1 - i) * 8);
         return value;
     }
     else if (pAddr >= 0x8000000 && pAddr < 0x8008000 && Core::saveSize == 0x8000) {
@@ -160,8 +473,8 @@ lookup:
             return status >> ((~(address + sizeof(T) - 1) & 0x7) * 8);
     }
     else if (pAddr >= 0x10000000 && pAddr < 0x10000000 + std::min(Core::romSize, 0xFC00000U)) {
-        // Get a pointer to data in cart ROM
-        data = &Core::rom[pAddr - 0x10000000];
+        // Read a value from cart ROM
+        return readHost<T>(Core::rom, pAddr - 0x10000000);
     }
     else if (pAddr >= 0x1FC00000 && pAddr < 0x1FC00800) {
         // Get a pointer to data in PIF ROM/RAM
@@ -171,11 +484,13 @@ lookup:
         // Ignore I/O writes that aren't 32-bit
     }
     else if (pAddr >= 0x4040000 && pAddr < 0x4040020) {
-        // Read a value from an RSP CP0 register
+        // Read a value from an RSP CP0 register, after syncing with the RSP thread
+        Core::syncRsp();
         return RSP_CP0::read((pAddr & 0x1F) >> 2);
     }
     else if (pAddr == 0x4080000) {
-        // Read a value from the RSP program counter
+        // Read a value from the RSP program counter, after syncing with the RSP thread
+        Core::syncRsp();
         return RSP::readPC();
     }
     else if (pAddr >= 0x4100000 && pAddr < 0x4100020) {
@@ -214,9 +529,14 @@ template void Memory::write(uint32_t address, uint16_t value);
 template void Memory::write(uint32_t address, uint32_t value);
 template void Memory::write(uint32_t address, uint64_t value);
 template <typename T> void Memory::write(uint32_t address, T value) {
-    uint8_t *data = nullptr;
+    uint8_t *data = writeMap[address >> 12];
     uint32_t pAddr = 0x80000000;
 
+    // Access directly mapped pages with a single lookup, leaving I/O and misaligned addresses to the slow path
+    if (data && !(address & (sizeof(T) - 1)))
+        return writeHost<T>(data, address & 0xFFF, value);
+    data = nullptr;
+
     // Get a physical address from a virtual one
     if ((address & 0xC0000000) == 0x80000000) { // kseg0, kseg1
         // Mask the virtual address to get a physical one
@@ -260,14 +580,21 @@ template <typename T> void Memory::write(uint32_t address, T value) {
 lookup:
     // Look up the physical address
     if (pAddr < ramSize) {
-        // Get a pointer to data in RDRAM
+        // Write a value to RDRAM, and invalidate any code cached from it
+        // The write happens first, so the data is visible to the emulator thread once it sees the page
         // TODO: figure out RDRAM registers and how they affect mapping
-        data = &rdram[pAddr];
+        writeHost<T>(rdram, pAddr, value);
+        return invalidate(pAddr);
     }
     else if (pAddr >= 0x4000000 && pAddr < 0x4040000) {
-        // Write a value to RSP DMEM/IMEM, with wraparound
+        // Write a value to RSP DMEM/IMEM, with wraparound if it's misaligned
+        // IMEM writes invalidate compiled RSP code, which is looked up again by content
+        if (pAddr & 0x1000)
+            RSP_JIT::invalidate();
+        if (!(pAddr & (sizeof(T) - 1)))
+            return writeHost<T>(rspMem, pAddr & 0x1FFF, value);
         for (size_t i = 0; i < sizeof(T); i++)
-            rspMem[(pAddr & 0x1000) | ((pAddr + i) & 0xFFF)] = value >> ((sizeof(T) - 1 - i) * 8);
+            rspMem[((pAddr & 0x1000) | ((pAddr + i) & 0xFFF)) ^ 3] = value >> ((sizeof(T) - 1 - i) * 8);
         return;
     }
     else if (pAddr >= 0x8000000 && pAddr < 0x8008000 && Core::saveSize == 0x8000) {
@@ -296,11 +623,13 @@ lookup:
         // Ignore I/O writes that aren't 32-bit
     }
     else if (pAddr >= 0x4040000 && pAddr < 0x4040020) {
-        // Write a value to an RSP CP0 register
+        // Write a value to an RSP CP0 register, after syncing with the RSP thread
+        Core::syncRsp();
         return RSP_CP0::write((pAddr & 0x1F) >> 2, value);
     }
     else if (pAddr == 0x4080000) {
-        // Write a value to the RSP program counter
+        // Write a value to the RSP program counter, after syncing with the RSP thread
+        Core::syncRsp();
         return RSP::writePC(value);
     }
     else if (pAddr >= 0x4100000 && pAddr < 0x4100020) {
@@ -22,9 +22,16 @@
 #include <cstdint>
 
 namespace Memory {
+    extern uint8_t rspMem[0x2000];
+
     void reset();
     void getEntry(uint32_t index, uint32_t &entryLo0, uint32_t &entryLo1, uint32_t &entryHi, uint32_t &pageMask);
     void setEntry(uint32_t index, uint32_t  entryLo0, uint32_t  entryLo1, uint32_t  entryHi, uint32_t  pageMask);
+    void trackCode(uint32_t pAddr);
+    void invalidate(uint32_t pAddr);
+    void updateCode();
+    uint8_t *getRdram(uint32_t pAddr, uint32_t size);
+    uint32_t copyDma(uint32_t dstAddr, uint32_t srcAddr, uint32_t size);
 
     template <typename T> T read(uint32_t address);
     template <typename T> void write(uint32_t address, T value);
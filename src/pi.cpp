@@ -86,11 +86,15 @@ void PI::write(uint32_t address, uint32_t value) {
 void PI::performReadDma(uint32_t size) {
     LOG_INFO("PI DMA from cart 0x%X to RDRAM 0x%X with size 0x%X\n", cartAddr, dramAddr, size);
 
-    // Copy data from the PI bus to memory
-    // TODO: check bounds
-    for (uint32_t i = 0; i < size; i++) {
+    // Copy data from the PI bus to memory, in bulk where possible and byte by byte otherwise
+    for (uint32_t i = 0; i < size;) {
+        if (uint32_t count = Memory::copyDma(0x80000000 + dramAddr + i, 0x80000000 + cartAddr + i, size - i)) {
+            i += count;
+            continue;
+        }
         uint8_t value = Memory::read<uint8_t>(0x80000000 + cartAddr + i);
         Memory::write<uint8_t>(0x80000000 + dramAddr + i, value);
+        i++;
     }
 
     // Request a PI interrupt when the DMA finishes
@@ -101,11 +105,15 @@ void PI::performReadDma(uint32_t size) {
 void PI::performWriteDma(uint32_t size) {
     LOG_INFO("PI DMA from RDRAM 0x%X to cart 0x%X with size 0x%X\n", dramAddr, cartAddr, size);
 
-    // Copy data from memory to the PI bus
-    // TODO: check bounds
-    for (uint32_t i = 0; i < size; i++) {
+    // Copy data from memory to the PI bus, in bulk where possible and byte by byte otherwise
+    for (uint32_t i = 0; i < size;) {
+        if (uint32_t count = Memory::copyDma(0x80000000 + cartAddr + i, 0x80000000 + dramAddr + i, size - i)) {
+            i += count;
+            continue;
+        }
         uint8_t value = Memory::read<uint8_t>(0x80000000 + dramAddr + i);
         Memory::write<uint8_t>(0x80000000 + cartAddr + i, value);
+        i++;
     }
 
     // Request a PI interrupt when the DMA finishes
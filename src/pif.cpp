@@ -52,10 +52,10 @@ void (*PIF::pifCommands[7])(int) = {
 };
 
 uint32_t PIF::crc32(uint8_t *data, size_t size) {
-    // Calculate a CRC32 value for the given data
+    // Calculate a CRC32 value for the given data, stored in host-endian words
     uint32_t r = 0xFFFFFFFF;
     for (size_t i = 0; i < size; i++) {
-        r ^= data[i];
+        r ^= data[i ^ 3];
         for (int j = 0; j < 8; j++) {
             uint32_t t = ~((r & 1) - 1);
             r = (r >> 1) ^ (0xEDB88320 & t);
@@ -153,8 +153,8 @@ void PIF::reset() {
         *CPU::registersW[31] = 0xFFFFFFFFA4001554;
 
         // Copy the IPL3 from ROM to DMEM and jump to the start address
-        for (uint32_t i = 0; i < 0x1000; i++)
-            Memory::write(0xA4000000 + i, Core::rom[i]);
+        for (uint32_t i = 0; i < 0x1000; i += 4)
+            Memory::write<uint32_t>(0xA4000000 + i, Memory::read<uint32_t>(0xB0000000 + i));
         CPU::programCounter = 0xA4000040 - 4;
     }
 
@@ -18,10 +18,16 @@
 */
 
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <cstring>
 #include <mutex>
 #include <thread>
-#include <vector>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
 
 #include "rdp.h"
 #include "log.h"
@@ -41,6 +47,22 @@ enum CycleType {
     ONE_CYCLE, TWO_CYCLE, COPY_MODE, FILL_MODE
 };
 
+// Common blender modes, encoded as A-B-C-D selector bits
+enum BlendMode {
+    BLEND_ANY = -1, // Selectors are read at runtime
+    BLEND_OPAQUE = 0x32, // Input color at full scale, also used to pass through the first cycle
+    BLEND_ALPHA = 0x04, // Input color over memory color using input alpha
+    BLEND_AA = 0x05, // Input color over memory color using input and memory alpha
+    BLEND_FOG = 0xE0 // Fog color over input color using shade alpha
+};
+
+// Per-pixel values that carry over to later pixels when they aren't updated
+enum CarryValue {
+    CARRY_COMB = 1 << 0,
+    CARRY_TEXEL = 1 << 1,
+    CARRY_SHADE = 1 << 2
+};
+
 struct Tile {
     uint16_t s1, s2;
     uint16_t sMask;
@@ -56,130 +78,317 @@ struct Tile {
     uint16_t width;
     uint8_t palette;
     Format format;
+
+    // Decoded texels are cached within a window of wrapped coordinates
+    // Each texel is valid if its generation matches the tile's, so the cache can be invalidated quickly
+    uint16_t cacheWidth;
+    uint16_t cacheHeight;
+    uint16_t cacheGen;
+    uint16_t texelGens[0x1000];
+    uint32_t texels[0x1000];
 };
 
 namespace RDP {
-    extern void (*commands[])();
+    // Rendering state is kept per band of scanlines, so bands can be drawn in parallel
+    // Each band replays every command, but only draws the lines that it owns
+    struct Band {
+        uint8_t id;
+        std::atomic<uint32_t> queuePos;
+        int dirtyY1, dirtyY2;
+        bool wrapLines;
+        bool syncDraw;
+        bool serialDraw;
+        uint64_t *opcode;
+        uint8_t *colorBuf;
+        uint8_t *zBuf;
+
+        uint8_t tmem[0x1000]; // 4KB TMEM
+        CycleType cycleType;
+        bool persCorrect;
+        bool texFilter;
+        uint8_t blendA[2];
+        uint8_t blendB[2];
+        uint8_t blendC[2];
+        uint8_t blendD[2];
+        bool alphaMultiply;
+        uint8_t zMode;
+        bool zUpdate;
+        bool zCompare;
+        bool alphaCompare;
+
+        uint32_t texAddress;
+        uint16_t texWidth;
+        Format texFormat;
+        uint32_t zAddress;
+        uint32_t colorAddress;
+        uint16_t colorWidth;
+        Format colorFormat;
+        Tile tiles[8];
+
+        uint16_t scissorX1;
+        uint16_t scissorX2;
+        uint16_t scissorY1;
+        uint16_t scissorY2;
+
+        uint32_t fillColor;
+        uint32_t combColor;
+        uint32_t texelColor;
+        uint32_t primColor;
+        uint32_t shadeColor;
+        uint32_t envColor;
+        uint32_t combAlpha;
+        uint32_t texelAlpha;
+        uint32_t primAlpha;
+        uint32_t shadeAlpha;
+        uint32_t envAlpha;
+        uint32_t fogColor;
+        uint32_t blendColor;
+        uint32_t pixelAlpha;
+        uint32_t memColor;
+        uint32_t maxColor;
+        uint32_t minColor;
+
+        // Carried values are stamped with the draw and line that wrote them, so bands can find the latest ones
+        uint64_t drawStamp;
+        uint64_t lineStamp;
+        uint64_t combStamp;
+        uint64_t texelStamp;
+        uint64_t shadeStamp;
+        std::atomic<uint32_t> sharePos;
+        uint32_t sharedValues[6];
+        uint64_t sharedStamps[3];
+
+        uint32_t *combineA[4];
+        uint32_t *combineB[4];
+        uint32_t *combineC[4];
+        uint32_t *combineD[4];
+        bool (Band::*pixelFunc)(int x, int y);
+
+        void reset(uint8_t id);
+        bool ownsLine(int y);
+        void updateWrap();
+        uint8_t readValues();
+        void startDraw(int y1, int y2, uint8_t updates, bool gaps);
+        void shareValues();
+        void startLine(int y);
+        void markDirty(int y1, int y2);
+        void mapBuffers(int y1, int y2);
+        void checkHazard(uint32_t start, uint32_t end);
+        void syncBands();
+
+        uint32_t getTexel(Tile &tile, int s, int t, bool rect = false);
+        uint32_t getRawTexel(Tile &tile, int s, int t);
+        uint32_t decodeTexel(Tile &tile, int s, int t);
+        void invalidateTile(Tile &tile);
+        void invalidateTiles();
+        void updatePixel();
+        template <bool passD> uint32_t combinePixel(int i);
+        template <BlendMode mode> bool readsMemory();
+        template <BlendMode mode> bool blendPixel(bool cycle, uint32_t &color);
+        template <CycleType type, bool rgba16, bool passD0, bool passD1, BlendMode blend0, BlendMode blend1>
+        bool drawPixel(int x, int y);
+        bool testDepth(int x, int y, int z);
+
+        uint16_t readColor16(int x, int y);
+        uint32_t readColor32(int x, int y);
+        void writeColor16(int x, int y, uint16_t value);
+        void writeColor32(int x, int y, uint32_t value);
+        uint16_t readDepth(int x, int y);
+        void writeDepth(int x, int y, uint16_t value);
+        bool fillRow(int x1, int x2, int y);
+        bool copyRow(Tile &tile, int x1, int x2, int y, int s, int t);
+
+        template <bool shade, bool texture, bool depth> void triangle();
+        void texRectangle();
+        void syncFull();
+        void setScissor();
+        void setOtherModes();
+        void loadTlut();
+        void setTileSize();
+        void loadRow(const uint8_t *src, uint32_t offset, uint32_t address, uint32_t size, bool odd);
+        void loadBlock();
+        void loadTile();
+        void setTile();
+        void fillRectangle();
+        void setFillColor();
+        void setFogColor();
+        void setBlendColor();
+        void setPrimColor();
+        void setEnvColor();
+        void setCombine();
+        void setTexImage();
+        void setZImage();
+        void setColorImage();
+        void unknown();
+    };
+
+    extern void (Band::*commands[])();
     extern uint8_t paramCounts[];
 
-    std::thread *thread;
+    const int MAX_BANDS = 16;
+    Band bands[MAX_BANDS];
+    uint8_t bandCount;
+
+    std::thread *threads[MAX_BANDS];
+    std::condition_variable queueCond;
+    std::condition_variable doneCond;
     std::mutex mutex;
-    bool running;
+    std::mutex sendMutex;
+    std::atomic<bool> running;
+    std::atomic<int> sleepers;
+    std::atomic<int> waiters;
+
+    // The start of the queue is mirrored past the end, so commands can be read without wrapping
+    uint64_t queue[0x10000 + 0x20];
+    std::atomic<uint32_t> queueReady;
+    uint32_t queueEnd;
+    uint8_t queueOp;
+    uint8_t paramCount;
 
-    uint8_t tmem[0x1000]; // 4KB TMEM
     uint32_t startAddr;
     uint32_t endAddr;
     uint32_t status;
-
     uint32_t addrBase;
     uint32_t addrMask;
-    uint8_t paramCount;
-    std::vector<uint64_t> opcode;
-
-    CycleType cycleType;
-    bool persCorrect;
-    bool texFilter;
-    uint8_t blendA[2];
-    uint8_t blendB[2];
-    uint8_t blendC[2];
-    uint8_t blendD[2];
-    bool alphaMultiply;
-    uint8_t zMode;
-    bool zUpdate;
-    bool zCompare;
-    bool alphaCompare;
-
-    uint32_t texAddress;
-    uint16_t texWidth;
-    Format texFormat;
-    uint32_t zAddress;
-    uint32_t colorAddress;
-    uint16_t colorWidth;
-    Format colorFormat;
-    Tile tiles[8];
-
-    uint16_t scissorX1;
-    uint16_t scissorX2;
-    uint16_t scissorY1;
-    uint16_t scissorY2;
-
-    uint32_t fillColor;
-    uint32_t combColor;
-    uint32_t texelColor;
-    uint32_t primColor;
-    uint32_t shadeColor;
-    uint32_t envColor;
-    uint32_t combAlpha;
-    uint32_t texelAlpha;
-    uint32_t primAlpha;
-    uint32_t shadeAlpha;
-    uint32_t envAlpha;
-    uint32_t fogColor;
-    uint32_t blendColor;
-    uint32_t pixelAlpha;
-    uint32_t memColor;
-    uint32_t maxColor;
-    uint32_t minColor;
-
-    uint32_t *combineA[4];
-    uint32_t *combineB[4];
-    uint32_t *combineC[4];
-    uint32_t *combineD[4];
 
     uint32_t RGBA16toRGBA32(uint16_t color);
     uint16_t RGBA32toRGBA16(uint32_t color);
     uint32_t colorToAlpha(uint32_t color);
 
-    uint32_t getTexel(Tile &tile, int s, int t, bool rect = false);
-    uint32_t getRawTexel(Tile &tile, int s, int t);
-    bool blendPixel(bool cycle, uint32_t &color);
-    bool drawPixel(int x, int y);
-    bool testDepth(int x, int y, int z);
-
-    void runThreaded();
+    void startThread();
+    void runThreaded(Band *band);
+    void runQueue();
+    void wakeThreads();
+    template <typename T> void waitProgress(T done);
     void runCommands();
+    void submitCommands();
+    void addParam(uint64_t param);
+
+#if defined(__SSE2__)
+    inline void step4(int32_t *values, int32_t step) {
+        // Advance 4 interpolated values by a step
+        __m128i v = _mm_load_si128((const __m128i*)values);
+        _mm_store_si128((__m128i*)values, _mm_add_epi32(v, _mm_set1_epi32(step)));
+    }
+
+    inline void shade4(uint32_t *dst, const int32_t *r, const int32_t *g, const int32_t *b, const int32_t *a) {
+        // Clamp 4 interpolated RGBA values to 8 bits using saturated packs, then interleave them into colors
+        __m128i ag = _mm_packs_epi32(_mm_srai_epi32(_mm_load_si128((const __m128i*)a), 16),
+            _mm_srai_epi32(_mm_load_si128((const __m128i*)g), 16));
+        __m128i br = _mm_packs_epi32(_mm_srai_epi32(_mm_load_si128((const __m128i*)b), 16),
+            _mm_srai_epi32(_mm_load_si128((const __m128i*)r), 16));
+        __m128i c = _mm_packus_epi16(ag, br);
+        c = _mm_unpacklo_epi8(c, _mm_srli_si128(c, 8));
+        _mm_store_si128((__m128i*)dst, _mm_unpacklo_epi16(c, _mm_srli_si128(c, 8)));
+    }
+
+    inline int depth4(const int32_t *z, const uint16_t *m, bool decal) {
+        // Compare 4 interpolated depth values with values from memory, returning one bit per passing pixel
+        __m128i zv = _mm_srai_epi32(_mm_load_si128((const __m128i*)z), 16);
+        __m128i mv = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)m), _mm_setzero_si128());
+        __m128i pass = decal ? _mm_and_si128(_mm_cmpgt_epi32(mv, _mm_sub_epi32(zv, _mm_set1_epi32(0x20))),
+            _mm_cmplt_epi32(mv, _mm_add_epi32(zv, _mm_set1_epi32(0x20)))) : _mm_cmpgt_epi32(mv, zv);
+        return _mm_movemask_ps(_mm_castsi128_ps(pass));
+    }
+
+    inline void copyTmem16(uint8_t *dst, const uint8_t *src, bool odd) {
+        // Copy 16 bytes of host-endian words to TMEM as big-endian, swapping pairs of words on odd lines
+        __m128i v = _mm_loadu_si128((const __m128i*)src);
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0xB1), 0xB1);
+        _mm_storeu_si128((__m128i*)dst, odd ? _mm_shuffle_epi32(v, 0xB1) : v);
+    }
+#elif defined(__aarch64__)
+    inline void step4(int32_t *values, int32_t step) {
+        // Advance 4 interpolated values by a step
+        vst1q_s32(values, vaddq_s32(vld1q_s32(values), vdupq_n_s32(step)));
+    }
+
+    inline void shade4(uint32_t *dst, const int32_t *r, const int32_t *g, const int32_t *b, const int32_t *a) {
+        // Clamp 4 interpolated RGBA values to 8 bits, then shift them into colors
+        int32x4_t zero = vdupq_n_s32(0x00), max = vdupq_n_s32(0xFF);
+        uint32x4_t rv = vreinterpretq_u32_s32(vminq_s32(vmaxq_s32(vshrq_n_s32(vld1q_s32(r), 16), zero), max));
+        uint32x4_t gv = vreinterpretq_u32_s32(vminq_s32(vmaxq_s32(vshrq_n_s32(vld1q_s32(g), 16), zero), max));
+        uint32x4_t bv = vreinterpretq_u32_s32(vminq_s32(vmaxq_s32(vshrq_n_s32(vld1q_s32(b), 16), zero), max));
+        uint32x4_t av = vreinterpretq_u32_s32(vminq_s32(vmaxq_s32(vshrq_n_s32(vld1q_s32(a), 16), zero), max));
+        vst1q_u32(dst, vorrq_u32(vorrq_u32(vshlq_n_u32(rv, 24), vshlq_n_u32(gv, 16)), vorrq_u32(vshlq_n_u32(bv, 8), av)));
+    }
+
+    inline int depth4(const int32_t *z, const uint16_t *m, bool decal) {
+        // Compare 4 interpolated depth values with values from memory, returning one bit per passing pixel
+        static const uint32_t bits[4] = { 0x1, 0x2, 0x4, 0x8 };
+        int32x4_t zv = vshrq_n_s32(vld1q_s32(z), 16);
+        int32x4_t mv = vreinterpretq_s32_u32(vmovl_u16(vld1_u16(m)));
+        uint32x4_t pass = decal ? vandq_u32(vcgtq_s32(mv, vsubq_s32(zv, vdupq_n_s32(0x20))),
+            vcltq_s32(mv, vaddq_s32(zv, vdupq_n_s32(0x20)))) : vcgtq_s32(mv, zv);
+        return vaddvq_u32(vandq_u32(pass, vld1q_u32(bits)));
+    }
+
+    inline void copyTmem16(uint8_t *dst, const uint8_t *src, bool odd) {
+        // Copy 16 bytes of host-endian words to TMEM as big-endian, swapping pairs of words on odd lines
+        uint8x16_t v = vrev32q_u8(vld1q_u8(src));
+        vst1q_u8(dst, odd ? vreinterpretq_u8_u32(vrev64q_u32(vreinterpretq_u32_u8(v))) : v);
+    }
+#else
+    inline void step4(int32_t *values, int32_t step) {
+        // Advance 4 interpolated values by a step
+        for (int i = 0; i < 4; i++)
+            values[i] = uint32_t(values[i]) + step;
+    }
+
+    inline void shade4(uint32_t *dst, const int32_t *r, const int32_t *g, const int32_t *b, const int32_t *a) {
+        // Clamp 4 interpolated RGBA values to 8 bits and combine them into colors
+        for (int i = 0; i < 4; i++) {
+            uint8_t rc = std::max(0x00, std::min(0xFF, r[i] >> 16));
+            uint8_t gc = std::max(0x00, std::min(0xFF, g[i] >> 16));
+            uint8_t bc = std::max(0x00, std::min(0xFF, b[i] >> 16));
+            uint8_t ac = std::max(0x00, std::min(0xFF, a[i] >> 16));
+            dst[i] = (rc << 24) | (gc << 16) | (bc << 8) | ac;
+        }
+    }
+
+    inline int depth4(const int32_t *z, const uint16_t *m, bool decal) {
+        // Compare 4 interpolated depth values with values from memory, returning one bit per passing pixel
+        int bits = 0;
+        for (int i = 0; i < 4; i++) {
+            int zi = z[i] >> 16;
+            bits |= (decal ? (m[i] > zi - 0x20 && m[i] < zi + 0x20) : (m[i] > zi)) << i;
+        }
+        return bits;
+    }
+
+    inline void copyTmem16(uint8_t *dst, const uint8_t *src, bool odd) {
+        // Copy 16 bytes of host-endian words to TMEM as big-endian, swapping pairs of words on odd lines
+        for (int i = 0; i < 16; i++)
+            dst[i ^ (odd << 2)] = src[i ^ 3];
+    }
+#endif
 
-    template <bool shade, bool texture, bool depth> void triangle();
-    void texRectangle();
-    void syncFull();
-    void setScissor();
-    void setOtherModes();
-    void loadTlut();
-    void setTileSize();
-    void loadBlock();
-    void loadTile();
-    void setTile();
-    void fillRectangle();
-    void setFillColor();
-    void setFogColor();
-    void setBlendColor();
-    void setPrimColor();
-    void setEnvColor();
-    void setCombine();
-    void setTexImage();
-    void setZImage();
-    void setColorImage();
-    void unknown();
+    inline void copyTmem8(uint8_t *dst, const uint8_t *src, bool odd) {
+        // Copy 8 bytes of host-endian words to TMEM as big-endian, swapping the words on odd lines
+        for (int i = 0; i < 8; i++)
+            dst[i ^ (odd << 2)] = src[i ^ 3];
+    }
 }
 
 // RDP command lookup table, based on opcode bits 56-61
-void (*RDP::commands[0x40])() = {
-    unknown, unknown, unknown, unknown, // 0x00-0x03
-    unknown, unknown, unknown, unknown, // 0x04-0x07
-    triangle<0,0,0>, triangle<0,0,1>, triangle<0,1,0>, triangle<0,1,1>, // 0x08-0x0B
-    triangle<1,0,0>, triangle<1,0,1>, triangle<1,1,0>, triangle<1,1,1>, // 0x0C-0x0F
-    unknown, unknown, unknown, unknown, // 0x10-0x13
-    unknown, unknown, unknown, unknown, // 0x14-0x17
-    unknown, unknown, unknown, unknown, // 0x18-0x1B
-    unknown, unknown, unknown, unknown, // 0x1C-0x1F
-    unknown, unknown, unknown, unknown, // 0x20-0x23
-    texRectangle, unknown, unknown, unknown, // 0x24-0x27
-    unknown, syncFull, unknown, unknown, // 0x28-0x2B
-    unknown, setScissor, unknown, setOtherModes, // 0x2C-0x2F
-    loadTlut, unknown, setTileSize, loadBlock, // 0x30-0x33
-    loadTile, setTile, fillRectangle, setFillColor, // 0x34-0x37
-    setFogColor, setBlendColor, setPrimColor, setEnvColor, // 0x38-0x3B
-    setCombine, setTexImage, setZImage, setColorImage // 0x3C-0x3F
+void (RDP::Band::*RDP::commands[0x40])() = {
+    &Band::unknown, &Band::unknown, &Band::unknown, &Band::unknown, // 0x00-0x03
+    &Band::unknown, &Band::unknown, &Band::unknown, &Band::unknown, // 0x04-0x07
+    &Band::triangle<0,0,0>, &Band::triangle<0,0,1>, &Band::triangle<0,1,0>, &Band::triangle<0,1,1>, // 0x08-0x0B
+    &Band::triangle<1,0,0>, &Band::triangle<1,0,1>, &Band::triangle<1,1,0>, &Band::triangle<1,1,1>, // 0x0C-0x0F
+    &Band::unknown, &Band::unknown, &Band::unknown, &Band::unknown, // 0x10-0x13
+    &Band::unknown, &Band::unknown, &Band::unknown, &Band::unknown, // 0x14-0x17
+    &Band::unknown, &Band::unknown, &Band::unknown, &Band::unknown, // 0x18-0x1B
+    &Band::unknown, &Band::unknown, &Band::unknown, &Band::unknown, // 0x1C-0x1F
+    &Band::unknown, &Band::unknown, &Band::unknown, &Band::unknown, // 0x20-0x23
+    &Band::texRectangle, &Band::unknown, &Band::unknown, &Band::unknown, // 0x24-0x27
+    &Band::unknown, &Band::syncFull, &Band::unknown, &Band::unknown, // 0x28-0x2B
+    &Band::unknown, &Band::setScissor, &Band::unknown, &Band::setOtherModes, // 0x2C-0x2F
+    &Band::loadTlut, &Band::unknown, &Band::setTileSize, &Band::loadBlock, // 0x30-0x33
+    &Band::loadTile, &Band::setTile, &Band::fillRectangle, &Band::setFillColor, // 0x34-0x37
+    &Band::setFogColor, &Band::setBlendColor, &Band::setPrimColor, &Band::setEnvColor, // 0x38-0x3B
+    &Band::setCombine, &Band::setTexImage, &Band::setZImage, &Band::setColorImage // 0x3C-0x3F
 };
 
 uint8_t RDP::paramCounts[0x40] = {
@@ -195,14 +404,36 @@ uint8_t RDP::paramCounts[0x40] = {
 
 void RDP::reset() {
     // Reset the RDP to its initial state
-    memset(tmem, 0, sizeof(tmem));
     startAddr = 0;
     endAddr = 0;
     status = 0;
     addrBase = 0xA0000000;
     addrMask = 0xFFFFFF;
+    queueEnd = 0;
+    queueReady = 0;
+    queueOp = 0;
     paramCount = 0;
-    opcode.clear();
+
+    // Split rendering into bands if enabled, leaving cores free for the CPU and RSP
+    int count = Settings::parallelRdp ? int(std::thread::hardware_concurrency()) - 2 : 1;
+    bandCount = std::max(1, std::min(MAX_BANDS, count));
+    for (int i = 0; i < MAX_BANDS; i++)
+        bands[i].reset(i);
+}
+
+void RDP::Band::reset(uint8_t id) {
+    // Reset a band's rendering state
+    this->id = id;
+    queuePos = 0;
+    dirtyY1 = 0x7FFFFFFF;
+    dirtyY2 = 0;
+    wrapLines = false;
+    syncDraw = false;
+    serialDraw = false;
+    opcode = queue;
+    colorBuf = nullptr;
+    zBuf = nullptr;
+    memset(tmem, 0, sizeof(tmem));
     cycleType = ONE_CYCLE;
     persCorrect = false;
     texFilter = false;
@@ -223,6 +454,7 @@ void RDP::reset() {
     colorWidth = 0;
     colorFormat = RGBA4;
     memset(tiles, 0, sizeof(tiles));
+    invalidateTiles();
     scissorX1 = 0;
     scissorX2 = 0;
     scissorY1 = 0;
@@ -244,12 +476,19 @@ void RDP::reset() {
     memColor = 0x00000000;
     maxColor = 0xFFFFFFFF;
     minColor = 0x00000000;
+    drawStamp = 0;
+    lineStamp = 0;
+    combStamp = 0;
+    texelStamp = 0;
+    shadeStamp = 0;
+    sharePos = -1;
     for (int i = 0; i < 4; i++) {
         combineA[i] = &maxColor;
         combineB[i] = &minColor;
         combineC[i] = &maxColor;
         combineD[i] = &minColor;
     }
+    updatePixel();
 }
 
 uint32_t RDP::read(int index) {
@@ -317,6 +556,192 @@ void RDP::write(int index, uint32_t value) {
     }
 }
 
+inline bool RDP::Band::ownsLine(int y) {
+    // Check if a line belongs to this band, interleaving bands every 8 lines
+    // If pixels can wrap into the next line or depend on the previous one, the first band draws everything
+    return (wrapLines || serialDraw) ? !id : (((y >> 3) % bandCount) == id);
+}
+
+void RDP::Band::updateWrap() {
+    // Check if pixels within scissor bounds can wrap past the end of a line in the color buffer
+    bool wrap = (scissorX2 > colorWidth);
+    if (wrap == wrapLines) return;
+
+    // Sync the bands before changing which lines they own, so no line is drawn by two at once
+    checkHazard(0x00000000, 0xFFFFFFFF);
+    wrapLines = wrap;
+}
+
+uint8_t RDP::Band::readValues() {
+    // Get the carried values that the combiner or blender can read, based on the cycle type
+    if (cycleType == COPY_MODE) return CARRY_TEXEL;
+    if (cycleType == FILL_MODE) return 0;
+    uint8_t reads = 0;
+
+    for (int c = 0; c < ((cycleType == TWO_CYCLE) ? 2 : 1); c++) {
+        // Check the RGB and alpha combiner inputs for the cycle
+        // The combined color is only carried over when the first cycle reads it, since the second gets it from the first
+        for (int i = c; i < 4; i += 2) {
+            uint32_t *inputs[4] = { combineA[i], combineB[i], combineC[i], combineD[i] };
+            for (int j = 0; j < 4; j++) {
+                if (!c && (inputs[j] == &combColor || inputs[j] == &combAlpha)) reads |= CARRY_COMB;
+                if (inputs[j] == &texelColor || inputs[j] == &texelAlpha) reads |= CARRY_TEXEL;
+                if (inputs[j] == &shadeColor || inputs[j] == &shadeAlpha) reads |= CARRY_SHADE;
+            }
+        }
+
+        // Check if the blender uses shade alpha for the cycle
+        if (blendB[c] == 2) reads |= CARRY_SHADE;
+    }
+    return reads;
+}
+
+void RDP::Band::startDraw(int y1, int y2, uint8_t updates, bool gaps) {
+    // Move on to the next draw, which orders the stamps of values written by it after previous ones
+    drawStamp += 0x10000;
+    serialDraw = false;
+
+    // Values that a draw reads without updating them first may have last been written by another band
+    // If values carry over between pixels within the draw, they depend on all previous lines, so one band draws it
+    bool serial = false;
+    if (bandCount > 1) {
+        uint8_t reads = readValues();
+        serial = (reads & CARRY_COMB) || (gaps && (reads & CARRY_TEXEL));
+        if (serial || (reads & ~updates))
+            shareValues();
+    }
+
+    // Track the lines being drawn only after sharing, since syncing the bands clears them
+    markDirty(y1, y2);
+
+    // Sync the bands again before the next draw, so bands that skip this one don't draw over it early
+    if (serial) {
+        serialDraw = true;
+        syncDraw = true;
+    }
+}
+
+void RDP::Band::shareValues() {
+    // Wait for all bands to finish the commands before the current one, and share their carried values
+    syncBands();
+    uint32_t pos = queuePos;
+    sharedValues[0] = combColor;
+    sharedValues[1] = combAlpha;
+    sharedValues[2] = texelColor;
+    sharedValues[3] = texelAlpha;
+    sharedValues[4] = shadeColor;
+    sharedValues[5] = shadeAlpha;
+    sharedStamps[0] = combStamp;
+    sharedStamps[1] = texelStamp;
+    sharedStamps[2] = shadeStamp;
+    sharePos = pos;
+
+    // Let waiting bands know about the shared values, and wait for every band to share its own
+    if (waiters) {
+        std::lock_guard<std::mutex> guard(mutex);
+        doneCond.notify_all();
+    }
+    waitProgress([pos] {
+        for (int i = 0; i < bandCount; i++)
+            if (bands[i].sharePos != pos) return false;
+        return true;
+    });
+
+    // Use the most recently written values, as if every pixel had been drawn in order
+    // Bands don't share again until every band has moved past this command, so the values stay intact
+    for (int i = 0; i < bandCount; i++) {
+        Band &band = bands[i];
+        if (band.sharedStamps[0] > combStamp) {
+            combColor = band.sharedValues[0];
+            combAlpha = band.sharedValues[1];
+            combStamp = band.sharedStamps[0];
+        }
+        if (band.sharedStamps[1] > texelStamp) {
+            texelColor = band.sharedValues[2];
+            texelAlpha = band.sharedValues[3];
+            texelStamp = band.sharedStamps[1];
+        }
+        if (band.sharedStamps[2] > shadeStamp) {
+            shadeColor = band.sharedValues[4];
+            shadeAlpha = band.sharedValues[5];
+            shadeStamp = band.sharedStamps[2];
+        }
+    }
+}
+
+inline void RDP::Band::startLine(int y) {
+    // Stamp values written on this line with the draw and line, since lines within a draw go from top to bottom
+    lineStamp = drawStamp | y;
+}
+
+void RDP::Band::markDirty(int y1, int y2) {
+    // Sync the bands before drawing if a previous command read memory that could be drawn over
+    if (syncDraw) {
+        syncBands();
+        syncDraw = false;
+    }
+
+    // Track the range of lines that have been drawn since bands were last in sync
+    dirtyY1 = std::min(dirtyY1, y1);
+    dirtyY2 = std::max(dirtyY2, y2);
+}
+
+void RDP::Band::mapBuffers(int y1, int y2) {
+    // Clip the lines covered by a primitive to the scissor bounds
+    y1 = std::max<int>(y1, scissorY1);
+    y2 = std::min<int>(y2, scissorY2);
+    colorBuf = zBuf = nullptr;
+    if (y1 >= y2 || (colorAddress & 0x3) || (zAddress & 0x3))
+        return;
+
+    // Get host pointers to the color and Z buffers if the covered pixels can be accessed directly
+    // Otherwise, such as when out of bounds, pixels will be accessed through the memory system
+    uint32_t bpp = (colorFormat == RGBA16) ? 2 : 4;
+    uint32_t start = y1 * colorWidth;
+    uint32_t size = (y2 - y1 - 1) * colorWidth + scissorX2;
+    if (uint8_t *buf = Memory::getRdram((colorAddress & 0xFFFFFF) + start * bpp, size * bpp))
+        colorBuf = buf - start * bpp;
+    if (uint8_t *buf = Memory::getRdram((zAddress & 0xFFFFFF) + start * 2, size * 2))
+        zBuf = buf - start * 2;
+}
+
+void RDP::Band::checkHazard(uint32_t start, uint32_t end) {
+    // Skip the check if there's only one band
+    if (bandCount == 1)
+        return;
+
+    // Sync the bands before the next draw if a memory range overlaps anywhere in the color or Z buffer
+    // Otherwise, bands that are ahead could draw over memory before bands that are behind have read it
+    uint32_t colorStride = colorWidth * ((colorFormat == RGBA16) ? 2 : 4);
+    if ((start < colorAddress + colorStride * 0x400 && end > colorAddress) ||
+        (start < zAddress + colorWidth * 0x800 && end > zAddress))
+        syncDraw = true;
+
+    // Sync the bands now if a memory range overlaps lines in the color or Z buffer that other bands may still be drawing
+    if (dirtyY1 >= dirtyY2)
+        return;
+    uint32_t colorStart = colorAddress + dirtyY1 * colorStride;
+    uint32_t colorEnd = colorAddress + dirtyY2 * colorStride;
+    uint32_t zStart = zAddress + dirtyY1 * colorWidth * 2;
+    uint32_t zEnd = zAddress + dirtyY2 * colorWidth * 2;
+    if ((start < colorEnd && end > colorStart) || (start < zEnd && end > zStart))
+        syncBands();
+}
+
+void RDP::Band::syncBands() {
+    // Wait for all bands to finish the commands before the current one
+    uint32_t pos = queuePos;
+    waitProgress([pos] {
+        for (int i = 0; i < bandCount; i++)
+            if (int32_t(bands[i].queuePos - pos) < 0) return false;
+        return true;
+    });
+
+    // Reset the drawn line range now that everything is in sync
+    dirtyY1 = 0x7FFFFFFF;
+    dirtyY2 = 0;
+}
+
 inline uint32_t RDP::RGBA16toRGBA32(uint16_t color) {
     // Convert an RGBA16 color to RGBA32
     uint8_t r = ((color >> 8) & 0xF8) | ((color >> 13) & 0x7);
@@ -341,7 +766,7 @@ inline uint32_t RDP::colorToAlpha(uint32_t color) {
     return (a << 24) | (a << 16) | (a << 8) | a;
 }
 
-uint32_t RDP::getTexel(Tile &tile, int s, int t, bool rect) {
+uint32_t RDP::Band::getTexel(Tile &tile, int s, int t, bool rect) {
     // Offset the texture coordinates relative to the tile
     s -= tile.s1;
     t -= tile.t1;
@@ -387,7 +812,7 @@ uint32_t RDP::getTexel(Tile &tile, int s, int t, bool rect) {
     return (r << 24) | (g << 16) | (b << 8) | (a >> 5);
 }
 
-uint32_t RDP::getRawTexel(Tile &tile, int s, int t) {
+uint32_t RDP::Band::getRawTexel(Tile &tile, int s, int t) {
     // Clamp, mirror, or mask the S-coordinate based on tile settings
     if (tile.sClamp) s = std::max<int>(std::min<int>(s, (tile.s2 - tile.s1) >> 5), 0);
     if (tile.sMirror && (s & (tile.sMask + 1))) s = ~s;
@@ -398,6 +823,19 @@ uint32_t RDP::getRawTexel(Tile &tile, int s, int t) {
     if (tile.tMirror && (t & (tile.tMask + 1))) t = ~t;
     t &= tile.tMask;
 
+    // Look up the texel in the tile's cache if it's within the window, decoding it first if it isn't valid
+    if (s < tile.cacheWidth && t < tile.cacheHeight) {
+        uint32_t i = t * tile.cacheWidth + s;
+        if (tile.texelGens[i] != tile.cacheGen) {
+            tile.texels[i] = decodeTexel(tile, s, t);
+            tile.texelGens[i] = tile.cacheGen;
+        }
+        return tile.texels[i];
+    }
+    return decodeTexel(tile, s, t);
+}
+
+uint32_t RDP::Band::decodeTexel(Tile &tile, int s, int t) {
     // Get an RGBA32 texel from a tile at the given coordinates
     switch (tile.format) {
     case RGBA16: {
@@ -479,10 +917,200 @@ uint32_t RDP::getRawTexel(Tile &tile, int s, int t) {
     }
 }
 
-bool RDP::blendPixel(bool cycle, uint32_t &color) {
+void RDP::Band::updatePixel() {
+    // Look up pixel functions specialised for the current modes, falling back to generic ones for others
+    // One-cycle functions are indexed by color format, D pass-through, and cycle 0 blender mode
+    static bool (Band::*const oneCycle[2][2][5])(int, int) = {
+        {
+            {
+                &Band::drawPixel<ONE_CYCLE, false, false, false, BLEND_ANY, BLEND_ANY>,
+                &Band::drawPixel<ONE_CYCLE, false, false, false, BLEND_OPAQUE, BLEND_ANY>,
+                &Band::drawPixel<ONE_CYCLE, false, false, false, BLEND_ALPHA, BLEND_ANY>,
+                &Band::drawPixel<ONE_CYCLE, false, false, false, BLEND_AA, BLEND_ANY>,
+                &Band::drawPixel<ONE_CYCLE, false, false, false, BLEND_FOG, BLEND_ANY>
+            },
+            {
+                &Band::drawPixel<ONE_CYCLE, false, true, false, BLEND_ANY, BLEND_ANY>,
+                &Band::drawPixel<ONE_CYCLE, false, true, false, BLEND_OPAQUE, BLEND_ANY>,
+                &Band::drawPixel<ONE_CYCLE, false, true, false, BLEND_ALPHA, BLEND_ANY>,
+                &Band::drawPixel<ONE_CYCLE, false, true, false, BLEND_AA, BLEND_ANY>,
+                &Band::drawPixel<ONE_CYCLE, false, true, false, BLEND_FOG, BLEND_ANY>
+            }
+        },
+        {
+            {
+                &Band::drawPixel<ONE_CYCLE, true, false, false, BLEND_ANY, BLEND_ANY>,
+                &Band::drawPixel<ONE_CYCLE, true, false, false, BLEND_OPAQUE, BLEND_ANY>,
+                &Band::drawPixel<ONE_CYCLE, true, false, false, BLEND_ALPHA, BLEND_ANY>,
+                &Band::drawPixel<ONE_CYCLE, true, false, false, BLEND_AA, BLEND_ANY>,
+                &Band::drawPixel<ONE_CYCLE, true, false, false, BLEND_FOG, BLEND_ANY>
+            },
+            {
+                &Band::drawPixel<ONE_CYCLE, true, true, false, BLEND_ANY, BLEND_ANY>,
+                &Band::drawPixel<ONE_CYCLE, true, true, false, BLEND_OPAQUE, BLEND_ANY>,
+                &Band::drawPixel<ONE_CYCLE, true, true, false, BLEND_ALPHA, BLEND_ANY>,
+                &Band::drawPixel<ONE_CYCLE, true, true, false, BLEND_AA, BLEND_ANY>,
+                &Band::drawPixel<ONE_CYCLE, true, true, false, BLEND_FOG, BLEND_ANY>
+            }
+        }
+    };
+
+    // Two-cycle functions are indexed by color format, cycle 1 D pass-through, and blender modes for both cycles
+    static bool (Band::*const twoCycle[2][2][3][4])(int, int) = {
+        {
+            {
+                {
+                    &Band::drawPixel<TWO_CYCLE, false, false, false, BLEND_ANY, BLEND_ANY>,
+                    &Band::drawPixel<TWO_CYCLE, false, false, false, BLEND_ANY, BLEND_OPAQUE>,
+                    &Band::drawPixel<TWO_CYCLE, false, false, false, BLEND_ANY, BLEND_ALPHA>,
+                    &Band::drawPixel<TWO_CYCLE, false, false, false, BLEND_ANY, BLEND_AA>
+                },
+                {
+                    &Band::drawPixel<TWO_CYCLE, false, false, false, BLEND_OPAQUE, BLEND_ANY>,
+                    &Band::drawPixel<TWO_CYCLE, false, false, false, BLEND_OPAQUE, BLEND_OPAQUE>,
+                    &Band::drawPixel<TWO_CYCLE, false, false, false, BLEND_OPAQUE, BLEND_ALPHA>,
+                    &Band::drawPixel<TWO_CYCLE, false, false, false, BLEND_OPAQUE, BLEND_AA>
+                },
+                {
+                    &Band::drawPixel<TWO_CYCLE, false, false, false, BLEND_FOG, BLEND_ANY>,
+                    &Band::drawPixel<TWO_CYCLE, false, false, false, BLEND_FOG, BLEND_OPAQUE>,
+                    &Band::drawPixel<TWO_CYCLE, false, false, false, BLEND_FOG, BLEND_ALPHA>,
+                    &Band::drawPixel<TWO_CYCLE, false, false, false, BLEND_FOG, BLEND_AA>
+                }
+            },
+            {
+                {
+                    &Band::drawPixel<TWO_CYCLE, false, false, true, BLEND_ANY, BLEND_ANY>,
+                    &Band::drawPixel<TWO_CYCLE, false, false, true, BLEND_ANY, BLEND_OPAQUE>,
+                    &Band::drawPixel<TWO_CYCLE, false, false, true, BLEND_ANY, BLEND_ALPHA>,
+                    &Band::drawPixel<TWO_CYCLE, false, false, true, BLEND_ANY, BLEND_AA>
+                },
+                {
+                    &Band::drawPixel<TWO_CYCLE, false, false, true, BLEND_OPAQUE, BLEND_ANY>,
+                    &Band::drawPixel<TWO_CYCLE, false, false, true, BLEND_OPAQUE, BLEND_OPAQUE>,
+                    &Band::drawPixel<TWO_CYCLE, false, false, true, BLEND_OPAQUE, BLEND_ALPHA>,
+                    &Band::drawPixel<TWO_CYCLE, false, false, true, BLEND_OPAQUE, BLEND_AA>
+                },
+                {
+                    &Band::drawPixel<TWO_CYCLE, false, false, true, BLEND_FOG, BLEND_ANY>,
+                    &Band::drawPixel<TWO_CYCLE, false, false, true, BLEND_FOG, BLEND_OPAQUE>,
+                    &Band::drawPixel<TWO_CYCLE, false, false, true, BLEND_FOG, BLEND_ALPHA>,
+                    &Band::drawPixel<TWO_CYCLE, false, false, true, BLEND_FOG, BLEND_AA>
+                }
+            }
+        },
+        {
+            {
+                {
+                    &Band::drawPixel<TWO_CYCLE, true, false, false, BLEND_ANY, BLEND_ANY>,
+                    &Band::drawPixel<TWO_CYCLE, true, false, false, BLEND_ANY, BLEND_OPAQUE>,
+                    &Band::drawPixel<TWO_CYCLE, true, false, false, BLEND_ANY, BLEND_ALPHA>,
+                    &Band::drawPixel<TWO_CYCLE, true, false, false, BLEND_ANY, BLEND_AA>
+                },
+                {
+                    &Band::drawPixel<TWO_CYCLE, true, false, false, BLEND_OPAQUE, BLEND_ANY>,
+                    &Band::drawPixel<TWO_CYCLE, true, false, false, BLEND_OPAQUE, BLEND_OPAQUE>,
+                    &Band::drawPixel<TWO_CYCLE, true, false, false, BLEND_OPAQUE, BLEND_ALPHA>,
+                    &Band::drawPixel<TWO_CYCLE, true, false, false, BLEND_OPAQUE, BLEND_AA>
+                },
+                {
+                    &Band::drawPixel<TWO_CYCLE, true, false, false, BLEND_FOG, BLEND_ANY>,
+                    &Band::drawPixel<TWO_CYCLE, true, false, false, BLEND_FOG, BLEND_OPAQUE>,
+                    &Band::drawPixel<TWO_CYCLE, true, false, false, BLEND_FOG, BLEND_ALPHA>,
+                    &Band::drawPixel<TWO_CYCLE, true, false, false, BLEND_FOG, BLEND_AA>
+                }
+            },
+            {
+                {
+                    &Band::drawPixel<TWO_CYCLE, true, false, true, BLEND_ANY, BLEND_ANY>,
+                    &Band::drawPixel<TWO_CYCLE, true, false, true, BLEND_ANY, BLEND_OPAQUE>,
+                    &Band::drawPixel<TWO_CYCLE, true, false, true, BLEND_ANY, BLEND_ALPHA>,
+                    &Band::drawPixel<TWO_CYCLE, true, false, true, BLEND_ANY, BLEND_AA>
+                },
+                {
+                    &Band::drawPixel<TWO_CYCLE, true, false, true, BLEND_OPAQUE, BLEND_ANY>,
+                    &Band::drawPixel<TWO_CYCLE, true, false, true, BLEND_OPAQUE, BLEND_OPAQUE>,
+                    &Band::drawPixel<TWO_CYCLE, true, false, true, BLEND_OPAQUE, BLEND_ALPHA>,
+                    &Band::drawPixel<TWO_CYCLE, true, false, true, BLEND_OPAQUE, BLEND_AA>
+                },
+                {
+                    &Band::drawPixel<TWO_CYCLE, true, false, true, BLEND_FOG, BLEND_ANY>,
+                    &Band::drawPixel<TWO_CYCLE, true, false, true, BLEND_FOG, BLEND_OPAQUE>,
+                    &Band::drawPixel<TWO_CYCLE, true, false, true, BLEND_FOG, BLEND_ALPHA>,
+                    &Band::drawPixel<TWO_CYCLE, true, false, true, BLEND_FOG, BLEND_AA>
+                }
+            }
+        }
+    };
+
+    // Copy and fill functions are only indexed by color format
+    static bool (Band::*const copyFill[2][2])(int, int) = {
+        {
+            &Band::drawPixel<COPY_MODE, false, false, false, BLEND_ANY, BLEND_ANY>,
+            &Band::drawPixel<COPY_MODE, true, false, false, BLEND_ANY, BLEND_ANY>
+        },
+        {
+            &Band::drawPixel<FILL_MODE, false, false, false, BLEND_ANY, BLEND_ANY>,
+            &Band::drawPixel<FILL_MODE, true, false, false, BLEND_ANY, BLEND_ANY>
+        }
+    };
+
+    // Find the index of each cycle's blender mode in its list of specialised modes, or 0 if not found
+    static const BlendMode modes0[] = { BLEND_ANY, BLEND_OPAQUE, BLEND_ALPHA, BLEND_AA, BLEND_FOG };
+    static const BlendMode modes1[] = { BLEND_ANY, BLEND_OPAQUE, BLEND_FOG };
+    static const BlendMode modes2[] = { BLEND_ANY, BLEND_OPAQUE, BLEND_ALPHA, BLEND_AA };
+    int blend[2] = { 0, 0 };
+    for (int i = 0; i < 2; i++) {
+        int mode = (blendA[i] << 6) | (blendB[i] << 4) | (blendC[i] << 2) | blendD[i];
+        int count = (cycleType == ONE_CYCLE) ? 5 : (i ? 4 : 3);
+        const BlendMode *modes = (cycleType == ONE_CYCLE) ? modes0 : (i ? modes2 : modes1);
+        for (int j = 1; j < count; j++)
+            if (modes[j] == mode) blend[i] = j;
+    }
+
+    // Check if the combiner A and B inputs cancel out, passing through the D inputs for a cycle
+    bool passD[2];
+    for (int i = 0; i < 2; i++)
+        passD[i] = (combineA[i] == combineB[i] && combineA[i + 2] == combineB[i + 2]);
+
+    // Select the pixel function for the current cycle type
+    bool rgba16 = (colorFormat == RGBA16);
+    switch (cycleType) {
+        case ONE_CYCLE: pixelFunc = oneCycle[rgba16][passD[0]][blend[0]]; break;
+        case TWO_CYCLE: pixelFunc = twoCycle[rgba16][passD[1]][blend[0]][blend[1]]; break;
+        default: pixelFunc = copyFill[cycleType == FILL_MODE][rgba16]; break;
+    }
+}
+
+template <bool passD> inline uint32_t RDP::Band::combinePixel(int i) {
+    // Pass through the D inputs if the A and B inputs cancel out
+    if (passD)
+        return (*combineD[i] & 0xFFFFFF00) | (*combineD[i + 2] & 0xFF);
+
+    // Combine RGBA channels using the formula (A - B) * C + D
+    uint8_t r = (((((*combineA[i] >> 24) - (*combineB[i] >> 24)) & 0xFF) * ((*combineC[i] >> 24) & 0xFF)) / 0xFF) + (*combineD[i] >> 24);
+    uint8_t g = (((((*combineA[i] >> 16) - (*combineB[i] >> 16)) & 0xFF) * ((*combineC[i] >> 16) & 0xFF)) / 0xFF) + (*combineD[i] >> 16);
+    uint8_t b = (((((*combineA[i] >> 8) - (*combineB[i] >> 8)) & 0xFF) * ((*combineC[i] >> 8) & 0xFF)) / 0xFF) + (*combineD[i] >> 8);
+    uint8_t a = (((((*combineA[i + 2] >> 0) - (*combineB[i + 2] >> 0)) & 0xFF) * ((*combineC[i + 2] >> 0) & 0xFF)) / 0xFF) + (*combineD[i + 2] >> 0);
+    return (r << 24) | (g << 16) | (b << 8) | a;
+}
+
+template <BlendMode mode> inline bool RDP::Band::readsMemory() {
+    // Check if a blender mode uses the memory color, assuming it does if selectors are read at runtime
+    if (mode == BLEND_ANY) return true;
+    return ((mode >> 6) & 0x3) == 1 || ((mode >> 2) & 0x3) == 1 || (mode & 0x3) == 1;
+}
+
+template <BlendMode mode> inline bool RDP::Band::blendPixel(bool cycle, uint32_t &color) {
+    // Get the blender selectors, which are constant if specialised for a mode
+    uint8_t srcA = (mode == BLEND_ANY) ? blendA[cycle] : ((mode >> 6) & 0x3);
+    uint8_t srcB = (mode == BLEND_ANY) ? blendB[cycle] : ((mode >> 4) & 0x3);
+    uint8_t srcC = (mode == BLEND_ANY) ? blendC[cycle] : ((mode >> 2) & 0x3);
+    uint8_t srcD = (mode == BLEND_ANY) ? blendD[cycle] : ((mode >> 0) & 0x3);
+
     // Select the first color for blending
     uint32_t color1;
-    switch (blendA[cycle]) {
+    switch (srcA) {
         case 0: color1 = combColor; break;
         case 1: color1 = memColor; break;
         case 2: color1 = blendColor; break;
@@ -491,7 +1119,7 @@ bool RDP::blendPixel(bool cycle, uint32_t &color) {
 
     // Select the scale for the first color
     uint8_t scale1;
-    switch (blendB[cycle]) {
+    switch (srcB) {
         case 0: scale1 = pixelAlpha; break;
         case 1: scale1 = fogColor; break;
         case 2: scale1 = shadeAlpha; break;
@@ -500,7 +1128,7 @@ bool RDP::blendPixel(bool cycle, uint32_t &color) {
 
     // Select the second color for blending
     uint32_t color2;
-    switch (blendC[cycle]) {
+    switch (srcC) {
         case 0: color2 = combColor; break;
         case 1: color2 = memColor; break;
         case 2: color2 = blendColor; break;
@@ -509,15 +1137,15 @@ bool RDP::blendPixel(bool cycle, uint32_t &color) {
 
     // Select the scale for the second color
     uint8_t scale2;
-    switch (blendD[cycle]) {
+    switch (srcD) {
         case 0: scale2 = ~scale1; break;
         case 1: scale2 = memColor; break;
         case 2: scale2 = 0xFF; break;
         case 3: scale2 = 0x00; break;
     }
 
-    // Blend the colors to form a new color
-    if (uint16_t scale = scale1 + scale2) {
+    // Blend the colors to form a new color, knowing the scales add up to 0xFF with an inverted first scale
+    if (uint16_t scale = (srcD == 0) ? 0xFF : (scale1 + scale2)) {
         uint8_t r = (((color1 >> 24) & 0xFF) * scale1 + ((color2 >> 24) & 0xFF) * scale2) / scale;
         uint8_t g = (((color1 >> 16) & 0xFF) * scale1 + ((color2 >> 16) & 0xFF) * scale2) / scale;
         uint8_t b = (((color1 >>  8) & 0xFF) * scale1 + ((color2 >>  8) & 0xFF) * scale2) / scale;
@@ -528,77 +1156,63 @@ bool RDP::blendPixel(bool cycle, uint32_t &color) {
     return false;
 }
 
-bool RDP::drawPixel(int x, int y) {
-    switch (cycleType) {
+template <CycleType type, bool rgba16, bool passD0, bool passD1, BlendMode blend0, BlendMode blend1>
+bool RDP::Band::drawPixel(int x, int y) {
+    switch (type) {
     case ONE_CYCLE: {
-        // Combine cycle 0 RGBA channels using the formula (A - B) * C + D
-        uint8_t r = (((((*combineA[0] >> 24) - (*combineB[0] >> 24)) & 0xFF) * ((*combineC[0] >> 24) & 0xFF)) / 0xFF) + (*combineD[0] >> 24);
-        uint8_t g = (((((*combineA[0] >> 16) - (*combineB[0] >> 16)) & 0xFF) * ((*combineC[0] >> 16) & 0xFF)) / 0xFF) + (*combineD[0] >> 16);
-        uint8_t b = (((((*combineA[0] >> 8) - (*combineB[0] >> 8)) & 0xFF) * ((*combineC[0] >> 8) & 0xFF)) / 0xFF) + (*combineD[0] >> 8);
-        uint8_t a = (((((*combineA[2] >> 0) - (*combineB[2] >> 0)) & 0xFF) * ((*combineC[2] >> 0) & 0xFF)) / 0xFF) + (*combineD[2] >> 0);
-        combColor = (r << 24) | (g << 16) | (b << 8) | a;
+        // Combine cycle 0 RGBA channels
+        combColor = combinePixel<passD0>(0);
         pixelAlpha = combAlpha = colorToAlpha(combColor);
+        combStamp = lineStamp;
 
         // Coverage isn't implemented yet, but pixels with coverage 0 seem to be unconditionally skipped
         // For now, at least skip pixels where coverage is multiplied by alpha 0
         if (alphaMultiply && !pixelAlpha)
             return false;
 
-        if (colorFormat == RGBA16) {
-            // Blend the pixel with the previous RGBA16 pixel in the color buffer
-            memColor = RGBA16toRGBA32(Memory::read<uint16_t>(colorAddress + (y * colorWidth + x) * 2)) & ~0xFF;
-            if (blendPixel(false, memColor)) {
-                Memory::write<uint16_t>(colorAddress + (y * colorWidth + x) * 2, RGBA32toRGBA16(memColor | 0xFF));
-                return true;
-            }
-        }
-        else {
-            // Blend the pixel with the previous RGBA32 pixel in the color buffer
-            memColor = Memory::read<uint32_t>(colorAddress + (y * colorWidth + x) * 4) & ~0xFF;
-            if (blendPixel(false, memColor)) {
-                Memory::write<uint32_t>(colorAddress + (y * colorWidth + x) * 4, memColor | 0xFF);
-                return true;
-            }
+        // Read the previous pixel from the color buffer if the blender uses it
+        if (readsMemory<blend0>())
+            memColor = (rgba16 ? RGBA16toRGBA32(readColor16(x, y)) : readColor32(x, y)) & ~0xFF;
+
+        // Blend the pixel and write it to the color buffer
+        uint32_t color;
+        if (blendPixel<blend0>(false, color)) {
+            if (rgba16)
+                writeColor16(x, y, RGBA32toRGBA16(color | 0xFF));
+            else
+                writeColor32(x, y, color | 0xFF);
+            return true;
         }
         return false;
     }
 
     case TWO_CYCLE: {
-        // Combine cycle 0 RGBA channels using the formula (A - B) * C + D
-        uint8_t r = (((((*combineA[0] >> 24) - (*combineB[0] >> 24)) & 0xFF) * ((*combineC[0] >> 24) & 0xFF)) / 0xFF) + (*combineD[0] >> 24);
-        uint8_t g = (((((*combineA[0] >> 16) - (*combineB[0] >> 16)) & 0xFF) * ((*combineC[0] >> 16) & 0xFF)) / 0xFF) + (*combineD[0] >> 16);
-        uint8_t b = (((((*combineA[0] >> 8) - (*combineB[0] >> 8)) & 0xFF) * ((*combineC[0] >> 8) & 0xFF)) / 0xFF) + (*combineD[0] >> 8);
-        uint8_t a = (((((*combineA[2] >> 0) - (*combineB[2] >> 0)) & 0xFF) * ((*combineC[2] >> 0) & 0xFF)) / 0xFF) + (*combineD[2] >> 0);
-        combColor = (r << 24) | (g << 16) | (b << 8) | a;
+        // Combine cycle 0 RGBA channels
+        combColor = combinePixel<false>(0);
         pixelAlpha = combAlpha = colorToAlpha(combColor);
+        combStamp = lineStamp;
 
         // Coverage isn't implemented yet, but pixels with coverage 0 seem to be unconditionally skipped
         // For now, at least skip pixels where coverage is multiplied by alpha 0
         if (alphaMultiply && !pixelAlpha)
             return false;
 
-        // Blend the pixel with the previous pixel in the color buffer
-        if (colorFormat == RGBA16)
-            memColor = RGBA16toRGBA32(Memory::read<uint16_t>(colorAddress + (y * colorWidth + x) * 2)) & ~0xFF;
-        else
-            memColor = Memory::read<uint32_t>(colorAddress + (y * colorWidth + x) * 4) & ~0xFF;
-        bool blend = blendPixel(false, combColor);
-
-        // Combine cycle 1 RGB channels using the formula (A - B) * C + D
-        r = (((((*combineA[1] >> 24) - (*combineB[1] >> 24)) & 0xFF) * ((*combineC[1] >> 24) & 0xFF)) / 0xFF) + (*combineD[1] >> 24);
-        g = (((((*combineA[1] >> 16) - (*combineB[1] >> 16)) & 0xFF) * ((*combineC[1] >> 16) & 0xFF)) / 0xFF) + (*combineD[1] >> 16);
-        b = (((((*combineA[1] >> 8) - (*combineB[1] >> 8)) & 0xFF) * ((*combineC[1] >> 8) & 0xFF)) / 0xFF) + (*combineD[1] >> 8);
-        a = (((((*combineA[3] >> 0) - (*combineB[3] >> 0)) & 0xFF) * ((*combineC[3] >> 0) & 0xFF)) / 0xFF) + (*combineD[3] >> 0);
-        combColor = (r << 24) | (g << 16) | (b << 8) | a;
+        // Blend the pixel with the previous pixel in the color buffer, if either cycle uses it
+        if (readsMemory<blend0>() || readsMemory<blend1>())
+            memColor = (rgba16 ? RGBA16toRGBA32(readColor16(x, y)) : readColor32(x, y)) & ~0xFF;
+        bool blend = blendPixel<blend0>(false, combColor);
+
+        // Combine cycle 1 RGBA channels
+        combColor = combinePixel<passD1>(1);
         combAlpha = colorToAlpha(combColor);
 
         // Blend the pixel again and write it to the color buffer
         uint32_t color = combColor;
-        if (blendPixel(true, color) || blend) {
-            if (colorFormat == RGBA16)
-                Memory::write<uint16_t>(colorAddress + (y * colorWidth + x) * 2, RGBA32toRGBA16(color | 0xFF));
+        if (blendPixel<blend1>(true, color) || blend) {
+            if (rgba16)
+                writeColor16(x, y, RGBA32toRGBA16(color | 0xFF));
             else
-                Memory::write<uint32_t>(colorAddress + (y * colorWidth + x) * 4, color | 0xFF);
+                writeColor32(x, y, color | 0xFF);
             return true;
         }
         return false;
@@ -610,26 +1224,128 @@ bool RDP::drawPixel(int x, int y) {
             return false;
 
         // Copy a texel directly to the color buffer
-        if (colorFormat == RGBA16)
-            Memory::write<uint16_t>(colorAddress + (y * colorWidth + x) * 2, RGBA32toRGBA16(texelColor));
+        if (rgba16)
+            writeColor16(x, y, RGBA32toRGBA16(texelColor));
         else
-            Memory::write<uint32_t>(colorAddress + (y * colorWidth + x) * 4, texelColor);
+            writeColor32(x, y, texelColor);
         return true;
 
     case FILL_MODE:
         // Copy the fill color directly to the color buffer
-        if (colorFormat == RGBA16)
-            Memory::write<uint16_t>(colorAddress + (y * colorWidth + x) * 2, fillColor >> ((~x & 1) * 16));
+        if (rgba16)
+            writeColor16(x, y, fillColor >> ((~x & 1) * 16));
         else
-            Memory::write<uint32_t>(colorAddress + (y * colorWidth + x) * 4, fillColor);
+            writeColor32(x, y, fillColor);
         return true;
     }
     return false;
 }
 
-bool RDP::testDepth(int x, int y, int z) {
+inline uint16_t RDP::Band::readColor16(int x, int y) {
+    // Read a 16-bit pixel from the color buffer, swizzling its offset within a host-endian word
+    uint32_t offset = (y * colorWidth + x) * 2;
+    if (!colorBuf) return Memory::read<uint16_t>(colorAddress + offset);
+    uint16_t value;
+    memcpy(&value, &colorBuf[offset ^ 2], sizeof(value));
+    return value;
+}
+
+inline uint32_t RDP::Band::readColor32(int x, int y) {
+    // Read a 32-bit pixel from the color buffer
+    uint32_t offset = (y * colorWidth + x) * 4;
+    if (!colorBuf) return Memory::read<uint32_t>(colorAddress + offset);
+    uint32_t value;
+    memcpy(&value, &colorBuf[offset], sizeof(value));
+    return value;
+}
+
+inline void RDP::Band::writeColor16(int x, int y, uint16_t value) {
+    // Write a 16-bit pixel to the color buffer, swizzling its offset within a host-endian word
+    uint32_t offset = (y * colorWidth + x) * 2;
+    if (!colorBuf) return Memory::write<uint16_t>(colorAddress + offset, value);
+    memcpy(&colorBuf[offset ^ 2], &value, sizeof(value));
+}
+
+inline void RDP::Band::writeColor32(int x, int y, uint32_t value) {
+    // Write a 32-bit pixel to the color buffer
+    uint32_t offset = (y * colorWidth + x) * 4;
+    if (!colorBuf) return Memory::write<uint32_t>(colorAddress + offset, value);
+    memcpy(&colorBuf[offset], &value, sizeof(value));
+}
+
+inline uint16_t RDP::Band::readDepth(int x, int y) {
+    // Read a value from the Z buffer, swizzling its offset within a host-endian word
+    uint32_t offset = (y * colorWidth + x) * 2;
+    if (!zBuf) return Memory::read<uint16_t>(zAddress + offset);
+    uint16_t value;
+    memcpy(&value, &zBuf[offset ^ 2], sizeof(value));
+    return value;
+}
+
+inline void RDP::Band::writeDepth(int x, int y, uint16_t value) {
+    // Write a value to the Z buffer, swizzling its offset within a host-endian word
+    uint32_t offset = (y * colorWidth + x) * 2;
+    if (!zBuf) return Memory::write<uint16_t>(zAddress + offset, value);
+    memcpy(&zBuf[offset ^ 2], &value, sizeof(value));
+}
+
+bool RDP::Band::fillRow(int x1, int x2, int y) {
+    // Fill a row with whole words, but only if the color buffer can be accessed directly
+    if (!colorBuf) return false;
+    if (colorFormat != RGBA16) {
+        for (uint32_t offset = (y * colorWidth + x1) * 4; x1 < x2; x1++, offset += 4)
+            memcpy(&colorBuf[offset], &fillColor, sizeof(fillColor));
+        return true;
+    }
+
+    // Fill a leading RGBA16 pixel on its own if it doesn't start a word
+    if (((y * colorWidth + x1) & 0x1) && x1 < x2) {
+        writeColor16(x1, y, fillColor >> ((~x1 & 1) * 16));
+        x1++;
+    }
+
+    // Fill pairs of RGBA16 pixels with whole words, swapping the fill color halves for pairs starting on odd X-coords
+    uint32_t value = (x1 & 1) ? ((fillColor << 16) | (fillColor >> 16)) : fillColor;
+    for (uint32_t offset = (y * colorWidth + x1) * 2; x1 + 1 < x2; x1 += 2, offset += 4)
+        memcpy(&colorBuf[offset], &value, sizeof(value));
+
+    // Fill a trailing RGBA16 pixel on its own if there is one
+    if (x1 < x2)
+        writeColor16(x1, y, fillColor >> ((~x1 & 1) * 16));
+    return true;
+}
+
+bool RDP::Band::copyRow(Tile &tile, int x1, int x2, int y, int s, int t) {
+    // Get the texture coordinates relative to the tile at the start of the row
+    s = ((s >> 5) - tile.s1) >> 5;
+    t = ((t >> 5) - tile.t1) >> 5;
+
+    // Only copy RGBA16 texels to RGBA16 pixels, within one TMEM line and without S-coordinate wrapping
+    int s2 = s + (x2 - x1) - 1;
+    if (tile.format != RGBA16 || colorFormat != RGBA16 || s < 0 || s2 > tile.sMask ||
+        (tile.sClamp && s2 > ((tile.s2 - tile.s1) >> 5)) || (tile.width && s2 * 2 >= tile.width))
+        return false;
+
+    // Clamp, mirror, or mask the T-coordinate based on tile settings
+    if (tile.tClamp) t = std::max<int>(std::min<int>(t, (tile.t2 - tile.t1) >> 5), 0);
+    if (tile.tMirror && (t & (tile.tMask + 1))) t = ~t;
+    t &= tile.tMask;
+
+    // Copy the row of texels as-is, swapping 32-bit words on odd lines and skipping transparent ones if enabled
+    uint32_t address = tile.address + t * tile.width;
+    int swap = tile.width ? ((t & 0x1) << 1) : 0;
+    for (int x = x1; x < x2; x++, s++) {
+        uint8_t *value = &tmem[(address + (s ^ swap) * 2) & 0xFFE];
+        uint16_t color = (value[0] << 8) | value[1];
+        if (!alphaCompare || (color & 0x1))
+            writeColor16(x, y, color);
+    }
+    return true;
+}
+
+bool RDP::Band::testDepth(int x, int y, int z) {
     // Read the existing depth value from memory
-    int m = Memory::read<uint16_t>(zAddress + (y * colorWidth + x) * 2);
+    int m = readDepth(x, y);
 
     // Perform a depth test based on the current mode
     switch (zMode) {
@@ -643,73 +1359,154 @@ bool RDP::testDepth(int x, int y, int z) {
 }
 
 void RDP::finishThread() {
-    // Stop the thread if it was running
-    if (running) {
+    // Stop the threads if they were running, once they finish their queued commands
+    if (!running) return;
+    {
+        std::lock_guard<std::mutex> guard(mutex);
         running = false;
-        thread->join();
-        delete thread;
+        queueCond.notify_all();
+    }
+    for (int i = 0; i < bandCount; i++) {
+        threads[i]->join();
+        delete threads[i];
     }
 }
 
-void RDP::runThreaded() {
+void RDP::finishCommands() {
+    // Wait for every band's thread to process all queued commands
+    if (!running) return;
+    waitProgress([] {
+        for (int i = 0; i < bandCount; i++)
+            if (bands[i].queuePos != queueReady) return false;
+        return true;
+    });
+}
+
+void RDP::runQueue() {
+    // Process queued commands right away when not threaded, stepping all bands in lockstep
+    while (bands[0].queuePos != queueReady) {
+        for (int i = 0; i < bandCount; i++) {
+            Band &band = bands[i];
+            band.opcode = &queue[band.queuePos & 0xFFFF];
+            uint8_t op = (band.opcode[0] >> 56) & 0x3F;
+            (band.*commands[op])();
+            band.queuePos += paramCounts[op];
+        }
+    }
+}
+
+void RDP::runThreaded(Band *band) {
     while (true) {
-        // Parse the next command if one is queued
-        mutex.lock();
-        uint8_t op = opcode.empty() ? 0 : ((opcode[0] >> 56) & 0x3F);
-        uint8_t count = paramCounts[op];
-
-        if (opcode.size() >= count) {
-            // Execute a command once all of its parameters have been queued
-            mutex.unlock();
-            (*commands[op])();
-            mutex.lock();
-            opcode.erase(opcode.begin(), opcode.begin() + count);
-            mutex.unlock();
+        // Sleep until a command is queued, and stop running once the queue is empty if requested
+        uint32_t pos = band->queuePos;
+        if (pos == queueReady) {
+            std::unique_lock<std::mutex> lock(mutex);
+            sleepers++;
+            queueCond.wait(lock, [pos] { return pos != queueReady || !running; });
+            sleepers--;
+            if (pos == queueReady) return;
         }
-        else {
-            // If requested, stop running when the queue is empty
-            mutex.unlock();
-            if (!running) return;
-            std::this_thread::yield();
+
+        // Execute the next command with its parameters read directly from the queue
+        band->opcode = &queue[pos & 0xFFFF];
+        uint8_t op = (band->opcode[0] >> 56) & 0x3F;
+        (band->*commands[op])();
+        band->queuePos = pos + paramCounts[op];
+
+        // Wake anything that's waiting for bands to make progress
+        if (waiters) {
+            std::lock_guard<std::mutex> guard(mutex);
+            doneCond.notify_all();
         }
     }
 }
 
-void RDP::runCommands() {
-    // Start the thread if enabled and not running
-    if (Settings::threadedRdp && !running) {
+void RDP::wakeThreads() {
+    // Wake any threads that are sleeping so they can check for new commands
+    if (sleepers) {
+        std::lock_guard<std::mutex> guard(mutex);
+        queueCond.notify_all();
+    }
+}
+
+template <typename T> void RDP::waitProgress(T done) {
+    // Sleep until a condition is met by bands making progress, letting them know to wake this thread
+    if (done()) return;
+    std::unique_lock<std::mutex> lock(mutex);
+    waiters++;
+    doneCond.wait(lock, done);
+    waiters--;
+}
+
+void RDP::startThread() {
+    // Start a thread for each band if threading is needed and they aren't running
+    if ((Settings::threadedRdp || bandCount > 1) && !running) {
         running = true;
-        thread = new std::thread(runThreaded);
+        for (int i = 0; i < bandCount; i++)
+            threads[i] = new std::thread(runThreaded, &bands[i]);
     }
+}
 
+void RDP::runCommands() {
     // Process RDP commands until the end address is reached
-    mutex.lock();
+    std::lock_guard<std::mutex> guard(sendMutex);
+    startThread();
     while (startAddr < endAddr) {
-        // Add a parameter to the buffer
-        opcode.push_back(Memory::read<uint64_t>(addrBase + (startAddr & addrMask)));
-        paramCount++;
-
-        // Execute a command once all of its parameters have been received
-        // When threaded, only run sync commands here; the rest will run on the thread
-        uint8_t op = (opcode[opcode.size() - paramCount] >> 56) & 0x3F;
-        if (paramCount >= paramCounts[op]) {
-            paramCount = 0;
-            if (!running || op == 0x29) { // Sync Full
-                mutex.unlock();
-                finishThread();
-                mutex.lock();
-                (*commands[op])();
-                opcode.clear();
-            }
-        }
-
-        // Move to the next parameter
+        addParam(Memory::read<uint64_t>(addrBase + (startAddr & addrMask)));
         startAddr += 8;
     }
-    mutex.unlock();
+    submitCommands();
+}
+
+void RDP::sendCommands(const uint64_t *params, size_t count) {
+    // Process RDP commands from a buffer, for microcode that's emulated at a high level
+    std::lock_guard<std::mutex> guard(sendMutex);
+    startThread();
+    for (size_t i = 0; i < count; i++)
+        addParam(params[i]);
+    submitCommands();
+}
+
+void RDP::submitCommands() {
+    // Wait for the threads to finish new commands if they're only used for parallel rendering
+    if (running && !Settings::threadedRdp)
+        finishCommands();
+}
+
+void RDP::addParam(uint64_t param) {
+    // Wait for the slowest band to free up space if the queue is full
+    waitProgress([] {
+        for (int i = 0; i < bandCount; i++)
+            if (queueEnd - bands[i].queuePos >= 0x10000) return false;
+        return true;
+    });
+
+    // Add a parameter to the queue, and track the opcode of the command it belongs to
+    uint32_t index = queueEnd++ & 0xFFFF;
+    queue[index] = param;
+    if (index < 0x20) queue[0x10000 + index] = param;
+    if (paramCount++ == 0)
+        queueOp = (param >> 56) & 0x3F;
+
+    // Publish a command to the bands once all of its parameters have been received
+    if (paramCount < paramCounts[queueOp]) return;
+    queueReady = queueEnd;
+    paramCount = 0;
+
+    // Execute commands right away if not threaded, or wake the threads to process them
+    if (!running)
+        runQueue();
+    else
+        wakeThreads();
+
+    // For sync commands, wait for everything to finish and trigger a DP interrupt
+    if (queueOp == 0x29) { // Sync Full
+        finishCommands();
+        MI::setInterrupt(5);
+    }
 }
 
-template <bool shade, bool texture, bool depth> void RDP::triangle() {
+template <bool shade, bool texture, bool depth> void RDP::Band::triangle() {
     // Decode the base triangle parameters
     int32_t y1 = int16_t(opcode[0] << 2) >> 4; // High Y-coord
     int32_t y2 = int16_t(opcode[0] >> 14) >> 4; // Middle Y-coord
@@ -769,18 +1566,45 @@ template <bool shade, bool texture, bool depth> void RDP::triangle() {
         dzde = (params[1] >> 32);
     }
 
-    // Draw a triangle from top to bottom
-    for (int y = y1; y < y3; y++) {
-        // Get X-bounds between the high and middle edges from Y1 to Y2, or the high and low edges from Y2 to Y3
-        int xa, xb;
+    // Step the edges to the next line, and get X-bounds between the high and middle edges from Y1 to Y2,
+    // or the high and low edges from Y2 to Y3
+    auto stepEdges = [&](int y, int32_t &e1, int32_t &e2, int32_t &e3, int &xa, int &xb) {
         if (orient) {
-            xa = std::min(x2, x2 += slope2) >> 16;
-            xb = (((y < y2) ? std::max(x3, x3 += slope3) : std::max(x1, x1 += slope1)) + 0xFFFF) >> 16;
+            xa = std::min(e2, e2 += slope2) >> 16;
+            xb = (((y < y2) ? std::max(e3, e3 += slope3) : std::max(e1, e1 += slope1)) + 0xFFFF) >> 16;
         }
         else {
-            xa = ((y < y2) ? std::min(x3, x3 += slope3) : std::min(x1, x1 += slope1)) >> 16;
-            xb = (std::max(x2, x2 += slope2) + 0xFFFF) >> 16;
+            xa = ((y < y2) ? std::min(e3, e3 += slope3) : std::min(e1, e1 += slope1)) >> 16;
+            xb = (std::max(e2, e2 += slope2) + 0xFFFF) >> 16;
+        }
+    };
+
+    // Check if perspective correction can skip texel updates on any line, if the texel is read and there are bands
+    // Pixels with a W-coord below 0x8000 keep the previous texel, which might not be on the same line
+    bool gaps = false;
+    if (texture && persCorrect && bandCount > 1 && (readValues() & CARRY_TEXEL)) {
+        int32_t e1 = x1, e2 = x2, e3 = x3, we = w1;
+        for (int y = y1; y < y3 && !gaps; y++) {
+            int xa, xb;
+            stepEdges(y, e1, e2, e3, xa, xb);
+            int32_t wl = (we += dwde) - dwdx * ((xb - xa - 1) * !orient);
+            int cx1 = std::max<int>(xa, scissorX1), cx2 = std::min<int>(xb, scissorX2);
+            if (y < scissorY1 || y >= scissorY2 || cx1 >= cx2) continue;
+
+            // Check the W-coords at both ends of the clipped line, assuming the worst if they could wrap in between
+            int64_t wStart = int64_t(wl) + int64_t(dwdx) * (cx1 - xa);
+            int64_t wEnd = int64_t(wl) + int64_t(dwdx) * (cx2 - 1 - xa);
+            int64_t lo = std::min(wStart, wEnd), hi = std::max(wStart, wEnd);
+            gaps = (lo < INT32_MIN || hi > INT32_MAX || (lo < 0x8000 && hi >= 0));
         }
+    }
+
+    // Draw a triangle from top to bottom
+    startDraw(y1, y3, (shade ? CARRY_SHADE : 0) | (texture ? CARRY_TEXEL : 0), gaps);
+    mapBuffers(y1, y3);
+    for (int y = y1; y < y3; y++) {
+        int xa, xb;
+        stepEdges(y, x1, x2, x3, xa, xb);
 
         // Get the interpolated values at the start of the line
         int offset = (xb - xa - 1) * !orient;
@@ -793,48 +1617,84 @@ template <bool shade, bool texture, bool depth> void RDP::triangle() {
         if (texture) wa = (w1 += dwde) - dwdx * offset;
         if (depth) za = (z1 += dzde) - dzdx * offset;
 
-        // Draw a line of the triangle from left to right
-        for (int x = xa; x < xb; x++) {
-            // Draw a pixel if within scissor bounds and the depth test passes
-            if (x >= scissorX1 && x < scissorX2 && y >= scissorY1 && y < scissorY2 &&
-                (!depth || !zCompare || testDepth(x, y, za >> 16))) {
+        // Skip drawing lines that belong to other bands or are outside scissor bounds
+        if (!ownsLine(y) || y < scissorY1 || y >= scissorY2) continue;
+        startLine(y);
+
+        // Clip the line to scissor bounds, and get the values interpolated to the first 4 pixels
+        int x1 = std::max<int>(xa, scissorX1), x2 = std::min<int>(xb, scissorX2);
+        alignas(16) int32_t r[4], g[4], b[4], a[4], s[4], t[4], w[4], z[4];
+        for (int i = 0, skip = x1 - xa; i < 4; i++) {
+            if (shade) r[i] = ra + uint32_t(drdx) * (skip + i);
+            if (shade) g[i] = ga + uint32_t(dgdx) * (skip + i);
+            if (shade) b[i] = ba + uint32_t(dbdx) * (skip + i);
+            if (shade) a[i] = aa + uint32_t(dadx) * (skip + i);
+            if (texture) s[i] = sa + uint32_t(dsdx) * (skip + i);
+            if (texture) t[i] = ta + uint32_t(dtdx) * (skip + i);
+            if (texture) w[i] = wa + uint32_t(dwdx) * (skip + i);
+            if (depth) z[i] = za + uint32_t(dzdx) * (skip + i);
+        }
+
+        // Read depth values ahead of drawing unless the Z buffer overlaps the part of the color buffer being drawn
+        uint32_t bpp = (colorFormat == RGBA16) ? 2 : 4;
+        uint32_t color1 = (colorAddress & 0xFFFFFF) + (y * colorWidth + x1) * bpp;
+        uint32_t depth1 = (zAddress & 0xFFFFFF) + (y * colorWidth + x1) * 2;
+        bool batch = (color1 >= depth1 + (x2 - x1) * 2 || depth1 >= color1 + (x2 - x1) * bpp);
+
+        // Draw the line from left to right in batches of 4 pixels, with the last batch covering any remainder
+        for (int x = x1; x < x2; x += 4) {
+            // Interpolate shade colors and compare depth values for the whole batch
+            int count = std::min(4, x2 - x);
+            alignas(16) uint32_t colors[4];
+            alignas(8) uint16_t m[4] = {};
+            int pass = 0xF;
+            if (shade) shade4(colors, r, g, b, a);
+            if (depth && zCompare && batch) {
+                for (int i = 0; i < count; i++)
+                    m[i] = readDepth(x + i, y);
+                pass = depth4(z, m, zMode == 3);
+            }
+
+            for (int i = 0; i < count; i++) {
+                // Draw a pixel if the depth test passes
+                if (depth && zCompare && (batch ? !(pass & (1 << i)) : !testDepth(x + i, y, z[i] >> 16)))
+                    continue;
+
                 // Update the shade color for the current pixel
                 if (shade) {
-                    uint8_t r = std::max(0x00, std::min(0xFF, ra >> 16));
-                    uint8_t g = std::max(0x00, std::min(0xFF, ga >> 16));
-                    uint8_t b = std::max(0x00, std::min(0xFF, ba >> 16));
-                    uint8_t a = std::max(0x00, std::min(0xFF, aa >> 16));
-                    shadeColor = (r << 24) | (g << 16) | (b << 8) | a;
+                    shadeColor = colors[i];
                     shadeAlpha = colorToAlpha(shadeColor);
+                    shadeStamp = lineStamp;
                 }
 
                 // Update the texel color for the current pixel, with perspective correction
                 if (texture) {
-                    if (int div = persCorrect ? (wa >> 15) : 0x10000) {
-                        texelColor = getTexel(*tile, sa / div, ta / div);
+                    if (int div = persCorrect ? (w[i] >> 15) : 0x10000) {
+                        texelColor = getTexel(*tile, s[i] / div, t[i] / div);
                         texelAlpha = colorToAlpha(texelColor);
+                        texelStamp = lineStamp;
                     }
                 }
 
                 // Update the Z buffer if a pixel is drawn
-                if (drawPixel(x, y) && depth && zUpdate)
-                    Memory::write<uint16_t>(zAddress + (y * colorWidth + x) * 2, za >> 16);
+                if ((this->*pixelFunc)(x + i, y) && depth && zUpdate)
+                    writeDepth(x + i, y, z[i] >> 16);
             }
 
-            // Interpolate the values across the line
-            if (shade) ra += drdx;
-            if (shade) ga += dgdx;
-            if (shade) ba += dbdx;
-            if (shade) aa += dadx;
-            if (texture) sa += dsdx;
-            if (texture) ta += dtdx;
-            if (texture) wa += dwdx;
-            if (depth) za += dzdx;
+            // Interpolate the values to the next 4 pixels
+            if (shade) step4(r, uint32_t(drdx) * 4);
+            if (shade) step4(g, uint32_t(dgdx) * 4);
+            if (shade) step4(b, uint32_t(dbdx) * 4);
+            if (shade) step4(a, uint32_t(dadx) * 4);
+            if (texture) step4(s, uint32_t(dsdx) * 4);
+            if (texture) step4(t, uint32_t(dtdx) * 4);
+            if (texture) step4(w, uint32_t(dwdx) * 4);
+            if (depth) step4(z, uint32_t(dzdx) * 4);
         }
     }
 }
 
-void RDP::texRectangle() {
+void RDP::Band::texRectangle() {
     // Decode the operands
     Tile &tile = tiles[(opcode[0] >> 24) & 0x7];
     uint16_t y1 = ((opcode[0] >>  0) & 0xFFF) >> 2;
@@ -853,34 +1713,54 @@ void RDP::texRectangle() {
         y2++;
     }
 
-    // Draw a rectangle using a texture
+    // Draw a rectangle using a texture, skipping lines that belong to other bands
+    startDraw(y1, y2, CARRY_TEXEL, false);
+    mapBuffers(y1, y2);
     for (int y = y1, t = t1; y < y2; y++, t += dtdy) {
+        if (!ownsLine(y)) continue;
+        startLine(y);
+
+        // Copy unscaled rows of texels directly in copy mode if possible, clipped to scissor bounds
+        // The last texel is still fetched, since it carries over to later pixels like when drawn normally
+        if (cycleType == COPY_MODE && dsdx == 0x400 && y >= scissorY1 && y < scissorY2) {
+            int cx1 = std::max<int>(x1, scissorX1), cx2 = std::min<int>(x2, scissorX2);
+            if (cx1 >= cx2)
+                continue;
+            if (copyRow(tile, cx1, cx2, y, s1 + (cx1 - x1) * dsdx, t)) {
+                texelColor = getTexel(tile, (s1 + (cx2 - 1 - x1) * dsdx) >> 5, t >> 5, true);
+                texelAlpha = colorToAlpha(texelColor);
+                texelStamp = lineStamp;
+                continue;
+            }
+        }
+
         for (int x = x1, s = s1; x < x2; x++, s += dsdx) {
             // Draw a pixel if it's within scissor bounds
             if (x >= scissorX1 && x < scissorX2 && y >= scissorY1 && y < scissorY2) {
                 texelColor = getTexel(tile, s >> 5, t >> 5, true);
                 texelAlpha = colorToAlpha(texelColor);
-                drawPixel(x, y);
+                texelStamp = lineStamp;
+                (this->*pixelFunc)(x, y);
             }
         }
     }
 }
 
-void RDP::syncFull() {
-    // Trigger a DP interrupt right away because everything finishes instantly
-    MI::setInterrupt(5);
+void RDP::Band::syncFull() {
+    // Do nothing; the DP interrupt is triggered once all bands have finished
 }
 
-void RDP::setScissor() {
+void RDP::Band::setScissor() {
     // Set the scissor bounds
     // TODO: actually use the scissor field bits
     scissorY2 = ((opcode[0] >>  0) & 0xFFF) >> 2;
     scissorX2 = ((opcode[0] >> 12) & 0xFFF) >> 2;
     scissorY1 = ((opcode[0] >> 32) & 0xFFF) >> 2;
     scissorX1 = ((opcode[0] >> 44) & 0xFFF) >> 2;
+    updateWrap();
 }
 
-void RDP::setOtherModes() {
+void RDP::Band::setOtherModes() {
     // Set various rendering parameters
     // TODO: actually use the other bits
     cycleType = (CycleType)((opcode[0] >> 52) & 0x3);
@@ -899,15 +1779,18 @@ void RDP::setOtherModes() {
     zUpdate = (opcode[0] >> 5) & 0x1;
     zCompare = (opcode[0] >> 4) & 0x1;
     alphaCompare = (opcode[0] >> 0) & 0x1;
+    updatePixel();
 }
 
-void RDP::loadTlut() {
+void RDP::Band::loadTlut() {
     // Decode the operands and set texture coordinate bounds
     Tile &tile = tiles[(opcode[0] >> 24) & 0x7];
     uint16_t s1 = (tile.s1 = ((opcode[0] >> 44) & 0xFFF) << 3) >> 4;
     uint16_t t1 = (tile.t1 = ((opcode[0] >> 32) & 0xFFF) << 3) >> 4;
     uint16_t s2 = (tile.s2 = ((opcode[0] >> 12) & 0xFFF) << 3) >> 4;
     uint16_t t2 = (tile.t2 = ((opcode[0] >> 0) & 0xFFF) << 3) >> 4;
+    checkHazard(texAddress + s1, texAddress + s2 + 2);
+    invalidateTiles();
 
     // Copy 16-bit texture lookup values into TMEM, duplicated 4 times
     // TODO: actually use T-coordinates?
@@ -921,16 +1804,56 @@ void RDP::loadTlut() {
     }
 }
 
-void RDP::setTileSize() {
+void RDP::Band::invalidateTile(Tile &tile) {
+    // Cache coordinates up to the S-mask, or the clamp bounds or a TMEM line if there's no mask
+    int width;
+    if (tile.sMask != 0xFFFF)
+        width = tile.sMask + 1;
+    else if (tile.sClamp)
+        width = ((tile.s2 - tile.s1) >> 5) + 1;
+    else
+        width = (tile.width * 2) >> (tile.format & 0x3);
+
+    // Fit as many lines as possible in the cache, which limits its width if necessary
+    tile.cacheWidth = std::max(0, std::min<int>(width, 0x1000));
+    tile.cacheHeight = tile.cacheWidth ? (0x1000 / tile.cacheWidth) : 0;
+
+    // Move to a new generation so previously cached texels are invalid, resetting them all on overflow
+    if (!++tile.cacheGen) {
+        memset(tile.texelGens, 0, sizeof(tile.texelGens));
+        tile.cacheGen = 1;
+    }
+}
+
+void RDP::Band::invalidateTiles() {
+    // Invalidate the caches of all tiles, such as when TMEM changes
+    for (int i = 0; i < 8; i++)
+        invalidateTile(tiles[i]);
+}
+
+void RDP::Band::setTileSize() {
     // Set the texture coordinate bounds
     Tile &tile = tiles[(opcode[0] >> 24) & 0x7];
     tile.s1 = ((opcode[0] >> 44) & 0xFFF) << 3;
     tile.t1 = ((opcode[0] >> 32) & 0xFFF) << 3;
     tile.s2 = ((opcode[0] >> 12) & 0xFFF) << 3;
     tile.t2 = ((opcode[0] >> 0) & 0xFFF) << 3;
+    invalidateTile(tile);
 }
 
-void RDP::loadBlock() {
+void RDP::Band::loadRow(const uint8_t *src, uint32_t offset, uint32_t address, uint32_t size, bool odd) {
+    // Copy a row of bytes from host-endian words to TMEM, 16 at a time if word-aligned and TMEM doesn't wrap
+    uint32_t i = 0;
+    if (!(offset & 0x3))
+        for (; i + 16 <= size && ((address + i) & 0xFFF) <= 0xFF0; i += 16)
+            copyTmem16(&tmem[(address + i) & 0xFFF], &src[offset + i], odd);
+
+    // Copy any remaining bytes one at a time, swapping 32-bit words on odd lines
+    for (; i < size; i++)
+        tmem[((address + i) ^ (odd << 2)) & 0xFFF] = src[(offset + i) ^ 3];
+}
+
+void RDP::Band::loadBlock() {
     // Decode the operands and set texture coordinate bounds
     Tile &tile = tiles[(opcode[0] >> 24) & 0x7];
     uint16_t s1 = (tile.s1 = ((opcode[0] >> 44) & 0xFFF) << 3) >> 1;
@@ -942,12 +1865,25 @@ void RDP::loadBlock() {
     uint16_t count = (s2 - s1) >> (~texFormat & 0x3);
     uint16_t d = 0;
     bool odd = false;
+    checkHazard(texAddress, texAddress + count + 16);
+    invalidateTiles();
+
+    // Get a host pointer to the texture data if it's word-aligned and can be read directly
+    const uint8_t *base = (texAddress & 0x3) ? nullptr : Memory::getRdram(texAddress & 0xFFFFFF, count + 16);
 
     // Copy texture data from the texture buffer to TMEM
     if ((texFormat & 0x3) == 0x3) { // 32-bit
         for (int i = 0; i <= count; i += 8) {
             // Read 8 bytes of texture data, swapping the 32-bit halves on odd lines
-            uint64_t src = Memory::read<uint64_t>(texAddress + (i ^ (odd << 3)));
+            uint64_t src;
+            if (base) {
+                uint32_t words[2];
+                memcpy(words, &base[i ^ (odd << 3)], sizeof(words));
+                src = ((uint64_t)words[0] << 32) | words[1];
+            }
+            else {
+                src = Memory::read<uint64_t>(texAddress + (i ^ (odd << 3)));
+            }
 
             // Write 8 bytes of texture data to TMEM, split across high and low banks
             uint8_t *dstL = &tmem[(tile.address + 0x000 + i / 2) & 0xFFC];
@@ -965,6 +1901,25 @@ void RDP::loadBlock() {
                 odd = !odd;
         }
     }
+    else if (base) {
+        for (int i = 0; i <= count; i += 8) {
+            // Copy 16 bytes at once if the next 8 are on the same line and TMEM doesn't wrap, or 8 otherwise
+            uint8_t *dst = &tmem[(tile.address + i) & 0xFF8];
+            if (i + 8 <= count && !((d ^ uint16_t(d + dxt)) & 0x800) && dst <= &tmem[0xFF0]) {
+                copyTmem16(dst, &base[i], odd);
+                d += dxt;
+                i += 8;
+            }
+            else {
+                copyTmem8(dst, &base[i], odd);
+            }
+
+            // Move to the next line when the counter overflows
+            uint16_t d2 = d;
+            if (((d += dxt) ^ d2) & 0x800)
+                odd = !odd;
+        }
+    }
     else {
         for (int i = 0; i <= count; i += 8) {
             // Read 8 bytes of texture data, swapping the 32-bit halves on odd lines
@@ -984,13 +1939,14 @@ void RDP::loadBlock() {
     }
 }
 
-void RDP::loadTile() {
+void RDP::Band::loadTile() {
     // Decode the operands and set texture coordinate bounds
     Tile &tile = tiles[(opcode[0] >> 24) & 0x7];
     uint16_t s1 = (tile.s1 = ((opcode[0] >> 44) & 0xFFF) << 3) >> 5;
     uint16_t t1 = (tile.t1 = ((opcode[0] >> 32) & 0xFFF) << 3) >> 5;
     uint16_t s2 = (tile.s2 = ((opcode[0] >> 12) & 0xFFF) << 3) >> 5;
     uint16_t t2 = (tile.t2 = ((opcode[0] >> 0) & 0xFFF) << 3) >> 5;
+    invalidateTiles();
 
     // Only support loading textures without conversion for now
     if (texFormat != tile.format) {
@@ -998,6 +1954,23 @@ void RDP::loadTile() {
         return;
     }
 
+    // Make sure the lines being loaded aren't still being drawn
+    uint32_t stride = (texWidth << (texFormat & 0x3)) >> 1;
+    checkHazard(texAddress + t1 * stride, texAddress + (t2 + 1) * stride + 4);
+
+    // Copy rows of texels in bulk if the texture data is word-aligned and can be read directly
+    // Texel offsets and row sizes are converted to bytes, with 4-bit rows copied a byte per 2 texels
+    uint8_t size = texFormat & 0x3;
+    uint32_t rowSize = (s2 >= s1) ? ((((s2 - s1) << size) >> 1) + (size ? (1 << (size - 1)) : 1)) : 0;
+    uint32_t end = (((t2 * texWidth + s1) << size) >> 1) + rowSize;
+    if (size != 0x3 && t2 >= t1 && rowSize && !(texAddress & 0x3)) {
+        if (const uint8_t *base = Memory::getRdram(texAddress & 0xFFFFFF, end)) {
+            for (int t = t1; t <= t2; t++)
+                loadRow(base, ((t * texWidth + s1) << size) >> 1, tile.address + (t - t1) * tile.width, rowSize, (t - t1) & 0x1);
+            return;
+        }
+    }
+
     switch (texFormat & 0x3) {
     case 0x0: // 4-bit
         // Cut out a 4-bit texture from the texture buffer and copy it to TMEM
@@ -1050,7 +2023,7 @@ void RDP::loadTile() {
     }
 }
 
-void RDP::setTile() {
+void RDP::Band::setTile() {
     // Set parameters for the specified tile
     // TODO: Actually use the detail shifts
     Tile &tile = tiles[(opcode[0] >> 24) & 0x7];
@@ -1064,9 +2037,10 @@ void RDP::setTile() {
     tile.address = (opcode[0] >> 29) & 0xFF8;
     tile.width = (opcode[0] >> 38) & 0xFF8;
     tile.format = (Format)((opcode[0] >> 51) & 0x1F);
+    invalidateTile(tile);
 }
 
-void RDP::fillRectangle() {
+void RDP::Band::fillRectangle() {
     // Decode the operands
     uint16_t y1 = ((opcode[0] >>  0) & 0xFFF) >> 2;
     uint16_t x1 = ((opcode[0] >> 12) & 0xFFF) >> 2;
@@ -1085,185 +2059,148 @@ void RDP::fillRectangle() {
     y1 = std::max(y1, scissorY1);
     y2 = std::min(y2, scissorY2);
 
-    // Draw a rectangle
-    for (int y = y1; y < y2; y++)
+    // Draw a rectangle, skipping lines that belong to other bands
+    startDraw(y1, y2, 0, false);
+    mapBuffers(y1, y2);
+    for (int y = y1; y < y2; y++) {
+        if (!ownsLine(y)) continue;
+        startLine(y);
+
+        // Fill whole rows directly in fill mode if possible
+        if (cycleType == FILL_MODE && fillRow(x1, x2, y))
+            continue;
+
         for (int x = x1; x < x2; x++)
-            drawPixel(x, y);
+            (this->*pixelFunc)(x, y);
+    }
 }
 
-void RDP::setFillColor() {
+void RDP::Band::setFillColor() {
     // Set the fill color
     fillColor = opcode[0];
 }
 
-void RDP::setFogColor() {
+void RDP::Band::setFogColor() {
     // Set the fog color
     fogColor = opcode[0];
 }
 
-void RDP::setBlendColor() {
+void RDP::Band::setBlendColor() {
     // Set the blend color
     blendColor = opcode[0];
 }
 
-void RDP::setPrimColor() {
+void RDP::Band::setPrimColor() {
     // Set the primitive color
     // TODO: actually use LOD bits
     primColor = opcode[0];
     primAlpha = colorToAlpha(primColor);
 }
 
-void RDP::setEnvColor() {
+void RDP::Band::setEnvColor() {
     // Set the environment color
     envColor = opcode[0];
     envAlpha = colorToAlpha(envColor);
 }
 
-void RDP::setCombine() {
+void RDP::Band::setCombine() {
+    // Map combiner source values to inputs, with unimplemented sources falling back to constants
+    static uint32_t Band::*const rgbA[16] = {
+        &Band::combColor, &Band::texelColor, &Band::texelColor, &Band::primColor,
+        &Band::shadeColor, &Band::envColor, &Band::maxColor, &Band::maxColor,
+        &Band::minColor, &Band::minColor, &Band::minColor, &Band::minColor,
+        &Band::minColor, &Band::minColor, &Band::minColor, &Band::minColor
+    };
+    static uint32_t Band::*const rgbB[16] = {
+        &Band::combColor, &Band::texelColor, &Band::texelColor, &Band::primColor,
+        &Band::shadeColor, &Band::envColor, &Band::minColor, &Band::minColor,
+        &Band::minColor, &Band::minColor, &Band::minColor, &Band::minColor,
+        &Band::minColor, &Band::minColor, &Band::minColor, &Band::minColor
+    };
+    static uint32_t Band::*const rgbC[32] = {
+        &Band::combColor, &Band::texelColor, &Band::texelColor, &Band::primColor,
+        &Band::shadeColor, &Band::envColor, &Band::maxColor, &Band::combAlpha,
+        &Band::texelAlpha, &Band::texelAlpha, &Band::primAlpha, &Band::shadeAlpha,
+        &Band::envAlpha, &Band::maxColor, &Band::maxColor, &Band::maxColor,
+        &Band::minColor, &Band::minColor, &Band::minColor, &Band::minColor,
+        &Band::minColor, &Band::minColor, &Band::minColor, &Band::minColor,
+        &Band::minColor, &Band::minColor, &Band::minColor, &Band::minColor,
+        &Band::minColor, &Band::minColor, &Band::minColor, &Band::minColor
+    };
+    static uint32_t Band::*const rgbD[8] = {
+        &Band::combColor, &Band::texelColor, &Band::texelColor, &Band::primColor,
+        &Band::shadeColor, &Band::envColor, &Band::maxColor, &Band::minColor
+    };
+    static uint32_t Band::*const alphaABD[8] = {
+        &Band::combAlpha, &Band::texelAlpha, &Band::texelAlpha, &Band::primAlpha,
+        &Band::shadeAlpha, &Band::envAlpha, &Band::maxColor, &Band::minColor
+    };
+    static uint32_t Band::*const alphaC[8] = {
+        &Band::maxColor, &Band::texelAlpha, &Band::texelAlpha, &Band::primAlpha,
+        &Band::shadeAlpha, &Band::envAlpha, &Band::maxColor, &Band::minColor
+    };
+
     for (int i = 0; i < 2; i++) {
-        // Set the A input for color combiner RGB components
+        // Set the inputs for color combiner RGB components
         static const uint8_t shiftsA[2] = { 52, 37 };
-        switch (uint8_t srcA = (opcode[0] >> shiftsA[i]) & 0xF) {
-            case 0: combineA[i] = &combColor; break;
-            case 1: combineA[i] = &texelColor; break;
-            case 2: combineA[i] = &texelColor; break;
-            case 3: combineA[i] = &primColor; break;
-            case 4: combineA[i] = &shadeColor; break;
-            case 5: combineA[i] = &envColor; break;
-            case 6: combineA[i] = &maxColor; break;
-            default: combineA[i] = &minColor; break;
-
-        case 7:
-            LOG_WARN("Unimplemented CC cycle %d RGB source A: %d\n", i, srcA);
-            combineA[i] = &maxColor;
-            break;
-        }
-
-        // Set the B input for color combiner RGB components
         static const uint8_t shiftsB[2] = { 28, 24 };
-        switch (uint8_t srcB = (opcode[0] >> shiftsB[i]) & 0xF) {
-            case 0: combineB[i] = &combColor; break;
-            case 1: combineB[i] = &texelColor; break;
-            case 2: combineB[i] = &texelColor; break;
-            case 3: combineB[i] = &primColor; break;
-            case 4: combineB[i] = &shadeColor; break;
-            case 5: combineB[i] = &envColor; break;
-            default: combineB[i] = &minColor; break;
-
-        case 6: case 7:
-            LOG_WARN("Unimplemented CC cycle %d RGB source B: %d\n", i, srcB);
-            combineB[i] = &minColor;
-            break;
-        }
-
-        // Set the C input for color combiner RGB components
         static const uint8_t shiftsC[2] = { 47, 32 };
-        switch (uint8_t srcC = (opcode[0] >> shiftsC[i]) & 0x1F) {
-            case 0: combineC[i] = &combColor; break;
-            case 1: combineC[i] = &texelColor; break;
-            case 2: combineC[i] = &texelColor; break;
-            case 3: combineC[i] = &primColor; break;
-            case 4: combineC[i] = &shadeColor; break;
-            case 5: combineC[i] = &envColor; break;
-            case 7: combineC[i] = &combAlpha; break;
-            case 8: combineC[i] = &texelAlpha; break;
-            case 9: combineC[i] = &texelAlpha; break;
-            case 10: combineC[i] = &primAlpha; break;
-            case 11: combineC[i] = &shadeAlpha; break;
-            case 12: combineC[i] = &envAlpha; break;
-            default: combineC[i] = &minColor; break;
-
-        case 6: case 13: case 14: case 15:
-            LOG_WARN("Unimplemented CC cycle %d RGB source C: %d\n", i, srcC);
-            combineC[i] = &maxColor;
-            break;
-        }
-
-        // Set the D input for color combiner RGB components
         static const uint8_t shiftsD[2] = { 15, 6 };
-        switch ((opcode[0] >> shiftsD[i]) & 0x7) {
-            case 0: combineD[i] = &combColor; break;
-            case 1: combineD[i] = &texelColor; break;
-            case 2: combineD[i] = &texelColor; break;
-            case 3: combineD[i] = &primColor; break;
-            case 4: combineD[i] = &shadeColor; break;
-            case 5: combineD[i] = &envColor; break;
-            case 6: combineD[i] = &maxColor; break;
-            default: combineD[i] = &minColor; break;
-        }
+        uint8_t srcA = (opcode[0] >> shiftsA[i]) & 0xF;
+        uint8_t srcB = (opcode[0] >> shiftsB[i]) & 0xF;
+        uint8_t srcC = (opcode[0] >> shiftsC[i]) & 0x1F;
+        combineA[i] = &(this->*rgbA[srcA]);
+        combineB[i] = &(this->*rgbB[srcB]);
+        combineC[i] = &(this->*rgbC[srcC]);
+        combineD[i] = &(this->*rgbD[(opcode[0] >> shiftsD[i]) & 0x7]);
+
+        // Warn about RGB sources that aren't implemented
+        if (srcA == 7)
+            LOG_WARN("Unimplemented CC cycle %d RGB source A: %d\n", i, srcA);
+        if (srcB == 6 || srcB == 7)
+            LOG_WARN("Unimplemented CC cycle %d RGB source B: %d\n", i, srcB);
+        if (srcC == 6 || (srcC >= 13 && srcC <= 15))
+            LOG_WARN("Unimplemented CC cycle %d RGB source C: %d\n", i, srcC);
     }
 
     for (int i = 2; i < 4; i++) {
-        // Set the A input for color combiner alpha components
+        // Set the inputs for color combiner alpha components
         static const uint8_t shiftsA[2] = { 44, 21 };
-        switch ((opcode[0] >> shiftsA[i - 2]) & 0x7) {
-            case 0: combineA[i] = &combAlpha; break;
-            case 1: combineA[i] = &texelAlpha; break;
-            case 2: combineA[i] = &texelAlpha; break;
-            case 3: combineA[i] = &primAlpha; break;
-            case 4: combineA[i] = &shadeAlpha; break;
-            case 5: combineA[i] = &envAlpha; break;
-            case 6: combineA[i] = &maxColor; break;
-            default: combineA[i] = &minColor; break;
-        }
-
-        // Set the B input for color combiner alpha components
         static const uint8_t shiftsB[2] = { 12, 3 };
-        switch ((opcode[0] >> shiftsB[i - 2]) & 0x7) {
-            case 0: combineB[i] = &combAlpha; break;
-            case 1: combineB[i] = &texelAlpha; break;
-            case 2: combineB[i] = &texelAlpha; break;
-            case 3: combineB[i] = &primAlpha; break;
-            case 4: combineB[i] = &shadeAlpha; break;
-            case 5: combineB[i] = &envAlpha; break;
-            case 6: combineB[i] = &maxColor; break;
-            default: combineB[i] = &minColor; break;
-        }
-
-        // Set the C input for color combiner alpha components
         static const uint8_t shiftsC[2] = { 41, 18 };
-        switch (uint8_t srcC = (opcode[0] >> shiftsC[i - 2]) & 0x7) {
-            case 1: combineC[i] = &texelAlpha; break;
-            case 2: combineC[i] = &texelAlpha; break;
-            case 3: combineC[i] = &primAlpha; break;
-            case 4: combineC[i] = &shadeAlpha; break;
-            case 5: combineC[i] = &envAlpha; break;
-            default: combineC[i] = &minColor; break;
-
-        case 0: case 6:
-            LOG_WARN("Unimplemented CC cycle %d alpha source C: %d\n", i, srcC);
-            combineC[i] = &maxColor;
-            break;
-        }
-
-        // Set the D input for color combiner alpha components
         static const uint8_t shiftsD[2] = { 9, 0 };
-        switch ((opcode[0] >> shiftsD[i - 2]) & 0x7) {
-            case 0: combineD[i] = &combAlpha; break;
-            case 1: combineD[i] = &texelAlpha; break;
-            case 2: combineD[i] = &texelAlpha; break;
-            case 3: combineD[i] = &primAlpha; break;
-            case 4: combineD[i] = &shadeAlpha; break;
-            case 5: combineD[i] = &envAlpha; break;
-            case 6: combineD[i] = &maxColor; break;
-            default: combineD[i] = &minColor; break;
-        }
+        uint8_t srcC = (opcode[0] >> shiftsC[i - 2]) & 0x7;
+        combineA[i] = &(this->*alphaABD[(opcode[0] >> shiftsA[i - 2]) & 0x7]);
+        combineB[i] = &(this->*alphaABD[(opcode[0] >> shiftsB[i - 2]) & 0x7]);
+        combineC[i] = &(this->*alphaC[srcC]);
+        combineD[i] = &(this->*alphaABD[(opcode[0] >> shiftsD[i - 2]) & 0x7]);
+
+        // Warn about alpha sources that aren't implemented
+        if (srcC == 0 || srcC == 6)
+            LOG_WARN("Unimplemented CC cycle %d alpha source C: %d\n", i, srcC);
     }
+    updatePixel();
 }
 
-void RDP::setTexImage() {
+void RDP::Band::setTexImage() {
     // Set the texture buffer parameters
     texAddress = 0xA0000000 + (opcode[0] & 0xFFFFFF);
     texWidth = ((opcode[0] >> 32) & 0x3FF) + 1;
     texFormat = (Format)((opcode[0] >> 51) & 0x1F);
 }
 
-void RDP::setZImage() {
+void RDP::Band::setZImage() {
+    // Sync the bands before switching buffers, in case the new one overlaps lines drawn by other bands
+    checkHazard(0x00000000, 0xFFFFFFFF);
+
     // Set the Z buffer parameters
     zAddress = 0xA0000000 + (opcode[0] & 0xFFFFFF);
 }
 
-void RDP::setColorImage() {
+void RDP::Band::setColorImage() {
+    // Sync the bands before switching buffers, in case the new one overlaps lines drawn by other bands
+    checkHazard(0x00000000, 0xFFFFFFFF);
+
     // Set the color buffer parameters
     colorAddress = 0xA0000000 + (opcode[0] & 0xFFFFFF);
     colorWidth = ((opcode[0] >> 32) & 0x3FF) + 1;
@@ -1273,9 +2210,11 @@ void RDP::setColorImage() {
         LOG_CRIT("Unknown RDP color buffer format: %d\n", colorFormat);
         colorFormat = RGBA16;
     }
+    updateWrap();
+    updatePixel();
 }
 
-void RDP::unknown() {
+void RDP::Band::unknown() {
     // Warn about unknown commands
     LOG_CRIT("Unknown RDP opcode: 0x%016lX\n", opcode[0]);
 }
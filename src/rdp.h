@@ -19,11 +19,14 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 
 namespace RDP {
     void reset();
     uint32_t read(int index);
     void write(int index, uint32_t value);
+    void sendCommands(const uint64_t *params, size_t count);
+    void finishCommands();
     void finishThread();
 }
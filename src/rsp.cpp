@@ -32,10 +32,6 @@ namespace RSP {
     uint32_t programCounter;
     uint32_t nextOpcode;
 
-    extern void (*immInstrs[])(uint32_t);
-    extern void (*regInstrs[])(uint32_t);
-    extern void (*extInstrs[])(uint32_t);
-
     void j(uint32_t opcode);
     void jal(uint32_t opcode);
     void beq(uint32_t opcode);
@@ -174,6 +170,11 @@ void RSP::setState(bool halted) {
     Core::rspRunning = !halted;
 }
 
+bool RSP::needsSync() {
+    // Check if the next opcode accesses state outside the RSP, which is the case for COP0 moves and breaks
+    return (nextOpcode >> 26) == 0x10 || (nextOpcode & 0xFC00003F) == 0xD;
+}
+
 void RSP::runOpcode() {
     // Move an opcode through the pipeline
     uint32_t opcode = nextOpcode;
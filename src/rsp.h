@@ -22,9 +22,18 @@
 #include <cstdint>
 
 namespace RSP {
+    extern uint32_t registersR[33];
+    extern uint32_t programCounter;
+    extern uint32_t nextOpcode;
+
+    extern void (*immInstrs[])(uint32_t);
+    extern void (*regInstrs[])(uint32_t);
+    extern void (*extInstrs[])(uint32_t);
+
     void reset();
     uint32_t readPC();
     void writePC(uint32_t value);
     void setState(bool halted);
+    bool needsSync();
     void runOpcode();
 }
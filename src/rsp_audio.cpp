@@ -0,0 +1,563 @@
+/*
+    Copyright 2022-2026 Hydr8gon
+
+    This file is part of rokuyon.
+
+    rokuyon is free software: you can redistribute it and/or modify it
+    under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    rokuyon is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with rokuyon. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cstring>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "rsp_audio.h"
+#include "log.h"
+#include "memory.h"
+
+// Flags used by audio commands
+#define A_INIT 0x01
+#define A_LOOP 0x02
+#define A_LEFT 0x02
+#define A_VOL 0x04
+#define A_AUX 0x08
+
+// Offset that the microcode adds to DMEM buffer addresses
+#define DMEM_BASE 0x5C0
+
+struct Ramp {
+    int32_t value;
+    int32_t target;
+    int32_t step;
+};
+
+namespace RSP_AUDIO {
+    alignas(16) int16_t dmem[0x2000];
+    uint32_t segments[16];
+
+    uint16_t inAddr, outAddr, count;
+    uint16_t dryRight, wetLeft, wetRight;
+    int16_t dry, wet;
+    int16_t volume[2];
+    int16_t target[2];
+    int32_t rate[2];
+    uint32_t loopAddr;
+
+    int16_t adpcmBook[0x100];
+    alignas(16) int16_t adpcmCoeffs[16][10][8];
+    int16_t resampleLut[0x100];
+    uint32_t lutSource = -1;
+
+    bool checkList(uint32_t dataPtr, uint32_t dataSize);
+    int16_t *samples(uint16_t address);
+    uint8_t readByte(uint16_t address);
+    uint32_t getAddress(uint32_t address);
+    int16_t clamp16(int32_t value);
+    int16_t stepRamp(Ramp &ramp);
+
+    void loadBuffer(uint16_t dmemAddr, uint32_t address, uint32_t size);
+    void saveBuffer(uint16_t dmemAddr, uint32_t address, uint32_t size);
+    void loadAdpcm(uint32_t address, uint32_t size);
+    void decodeAdpcm(uint8_t flags, uint32_t address);
+    void envMixer(uint8_t flags, uint32_t address);
+    void resample(uint8_t flags, uint32_t pitch, uint32_t address);
+    void mixer(uint16_t dst, uint16_t src, int16_t gain);
+    void interleave(uint16_t left, uint16_t right);
+
+#if defined(__SSE2__)
+    inline void mix8(int16_t *dst, const int16_t *src, const int16_t *gain) {
+        // Add 8 samples scaled by 8 gains to a buffer, using 32-bit products and saturating the result
+        __m128i s = _mm_loadu_si128((const __m128i*)src), g = _mm_loadu_si128((const __m128i*)gain);
+        __m128i lo = _mm_mullo_epi16(s, g), hi = _mm_mulhi_epi16(s, g);
+        __m128i d = _mm_loadu_si128((const __m128i*)dst);
+        __m128i d0 = _mm_add_epi32(_mm_srai_epi32(_mm_unpacklo_epi16(d, d), 16), _mm_srai_epi32(_mm_unpacklo_epi16(lo, hi), 15));
+        __m128i d1 = _mm_add_epi32(_mm_srai_epi32(_mm_unpackhi_epi16(d, d), 16), _mm_srai_epi32(_mm_unpackhi_epi16(lo, hi), 15));
+        _mm_storeu_si128((__m128i*)dst, _mm_packs_epi32(d0, d1));
+    }
+
+    inline void decode8(int16_t *dst, const int16_t (*coeffs)[8], const int16_t *in) {
+        // Multiply 8 predicted samples and 2 previous samples by a coefficient matrix, using pairwise multiply-adds
+        __m128i lo = _mm_setzero_si128(), hi = _mm_setzero_si128();
+        for (int k = 0; k < 10; k += 2) {
+            __m128i a = _mm_load_si128((const __m128i*)coeffs[k]), b = _mm_load_si128((const __m128i*)coeffs[k + 1]);
+            __m128i x = _mm_set1_epi32((uint16_t)in[k] | ((uint32_t)(uint16_t)in[k + 1] << 16));
+            lo = _mm_add_epi32(lo, _mm_madd_epi16(_mm_unpacklo_epi16(a, b), x));
+            hi = _mm_add_epi32(hi, _mm_madd_epi16(_mm_unpackhi_epi16(a, b), x));
+        }
+        _mm_storeu_si128((__m128i*)dst, _mm_packs_epi32(_mm_srai_epi32(lo, 11), _mm_srai_epi32(hi, 11)));
+    }
+
+    inline int16_t dot4(const int16_t *src, const int16_t *lut) {
+        // Filter 4 samples with 4 coefficients, using pairwise multiply-adds
+        __m128i p = _mm_madd_epi16(_mm_loadl_epi64((const __m128i*)src), _mm_loadl_epi64((const __m128i*)lut));
+        return clamp16((_mm_cvtsi128_si32(p) + _mm_cvtsi128_si32(_mm_srli_si128(p, 4))) >> 15);
+    }
+
+    inline void interleave8(int16_t *dst, const int16_t *left, const int16_t *right) {
+        // Interleave 8 samples from each channel
+        __m128i l = _mm_loadu_si128((const __m128i*)left), r = _mm_loadu_si128((const __m128i*)right);
+        _mm_storeu_si128((__m128i*)&dst[0], _mm_unpacklo_epi16(l, r));
+        _mm_storeu_si128((__m128i*)&dst[8], _mm_unpackhi_epi16(l, r));
+    }
+#elif defined(__aarch64__)
+    inline void mix8(int16_t *dst, const int16_t *src, const int16_t *gain) {
+        // Add 8 samples scaled by 8 gains to a buffer, using widening multiplies and saturating the result
+        int16x8_t s = vld1q_s16(src), g = vld1q_s16(gain), d = vld1q_s16(dst);
+        int32x4_t d0 = vaddw_s16(vshrq_n_s32(vmull_s16(vget_low_s16(s), vget_low_s16(g)), 15), vget_low_s16(d));
+        int32x4_t d1 = vaddw_high_s16(vshrq_n_s32(vmull_high_s16(s, g), 15), d);
+        vst1q_s16(dst, vcombine_s16(vqmovn_s32(d0), vqmovn_s32(d1)));
+    }
+
+    inline void decode8(int16_t *dst, const int16_t (*coeffs)[8], const int16_t *in) {
+        // Multiply 8 predicted samples and 2 previous samples by a coefficient matrix, using widening multiply-adds
+        int32x4_t lo = vdupq_n_s32(0), hi = vdupq_n_s32(0);
+        for (int k = 0; k < 10; k++) {
+            int16x8_t c = vld1q_s16(coeffs[k]);
+            lo = vmlal_n_s16(lo, vget_low_s16(c), in[k]);
+            hi = vmlal_high_n_s16(hi, c, in[k]);
+        }
+        vst1q_s16(dst, vcombine_s16(vqshrn_n_s32(lo, 11), vqshrn_n_s32(hi, 11)));
+    }
+
+    inline int16_t dot4(const int16_t *src, const int16_t *lut) {
+        // Filter 4 samples with 4 coefficients, using a widening multiply and horizontal add
+        return clamp16(vaddvq_s32(vmull_s16(vld1_s16(src), vld1_s16(lut))) >> 15);
+    }
+
+    inline void interleave8(int16_t *dst, const int16_t *left, const int16_t *right) {
+        // Interleave 8 samples from each channel
+        int16x8x2_t lr = { { vld1q_s16(left), vld1q_s16(right) } };
+        vst2q_s16(dst, lr);
+    }
+#else
+    inline void mix8(int16_t *dst, const int16_t *src, const int16_t *gain) {
+        // Add 8 samples scaled by 8 gains to a buffer, saturating the result
+        for (int i = 0; i < 8; i++)
+            dst[i] = clamp16(dst[i] + ((src[i] * gain[i]) >> 15));
+    }
+
+    inline void decode8(int16_t *dst, const int16_t (*coeffs)[8], const int16_t *in) {
+        // Multiply 8 predicted samples and 2 previous samples by a coefficient matrix
+        for (int i = 0; i < 8; i++) {
+            int32_t accum = 0;
+            for (int k = 0; k < 10; k++)
+                accum += coeffs[k][i] * in[k];
+            dst[i] = clamp16(accum >> 11);
+        }
+    }
+
+    inline int16_t dot4(const int16_t *src, const int16_t *lut) {
+        // Filter 4 samples with 4 coefficients
+        return clamp16((src[0] * lut[0] + src[1] * lut[1] + src[2] * lut[2] + src[3] * lut[3]) >> 15);
+    }
+
+    inline void interleave8(int16_t *dst, const int16_t *left, const int16_t *right) {
+        // Interleave 8 samples from each channel
+        for (int i = 0; i < 8; i++) {
+            dst[i * 2 + 0] = left[i];
+            dst[i * 2 + 1] = right[i];
+        }
+    }
+#endif
+}
+
+int32_t RSP_AUDIO::findTable(uint32_t ucodeData, uint32_t ucodeSize) {
+    // Look for the resample filter table in microcode data, which also marks it as standard audio microcode
+    ucodeSize = std::min(ucodeSize, 0x1000U);
+    for (uint32_t i = 0; i + 0x200 <= ucodeSize; i += 8) {
+        if (Memory::read<uint32_t>(0x80000000 + ((ucodeData + i + 0) & 0xFFFFFF)) == 0x0C3966AD &&
+            Memory::read<uint32_t>(0x80000000 + ((ucodeData + i + 4) & 0xFFFFFF)) == 0x0D46FFDF)
+            return i;
+    }
+    return -1;
+}
+
+bool RSP_AUDIO::runTask(uint32_t dataPtr, uint32_t dataSize, uint32_t ucodeData, uint32_t ucodeSize) {
+    // Fall back to the RSP if the command list uses anything unsupported
+    dataPtr &= 0xFFFFF8;
+    dataSize = std::min(dataSize, 0x100000U) & ~0x7;
+    if (!checkList(dataPtr, dataSize))
+        return false;
+
+    // Load the resample table from the microcode's data if it changed
+    if (lutSource != ucodeData) {
+        int32_t offset = findTable(ucodeData, ucodeSize);
+        if (offset < 0)
+            return false;
+        for (int i = 0; i < 0x100; i++)
+            resampleLut[i] = Memory::read<uint16_t>(0x80000000 + ((ucodeData + offset + i * 2) & 0xFFFFFF));
+        lutSource = ucodeData;
+    }
+
+    // Reset the state that the command list is expected to set up
+    memset(segments, 0, sizeof(segments));
+    inAddr = outAddr = count = 0;
+
+    // Execute each command in the list
+    for (uint32_t i = 0; i < dataSize; i += 8) {
+        uint32_t w0 = Memory::read<uint32_t>(0x80000000 + ((dataPtr + i + 0) & 0xFFFFFF));
+        uint32_t w1 = Memory::read<uint32_t>(0x80000000 + ((dataPtr + i + 4) & 0xFFFFFF));
+        uint8_t flags = w0 >> 16;
+
+        switch ((w0 >> 24) & 0x7F) {
+        case 0x01: // A_ADPCM
+            decodeAdpcm(flags, getAddress(w1));
+            break;
+
+        case 0x02: // A_CLEARBUFF
+            memset(samples(w0 + DMEM_BASE), 0, std::min((w1 + 15) & 0xFFF0, 0x1000U));
+            break;
+
+        case 0x03: // A_ENVMIXER
+            envMixer(flags, getAddress(w1));
+            break;
+
+        case 0x04: // A_LOADBUFF
+            if (count)
+                loadBuffer(inAddr, getAddress(w1), count);
+            break;
+
+        case 0x05: // A_RESAMPLE
+            resample(flags, (w0 & 0xFFFF) << 1, getAddress(w1));
+            break;
+
+        case 0x06: // A_SAVEBUFF
+            if (count)
+                saveBuffer(outAddr, getAddress(w1), count);
+            break;
+
+        case 0x07: // A_SEGMENT
+            segments[(w1 >> 24) & 0xF] = w1 & 0xFFFFFF;
+            break;
+
+        case 0x08: // A_SETBUFF
+            if (flags & A_AUX) {
+                dryRight = (w0 + DMEM_BASE) & 0xFFF;
+                wetLeft = ((w1 >> 16) + DMEM_BASE) & 0xFFF;
+                wetRight = (w1 + DMEM_BASE) & 0xFFF;
+            }
+            else {
+                inAddr = (w0 + DMEM_BASE) & 0xFFF;
+                outAddr = ((w1 >> 16) + DMEM_BASE) & 0xFFF;
+                count = w1;
+            }
+            break;
+
+        case 0x09: // A_SETVOL
+            if (flags & A_AUX) {
+                dry = w0;
+                wet = w1;
+            }
+            else if (flags & A_VOL) {
+                volume[(flags & A_LEFT) ? 0 : 1] = w0;
+            }
+            else {
+                target[(flags & A_LEFT) ? 0 : 1] = w0;
+                rate[(flags & A_LEFT) ? 0 : 1] = w1;
+            }
+            break;
+
+        case 0x0A: // A_DMEMMOVE
+            if (uint16_t size = w1)
+                memmove(samples((w1 >> 16) + DMEM_BASE), samples(w0 + DMEM_BASE), std::min((size + 15) & ~15, 0x1000));
+            break;
+
+        case 0x0B: // A_LOADADPCM
+            loadAdpcm(getAddress(w1), w0 & 0xFFFF);
+            break;
+
+        case 0x0C: // A_MIXER
+            mixer(w1 + DMEM_BASE, (w1 >> 16) + DMEM_BASE, w0);
+            break;
+
+        case 0x0D: // A_INTERLEAVE
+            if (count)
+                interleave((w1 >> 16) + DMEM_BASE, w1 + DMEM_BASE);
+            break;
+
+        case 0x0F: // A_SETLOOP
+            loopAddr = getAddress(w1);
+            break;
+        }
+    }
+    return true;
+}
+
+bool RSP_AUDIO::checkList(uint32_t dataPtr, uint32_t dataSize) {
+    // Check that a list only has known commands, and sets buffers before using them like the standard microcode
+    // Variants with fixed buffers reuse the same opcodes for other things, so this keeps them on the RSP
+    bool buffers = false;
+    for (uint32_t i = 0; i < dataSize; i += 8) {
+        uint32_t w0 = Memory::read<uint32_t>(0x80000000 + ((dataPtr + i) & 0xFFFFFF));
+        switch ((w0 >> 24) & 0x7F) {
+        case 0x00: case 0x02: case 0x07: case 0x09:
+        case 0x0A: case 0x0B: case 0x0F:
+            break;
+
+        case 0x08: // A_SETBUFF
+            buffers |= !((w0 >> 16) & A_AUX);
+            break;
+
+        case 0x01: case 0x03: case 0x04: case 0x05:
+        case 0x06: case 0x0C: case 0x0D:
+            if (!buffers)
+                return false;
+            break;
+
+        default:
+            LOG_WARN("Unsupported audio command in HLE: 0x%02X\n", (w0 >> 24) & 0x7F);
+            return false;
+        }
+    }
+    return true;
+}
+
+inline int16_t *RSP_AUDIO::samples(uint16_t address) {
+    // Get a pointer to samples at a DMEM address, which can extend past the end to avoid wrapping
+    return &dmem[(address & 0xFFF) >> 1];
+}
+
+inline uint8_t RSP_AUDIO::readByte(uint16_t address) {
+    // Read a byte from the samples in DMEM
+    return dmem[(address >> 1) & 0x1FFF] >> ((~address & 1) << 3);
+}
+
+inline uint32_t RSP_AUDIO::getAddress(uint32_t address) {
+    // Convert a segmented address to a physical one
+    return (segments[(address >> 24) & 0xF] + address) & 0xFFFFFF;
+}
+
+inline int16_t RSP_AUDIO::clamp16(int32_t value) {
+    // Saturate a value to 16 bits
+    return std::max(-0x8000, std::min(0x7FFF, value));
+}
+
+inline int16_t RSP_AUDIO::stepRamp(Ramp &ramp) {
+    // Move a volume ramp by its step, stopping once the target is reached
+    ramp.value += ramp.step;
+    if ((ramp.step <= 0) ? (ramp.value <= ramp.target) : (ramp.value >= ramp.target)) {
+        ramp.value = ramp.target;
+        ramp.step = 0;
+    }
+    return ramp.value >> 16;
+}
+
+void RSP_AUDIO::loadBuffer(uint16_t dmemAddr, uint32_t address, uint32_t size) {
+    // Copy data from RDRAM to DMEM, with the alignment that DMA transfers enforce
+    int16_t *dst = samples(dmemAddr & ~0x3);
+    address &= 0xFFFFF8;
+    size = std::min((size + 7) & ~0x7, 0x1000U);
+    for (uint32_t i = 0; i < size; i += 4) {
+        uint32_t value = Memory::read<uint32_t>(0x80000000 + ((address + i) & 0xFFFFFF));
+        dst[(i >> 1) + 0] = value >> 16;
+        dst[(i >> 1) + 1] = value;
+    }
+}
+
+void RSP_AUDIO::saveBuffer(uint16_t dmemAddr, uint32_t address, uint32_t size) {
+    // Copy data from DMEM to RDRAM, with the alignment that DMA transfers enforce
+    int16_t *src = samples(dmemAddr & ~0x3);
+    address &= 0xFFFFF8;
+    size = std::min((size + 7) & ~0x7, 0x1000U);
+    for (uint32_t i = 0; i < size; i += 4) {
+        uint32_t value = ((uint16_t)src[(i >> 1) + 0] << 16) | (uint16_t)src[(i >> 1) + 1];
+        Memory::write<uint32_t>(0x80000000 + ((address + i) & 0xFFFFFF), value);
+    }
+}
+
+void RSP_AUDIO::loadAdpcm(uint32_t address, uint32_t size) {
+    // Load ADPCM codebook entries, each with 8 coefficients for the 2 previous samples
+    size = std::min((size + 7) & ~0x7, 0x200U) >> 1;
+    for (uint32_t i = 0; i < size; i++)
+        adpcmBook[i] = Memory::read<uint16_t>(0x80000000 + ((address + i * 2) & 0xFFFFFF));
+
+    // Expand each entry into a matrix that decodes 8 samples at once
+    // Each output adds its predicted sample scaled by 2048 to the previous samples and earlier predictions
+    for (int e = 0; e < 16; e++) {
+        const int16_t *book1 = &adpcmBook[e * 16], *book2 = book1 + 8;
+        for (int i = 0; i < 8; i++) {
+            for (int k = 0; k < 8; k++)
+                adpcmCoeffs[e][k][i] = (i == k) ? 2048 : ((k < i) ? book2[i - 1 - k] : 0);
+            adpcmCoeffs[e][8][i] = book1[i];
+            adpcmCoeffs[e][9][i] = book2[i];
+        }
+    }
+}
+
+void RSP_AUDIO::decodeAdpcm(uint8_t flags, uint32_t address) {
+    // Load the last decoded frame, from the loop point if looping, or start from silence
+    int16_t *dst = samples(outAddr);
+    if (flags & A_INIT) {
+        memset(dst, 0, 16 * sizeof(int16_t));
+    }
+    else {
+        uint32_t src = (flags & A_LOOP) ? loopAddr : address;
+        for (int i = 0; i < 16; i++)
+            dst[i] = Memory::read<uint16_t>(0x80000000 + ((src + i * 2) & 0xFFFFFF));
+    }
+
+    // Decode frames of 9 bytes into 16 samples each
+    uint16_t src = inAddr;
+    uint32_t size = std::min((count + 31) & ~31, 0x1000);
+    for (uint32_t i = 0; i < size; i += 32, dst += 16) {
+        // Predict samples from 4-bit values scaled by the header
+        uint8_t header = readByte(src++);
+        int shift = 12 - std::min(12, header >> 4);
+        int16_t predict[16];
+        for (int j = 0; j < 16; j += 2) {
+            uint8_t value = readByte(src++);
+            predict[j + 0] = (int16_t)((value & 0xF0) << 8) >> shift;
+            predict[j + 1] = (int16_t)((value & 0x0F) << 12) >> shift;
+        }
+
+        // Decode each half of the frame based on the two samples before it
+        int16_t in[10];
+        const int16_t (*coeffs)[8] = adpcmCoeffs[header & 0xF];
+        memcpy(in, &predict[0], 8 * sizeof(int16_t));
+        in[8] = dst[14];
+        in[9] = dst[15];
+        decode8(&dst[16], coeffs, in);
+        memcpy(in, &predict[8], 8 * sizeof(int16_t));
+        in[8] = dst[22];
+        in[9] = dst[23];
+        decode8(&dst[24], coeffs, in);
+    }
+
+    // Save the last decoded frame for the next task
+    for (int i = 0; i < 16; i++)
+        Memory::write<uint16_t>(0x80000000 + ((address + i * 2) & 0xFFFFFF), dst[i]);
+}
+
+void RSP_AUDIO::envMixer(uint8_t flags, uint32_t address) {
+    Ramp ramps[2];
+    int32_t rates[2], seq[2];
+    int16_t dryGain = dry, wetGain = wet;
+
+    // Set up volume ramps from the current volume, or continue them from the last task
+    if (flags & A_INIT) {
+        for (int i = 0; i < 2; i++) {
+            ramps[i].value = volume[i] << 16;
+            ramps[i].target = target[i] << 16;
+            rates[i] = rate[i];
+            seq[i] = (int32_t)((int64_t)volume[i] * rate[i]);
+        }
+    }
+    else {
+        wetGain = Memory::read<uint16_t>(0x80000000 + ((address + 0) & 0xFFFFFF));
+        dryGain = Memory::read<uint16_t>(0x80000000 + ((address + 4) & 0xFFFFFF));
+        for (int i = 0; i < 2; i++) {
+            ramps[i].target = Memory::read<uint32_t>(0x80000000 + ((address + 8 + i * 4) & 0xFFFFFF));
+            rates[i] = Memory::read<uint32_t>(0x80000000 + ((address + 16 + i * 4) & 0xFFFFFF));
+            seq[i] = Memory::read<uint32_t>(0x80000000 + ((address + 24 + i * 4) & 0xFFFFFF));
+            ramps[i].value = Memory::read<uint32_t>(0x80000000 + ((address + 32 + i * 4) & 0xFFFFFF));
+        }
+    }
+    for (int i = 0; i < 2; i++)
+        ramps[i].step = ramps[i].target - ramps[i].value;
+
+    // Mix the input into the dry buffers, and the wet buffers if enabled
+    int16_t *buffers[] = { samples(outAddr), samples(dryRight), samples(wetLeft), samples(wetRight) };
+    const int16_t *in = samples(inAddr);
+    int outputs = (flags & A_AUX) ? 4 : 2;
+    uint32_t size = std::min<uint32_t>(count, 0x1000);
+    for (uint32_t y = 0; y < size; y += 16) {
+        // Move the ramps exponentially towards their targets every 8 samples
+        for (int i = 0; i < 2; i++) {
+            if (!ramps[i].step) continue;
+            seq[i] = ((int64_t)seq[i] * rates[i]) >> 16;
+            ramps[i].step = (seq[i] - ramps[i].value) >> 3;
+        }
+
+        // Calculate the gains for each sample, and mix with them
+        alignas(16) int16_t gains[4][8];
+        for (int x = 0; x < 8; x++) {
+            int16_t left = stepRamp(ramps[0]), right = stepRamp(ramps[1]);
+            gains[0][x] = clamp16((left * dryGain + 0x4000) >> 15);
+            gains[1][x] = clamp16((right * dryGain + 0x4000) >> 15);
+            gains[2][x] = clamp16((left * wetGain + 0x4000) >> 15);
+            gains[3][x] = clamp16((right * wetGain + 0x4000) >> 15);
+        }
+        for (int i = 0; i < outputs; i++)
+            mix8(&buffers[i][y >> 1], &in[y >> 1], gains[i]);
+    }
+
+    // Save the ramp state for the next task
+    Memory::write<uint16_t>(0x80000000 + ((address + 0) & 0xFFFFFF), wetGain);
+    Memory::write<uint16_t>(0x80000000 + ((address + 4) & 0xFFFFFF), dryGain);
+    for (int i = 0; i < 2; i++) {
+        Memory::write<uint32_t>(0x80000000 + ((address + 8 + i * 4) & 0xFFFFFF), ramps[i].target);
+        Memory::write<uint32_t>(0x80000000 + ((address + 16 + i * 4) & 0xFFFFFF), rates[i]);
+        Memory::write<uint32_t>(0x80000000 + ((address + 24 + i * 4) & 0xFFFFFF), seq[i]);
+        Memory::write<uint32_t>(0x80000000 + ((address + 32 + i * 4) & 0xFFFFFF), ramps[i].value);
+    }
+}
+
+void RSP_AUDIO::resample(uint8_t flags, uint32_t pitch, uint32_t address) {
+    // Set up the 4 samples before the input, and the fractional position, from silence or the last task
+    int16_t *src = &dmem[((inAddr >> 1) - 4) & 0x7FF];
+    uint32_t accum = 0;
+    if (flags & A_INIT) {
+        memset(src, 0, 4 * sizeof(int16_t));
+    }
+    else {
+        for (int i = 0; i < 4; i++)
+            src[i] = Memory::read<uint16_t>(0x80000000 + ((address + i * 2) & 0xFFFFFF));
+        accum = Memory::read<uint16_t>(0x80000000 + ((address + 8) & 0xFFFFFF));
+    }
+
+    // Filter the input at each output position, stepping through it by a 16.16 pitch
+    int16_t *dst = samples(outAddr);
+    uint32_t outputs = std::min((count + 15) & ~15, 0x1000) >> 1, pos = 0;
+    for (uint32_t i = 0; i < outputs; i++) {
+        dst[i] = dot4(&src[pos], &resampleLut[(accum >> 8) & 0xFC]);
+        accum += pitch;
+        pos += accum >> 16;
+        accum &= 0xFFFF;
+    }
+
+    // Save the samples at the final position for the next task
+    for (int i = 0; i < 4; i++)
+        Memory::write<uint16_t>(0x80000000 + ((address + i * 2) & 0xFFFFFF), src[pos + i]);
+    Memory::write<uint16_t>(0x80000000 + ((address + 8) & 0xFFFFFF), accum);
+}
+
+void RSP_AUDIO::mixer(uint16_t dst, uint16_t src, int16_t gain) {
+    // Add a buffer scaled by a gain to another, 8 samples at a time
+    alignas(16) int16_t gains[8];
+    std::fill(gains, gains + 8, gain);
+    int16_t *out = samples(dst), *in = samples(src);
+    uint32_t size = std::min<uint32_t>(count, 0x1000) >> 1, i = 0;
+    for (; i + 8 <= size; i += 8)
+        mix8(&out[i], &in[i], gains);
+    for (; i < size; i++)
+        out[i] = clamp16(out[i] + ((in[i] * gain) >> 15));
+}
+
+void RSP_AUDIO::interleave(uint16_t left, uint16_t right) {
+    // Interleave the left and right channels into the output, 8 samples at a time
+    // The output usually overlaps the left input, so stage the result before writing it
+    alignas(16) int16_t result[0x800];
+    int16_t *l = samples(left), *r = samples(right);
+    uint32_t size = std::min<uint32_t>(count, 0x800) >> 1, i = 0;
+    for (; i + 8 <= size; i += 8)
+        interleave8(&result[i * 2], &l[i], &r[i]);
+    for (; i < size; i++) {
+        result[i * 2 + 0] = l[i];
+        result[i * 2 + 1] = r[i];
+    }
+    memcpy(samples(outAddr), result, size * 2 * sizeof(int16_t));
+}
@@ -23,6 +23,8 @@
 #include "mi.h"
 #include "rdp.h"
 #include "rsp.h"
+#include "rsp_hle.h"
+#include "rsp_jit.h"
 
 namespace RSP_CP0 {
     uint32_t memAddr;
@@ -90,11 +92,10 @@ void RSP_CP0::write(int index, uint32_t value) {
         performWriteDma(value & 0xFF8, (value >> 12) & 0xFF, (value >> 20) & 0xFF8);
         return;
 
-    case 4: // SP_STATUS
-        // Set or clear the halt flag and update the RSP's state
-        if (value & 0x1)
-            status &= ~0x1;
-        else if (value & 0x2)
+    case 4: { // SP_STATUS
+        // Set the halt flag and update the RSP's state, deferring starts until other bits are set
+        bool start = (value & 0x1) && (status & 0x1);
+        if (!(value & 0x1) && (value & 0x2))
             status |= 0x1;
         RSP::setState(status & 0x1);
 
@@ -119,7 +120,14 @@ void RSP_CP0::write(int index, uint32_t value) {
         // Keep track of unimplemented bits that should do something
         if (uint32_t bits = (status & 0x20))
             LOG_WARN("Unimplemented RSP CP0 status bits set: 0x%X\n", bits);
+
+        // Start the RSP, unless its task can be run with HLE instead
+        if (start && !RSP_HLE::runTask()) {
+            status &= ~0x1;
+            RSP::setState(false);
+        }
         return;
+    }
 
     case 7: // SP_SEMAPHORE
         // Set the semaphore value
@@ -149,13 +157,22 @@ void RSP_CP0::performReadDma(uint32_t length, uint32_t count, uint32_t skip) {
     LOG_INFO("RSP DMA from RDRAM 0x%X to RSP MEM 0x%X with length 0x%X, "
         "count 0x%X, skip 0x%X\n", dramAddr, memAddr, length, count, skip);
 
-    // Copy rows of data from memory to the RSP
+    // Invalidate compiled RSP code if the transfer writes to IMEM
+    if (memAddr & 0x1000)
+        RSP_JIT::invalidate();
+
+    // Copy rows of data from memory to the RSP, in bulk up to where either address wraps
     uint32_t dramBase = dramAddr, memBase = memAddr;
     for (uint32_t c = 0; c <= count; c++) {
-        for (uint32_t l = 0; l <= length; l += 8) {
+        for (uint32_t l = 0; l <= length;) {
             uint32_t dst = 0x84000000 + ((memBase + l) & 0x1FF8);
             uint32_t src = 0x80000000 + ((dramBase + l) & 0xFFFFF8);
+            if (uint32_t size = Memory::copyDma(dst, src, length + 8 - l)) {
+                l += size;
+                continue;
+            }
             Memory::write<uint64_t>(dst, Memory::read<uint64_t>(src));
+            l += 8;
         }
         dramBase += length + skip + 8;
         memBase += length + 8;
@@ -166,13 +183,18 @@ void RSP_CP0::performWriteDma(uint32_t length, uint32_t count, uint32_t skip) {
     LOG_INFO("RSP DMA from RSP MEM 0x%X to RDRAM 0x%X with length 0x%X, "
         "count 0x%X, skip 0x%X\n", memAddr, dramAddr, length, count, skip);
 
-    // Copy rows of data from the RSP to memory
+    // Copy rows of data from the RSP to memory, in bulk up to where either address wraps
     uint32_t dramBase = dramAddr, memBase = memAddr;
     for (uint32_t c = 0; c <= count; c++) {
-        for (uint32_t l = 0; l <= length; l += 8) {
+        for (uint32_t l = 0; l <= length;) {
             uint32_t dst = 0x80000000 + ((dramBase + l) & 0xFFFFF8);
             uint32_t src = 0x84000000 + ((memBase + l) & 0x1FF8);
+            if (uint32_t size = Memory::copyDma(dst, src, length + 8 - l)) {
+                l += size;
+                continue;
+            }
             Memory::write<uint64_t>(dst, Memory::read<uint64_t>(src));
+            l += 8;
         }
         dramBase += length + skip + 8;
         memBase += length + 8;
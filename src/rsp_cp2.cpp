@@ -17,8 +17,20 @@
     along with rokuyon. If not, see <https://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
 #include <cmath>
 #include <cstring>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#ifdef __SSSE3__
+#include <tmmintrin.h>
+#endif
+#ifdef __SSE4_1__
+#include <smmintrin.h>
+#endif
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
 
 #include "rsp_cp2.h"
 #include "log.h"
@@ -26,19 +38,204 @@
 
 namespace RSP_CP2 {
     extern const uint8_t elements[16][8];
+    extern const uint8_t elementMasks[16][16];
     extern const uint16_t rcpTable[0x200];
     extern const uint16_t rsqTable[0x200];
 
-    uint16_t registers[32][8];
-    int64_t accumulator[8];
+#if defined(__SSE2__)
+    // 8x16-bit vector operations using x86 SSE
+    typedef __m128i Vector;
+    inline Vector load(const uint16_t *src) { return _mm_load_si128((const __m128i*)src); }
+    inline void store(uint16_t *dst, Vector v) { _mm_store_si128((__m128i*)dst, v); }
+    inline Vector splat(int16_t value) { return _mm_set1_epi16(value); }
+    inline Vector add(Vector a, Vector b) { return _mm_add_epi16(a, b); }
+    inline Vector sub(Vector a, Vector b) { return _mm_sub_epi16(a, b); }
+    inline Vector addSat(Vector a, Vector b) { return _mm_adds_epi16(a, b); }
+    inline Vector subSat(Vector a, Vector b) { return _mm_subs_epi16(a, b); }
+    inline Vector minimum(Vector a, Vector b) { return _mm_min_epi16(a, b); }
+    inline Vector maximum(Vector a, Vector b) { return _mm_max_epi16(a, b); }
+    inline Vector mulLow(Vector a, Vector b) { return _mm_mullo_epi16(a, b); }
+    inline Vector mulHigh(Vector a, Vector b) { return _mm_mulhi_epi16(a, b); }
+    inline Vector mulHighU(Vector a, Vector b) { return _mm_mulhi_epu16(a, b); }
+    inline Vector bitAnd(Vector a, Vector b) { return _mm_and_si128(a, b); }
+    inline Vector bitOr(Vector a, Vector b) { return _mm_or_si128(a, b); }
+    inline Vector bitXor(Vector a, Vector b) { return _mm_xor_si128(a, b); }
+    inline Vector bitAndNot(Vector a, Vector b) { return _mm_andnot_si128(a, b); }
+    inline Vector cmpEq(Vector a, Vector b) { return _mm_cmpeq_epi16(a, b); }
+    inline Vector cmpLt(Vector a, Vector b) { return _mm_cmplt_epi16(a, b); }
+    inline Vector cmpGt(Vector a, Vector b) { return _mm_cmpgt_epi16(a, b); }
+    inline Vector signMask(Vector a) { return _mm_srai_epi16(a, 15); }
+    inline Vector shiftLeft1(Vector a) { return _mm_slli_epi16(a, 1); }
+    inline Vector shiftRight15(Vector a) { return _mm_srli_epi16(a, 15); }
+#ifdef __SSE4_1__
+    inline Vector blend(Vector m, Vector a, Vector b) { return _mm_blendv_epi8(b, a, m); }
+#else
+    inline Vector blend(Vector m, Vector a, Vector b) { return _mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b)); }
+#endif
+
+    inline Vector packSat(Vector high, Vector low) {
+        // Saturate 32-bit values split into upper and lower halves to 16 bits
+        return _mm_packs_epi32(_mm_unpacklo_epi16(low, high), _mm_unpackhi_epi16(low, high));
+    }
+
+    inline int toBits(Vector m) {
+        // Convert a lane mask to one bit per lane
+        return _mm_movemask_epi8(_mm_packs_epi16(m, _mm_setzero_si128()));
+    }
+
+    inline Vector fromBits(int bits) {
+        // Convert one bit per lane to a lane mask
+        Vector lanes = _mm_set_epi16(0x80, 0x40, 0x20, 0x10, 0x8, 0x4, 0x2, 0x1);
+        return _mm_cmpeq_epi16(_mm_and_si128(_mm_set1_epi16(bits), lanes), lanes);
+    }
+
+#ifdef __SSSE3__
+    inline Vector loadElements(const uint16_t *src, int e) {
+        // Load a vector with lanes rearranged for an element modifier using a byte shuffle mask
+        return _mm_shuffle_epi8(load(src), _mm_load_si128((const __m128i*)elementMasks[e]));
+    }
+#else
+    inline Vector loadElements(const uint16_t *src, int e) {
+        // Load a vector with lanes rearranged for an element modifier through a temporary
+        alignas(16) uint16_t lanes[8];
+        for (int i = 0; i < 8; i++)
+            lanes[i] = src[elements[e][i]];
+        return _mm_load_si128((const __m128i*)lanes);
+    }
+#endif
+#elif defined(__aarch64__)
+    // 8x16-bit vector operations using ARM NEON
+    typedef int16x8_t Vector;
+    inline Vector load(const uint16_t *src) { return vld1q_s16((const int16_t*)src); }
+    inline void store(uint16_t *dst, Vector v) { vst1q_s16((int16_t*)dst, v); }
+    inline Vector splat(int16_t value) { return vdupq_n_s16(value); }
+    inline Vector add(Vector a, Vector b) { return vaddq_s16(a, b); }
+    inline Vector sub(Vector a, Vector b) { return vsubq_s16(a, b); }
+    inline Vector addSat(Vector a, Vector b) { return vqaddq_s16(a, b); }
+    inline Vector subSat(Vector a, Vector b) { return vqsubq_s16(a, b); }
+    inline Vector minimum(Vector a, Vector b) { return vminq_s16(a, b); }
+    inline Vector maximum(Vector a, Vector b) { return vmaxq_s16(a, b); }
+    inline Vector mulLow(Vector a, Vector b) { return vmulq_s16(a, b); }
+    inline Vector bitAnd(Vector a, Vector b) { return vandq_s16(a, b); }
+    inline Vector bitOr(Vector a, Vector b) { return vorrq_s16(a, b); }
+    inline Vector bitXor(Vector a, Vector b) { return veorq_s16(a, b); }
+    inline Vector bitAndNot(Vector a, Vector b) { return vbicq_s16(b, a); }
+    inline Vector cmpEq(Vector a, Vector b) { return vreinterpretq_s16_u16(vceqq_s16(a, b)); }
+    inline Vector cmpLt(Vector a, Vector b) { return vreinterpretq_s16_u16(vcltq_s16(a, b)); }
+    inline Vector cmpGt(Vector a, Vector b) { return vreinterpretq_s16_u16(vcgtq_s16(a, b)); }
+    inline Vector signMask(Vector a) { return vshrq_n_s16(a, 15); }
+    inline Vector shiftLeft1(Vector a) { return vshlq_n_s16(a, 1); }
+    inline Vector shiftRight15(Vector a) { return vreinterpretq_s16_u16(vshrq_n_u16(vreinterpretq_u16_s16(a), 15)); }
+    inline Vector blend(Vector m, Vector a, Vector b) { return vbslq_s16(vreinterpretq_u16_s16(m), a, b); }
+
+    inline Vector mulHigh(Vector a, Vector b) {
+        // Get the upper halves of signed 32-bit products
+        int32x4_t low = vmull_s16(vget_low_s16(a), vget_low_s16(b));
+        int32x4_t high = vmull_high_s16(a, b);
+        return vuzp2q_s16(vreinterpretq_s16_s32(low), vreinterpretq_s16_s32(high));
+    }
+
+    inline Vector mulHighU(Vector a, Vector b) {
+        // Get the upper halves of unsigned 32-bit products
+        uint16x8_t ua = vreinterpretq_u16_s16(a), ub = vreinterpretq_u16_s16(b);
+        uint32x4_t low = vmull_u16(vget_low_u16(ua), vget_low_u16(ub));
+        uint32x4_t high = vmull_high_u16(ua, ub);
+        return vreinterpretq_s16_u16(vuzp2q_u16(vreinterpretq_u16_u32(low), vreinterpretq_u16_u32(high)));
+    }
+
+    inline Vector packSat(Vector high, Vector low) {
+        // Saturate 32-bit values split into upper and lower halves to 16 bits
+        int32x4_t first = vreinterpretq_s32_s16(vzip1q_s16(low, high));
+        int32x4_t second = vreinterpretq_s32_s16(vzip2q_s16(low, high));
+        return vcombine_s16(vqmovn_s32(first), vqmovn_s32(second));
+    }
+
+    inline int toBits(Vector m) {
+        // Convert a lane mask to one bit per lane
+        static const uint16_t lanes[8] = { 0x1, 0x2, 0x4, 0x8, 0x10, 0x20, 0x40, 0x80 };
+        return vaddvq_u16(vandq_u16(vreinterpretq_u16_s16(m), vld1q_u16(lanes)));
+    }
+
+    inline Vector fromBits(int bits) {
+        // Convert one bit per lane to a lane mask
+        static const uint16_t lanes[8] = { 0x1, 0x2, 0x4, 0x8, 0x10, 0x20, 0x40, 0x80 };
+        return vreinterpretq_s16_u16(vtstq_u16(vdupq_n_u16(bits), vld1q_u16(lanes)));
+    }
+
+    inline Vector loadElements(const uint16_t *src, int e) {
+        // Load a vector with lanes rearranged for an element modifier using a byte table lookup
+        return vreinterpretq_s16_u8(vqtbl1q_u8(vreinterpretq_u8_s16(load(src)), vld1q_u8(elementMasks[e])));
+    }
+#else
+    // 8x16-bit vector operations using plain loops as a fallback
+    struct Vector { int16_t lane[8]; };
+    #define LANES(expr) for (int i = 0; i < 8; i++) r.lane[i] = (expr); return r
+    inline Vector load(const uint16_t *src) { Vector r; memcpy(r.lane, src, sizeof(r.lane)); return r; }
+    inline void store(uint16_t *dst, Vector v) { memcpy(dst, v.lane, sizeof(v.lane)); }
+    inline Vector splat(int16_t value) { Vector r; LANES(value); }
+    inline Vector add(Vector a, Vector b) { Vector r; LANES(a.lane[i] + b.lane[i]); }
+    inline Vector sub(Vector a, Vector b) { Vector r; LANES(a.lane[i] - b.lane[i]); }
+    inline Vector addSat(Vector a, Vector b) { Vector r; LANES(std::min(std::max(a.lane[i] + b.lane[i], -0x8000), 0x7FFF)); }
+    inline Vector subSat(Vector a, Vector b) { Vector r; LANES(std::min(std::max(a.lane[i] - b.lane[i], -0x8000), 0x7FFF)); }
+    inline Vector minimum(Vector a, Vector b) { Vector r; LANES(std::min(a.lane[i], b.lane[i])); }
+    inline Vector maximum(Vector a, Vector b) { Vector r; LANES(std::max(a.lane[i], b.lane[i])); }
+    inline Vector mulLow(Vector a, Vector b) { Vector r; LANES(a.lane[i] * b.lane[i]); }
+    inline Vector mulHigh(Vector a, Vector b) { Vector r; LANES((a.lane[i] * b.lane[i]) >> 16); }
+    inline Vector mulHighU(Vector a, Vector b) { Vector r; LANES((uint32_t)(uint16_t)a.lane[i] * (uint16_t)b.lane[i] >> 16); }
+    inline Vector bitAnd(Vector a, Vector b) { Vector r; LANES(a.lane[i] & b.lane[i]); }
+    inline Vector bitOr(Vector a, Vector b) { Vector r; LANES(a.lane[i] | b.lane[i]); }
+    inline Vector bitXor(Vector a, Vector b) { Vector r; LANES(a.lane[i] ^ b.lane[i]); }
+    inline Vector bitAndNot(Vector a, Vector b) { Vector r; LANES(~a.lane[i] & b.lane[i]); }
+    inline Vector cmpEq(Vector a, Vector b) { Vector r; LANES(-(a.lane[i] == b.lane[i])); }
+    inline Vector cmpLt(Vector a, Vector b) { Vector r; LANES(-(a.lane[i] < b.lane[i])); }
+    inline Vector cmpGt(Vector a, Vector b) { Vector r; LANES(-(a.lane[i] > b.lane[i])); }
+    inline Vector signMask(Vector a) { Vector r; LANES(a.lane[i] >> 15); }
+    inline Vector shiftLeft1(Vector a) { Vector r; LANES((uint16_t)a.lane[i] << 1); }
+    inline Vector shiftRight15(Vector a) { Vector r; LANES((uint16_t)a.lane[i] >> 15); }
+    inline Vector blend(Vector m, Vector a, Vector b) { Vector r; LANES(m.lane[i] ? a.lane[i] : b.lane[i]); }
+    inline Vector packSat(Vector high, Vector low) { Vector r; LANES(std::min(std::max((int32_t)(((uint32_t)
+        (uint16_t)high.lane[i] << 16) | (uint16_t)low.lane[i]), -0x8000), 0x7FFF)); }
+    inline Vector fromBits(int bits) { Vector r; LANES(-((bits >> i) & 1)); }
+    #undef LANES
+
+    inline int toBits(Vector m) {
+        // Convert a lane mask to one bit per lane
+        int bits = 0;
+        for (int i = 0; i < 8; i++)
+            bits |= (m.lane[i] & 1) << i;
+        return bits;
+    }
+
+    inline Vector loadElements(const uint16_t *src, int e) {
+        // Load a vector with lanes rearranged for an element modifier
+        Vector r;
+        for (int i = 0; i < 8; i++)
+            r.lane[i] = src[elements[e][i]];
+        return r;
+    }
+#endif
+
+    // 48-bit lane values, split into 16-bit slices
+    struct Wide { Vector low, mid, high; };
+
+    alignas(16) uint16_t registers[32][8];
+    alignas(16) uint16_t accumulator[3][8];
     uint32_t divIn;
     uint16_t divOut;
     uint16_t vco;
     uint16_t vcc;
     uint16_t vce;
 
-    uint16_t clampSigned(int64_t value);
-    uint16_t clampUnsigned(int64_t value);
+    Vector loadVt(uint32_t opcode);
+    Vector mulHighSU(Vector s, Vector u);
+    Vector carry(Vector a, Vector b, Vector sum);
+    Wide makeWide(Vector high, Vector mid, Vector low);
+    Wide addWide(Wide a, Wide b);
+    Wide fracProduct(Vector a, Vector b);
+    void setAccumulator(Wide value);
+    Wide getAccumulator();
+    Vector clampSigned(Wide value);
+    Vector clampUnsigned(Wide value);
 
     void vmulf(uint32_t opcode);
     void vmulu(uint32_t opcode);
@@ -118,6 +315,26 @@ const uint8_t RSP_CP2::elements[16][8] = {
     { 7, 7, 7, 7, 7, 7, 7, 7 }
 };
 
+// Byte shuffle masks for each element, matching the lane modifiers
+alignas(16) const uint8_t RSP_CP2::elementMasks[16][16] = {
+    { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F },
+    { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F },
+    { 0x00, 0x01, 0x00, 0x01, 0x04, 0x05, 0x04, 0x05, 0x08, 0x09, 0x08, 0x09, 0x0C, 0x0D, 0x0C, 0x0D },
+    { 0x02, 0x03, 0x02, 0x03, 0x06, 0x07, 0x06, 0x07, 0x0A, 0x0B, 0x0A, 0x0B, 0x0E, 0x0F, 0x0E, 0x0F },
+    { 0x00, 0x01, 0x00, 0x01, 0x00, 0x01, 0x00, 0x01, 0x08, 0x09, 0x08, 0x09, 0x08, 0x09, 0x08, 0x09 },
+    { 0x02, 0x03, 0x02, 0x03, 0x02, 0x03, 0x02, 0x03, 0x0A, 0x0B, 0x0A, 0x0B, 0x0A, 0x0B, 0x0A, 0x0B },
+    { 0x04, 0x05, 0x04, 0x05, 0x04, 0x05, 0x04, 0x05, 0x0C, 0x0D, 0x0C, 0x0D, 0x0C, 0x0D, 0x0C, 0x0D },
+    { 0x06, 0x07, 0x06, 0x07, 0x06, 0x07, 0x06, 0x07, 0x0E, 0x0F, 0x0E, 0x0F, 0x0E, 0x0F, 0x0E, 0x0F },
+    { 0x00, 0x01, 0x00, 0x01, 0x00, 0x01, 0x00, 0x01, 0x00, 0x01, 0x00, 0x01, 0x00, 0x01, 0x00, 0x01 },
+    { 0x02, 0x03, 0x02, 0x03, 0x02, 0x03, 0x02, 0x03, 0x02, 0x03, 0x02, 0x03, 0x02, 0x03, 0x02, 0x03 },
+    { 0x04, 0x05, 0x04, 0x05, 0x04, 0x05, 0x04, 0x05, 0x04, 0x05, 0x04, 0x05, 0x04, 0x05, 0x04, 0x05 },
+    { 0x06, 0x07, 0x06, 0x07, 0x06, 0x07, 0x06, 0x07, 0x06, 0x07, 0x06, 0x07, 0x06, 0x07, 0x06, 0x07 },
+    { 0x08, 0x09, 0x08, 0x09, 0x08, 0x09, 0x08, 0x09, 0x08, 0x09, 0x08, 0x09, 0x08, 0x09, 0x08, 0x09 },
+    { 0x0A, 0x0B, 0x0A, 0x0B, 0x0A, 0x0B, 0x0A, 0x0B, 0x0A, 0x0B, 0x0A, 0x0B, 0x0A, 0x0B, 0x0A, 0x0B },
+    { 0x0C, 0x0D, 0x0C, 0x0D, 0x0C, 0x0D, 0x0C, 0x0D, 0x0C, 0x0D, 0x0C, 0x0D, 0x0C, 0x0D, 0x0C, 0x0D },
+    { 0x0E, 0x0F, 0x0E, 0x0F, 0x0E, 0x0F, 0x0E, 0x0F, 0x0E, 0x0F, 0x0E, 0x0F, 0x0E, 0x0F, 0x0E, 0x0F }
+};
+
 // Lookup table for calculating a reciprocal
 const uint16_t RSP_CP2::rcpTable[0x200] = {
     0xFFFF, 0xFF00, 0xFE01, 0xFD04, 0xFC07, 0xFB0C, 0xFA11, 0xF918,
@@ -350,515 +567,504 @@ void RSP_CP2::write(bool control, int index, int byte, int16_t value) {
     }
 }
 
-uint16_t RSP_CP2::clampSigned(int64_t value) {
-    // Clamp a value to the signed 16-bit range
-    if (value < -32768) return -32768;
-    if (value > 32767) return 32767;
-    return value;
+RSP_CP2::Vector RSP_CP2::loadVt(uint32_t opcode) {
+    // Load the VT operand with its lanes rearranged by the element modifier
+    return loadElements(registers[(opcode >> 16) & 0x1F], (opcode >> 21) & 0xF);
+}
+
+RSP_CP2::Vector RSP_CP2::mulHighSU(Vector s, Vector u) {
+    // Get the upper halves of signed by unsigned products, correcting an unsigned multiply
+    return sub(mulHighU(s, u), bitAnd(signMask(s), u));
 }
 
-uint16_t RSP_CP2::clampUnsigned(int64_t value) {
-    // Clamp a value to the unsigned 16-bit range (bugged)
-    if (value < 0) return 0;
-    if (value > 32767) return 65535;
+RSP_CP2::Vector RSP_CP2::carry(Vector a, Vector b, Vector sum) {
+    // Get a mask of lanes that carried out of an unsigned 16-bit addition
+    return signMask(bitOr(bitAnd(a, b), bitAndNot(sum, bitOr(a, b))));
+}
+
+RSP_CP2::Wide RSP_CP2::makeWide(Vector high, Vector mid, Vector low) {
+    // Combine 16-bit slices into 48-bit values
+    Wide value = { low, mid, high };
     return value;
 }
 
+RSP_CP2::Wide RSP_CP2::addWide(Wide a, Wide b) {
+    // Add two 48-bit values, carrying between the slices
+    Wide res;
+    res.low = add(a.low, b.low);
+    Vector carryLow = carry(a.low, b.low, res.low);
+    Vector mid = add(a.mid, b.mid);
+    Vector carryMid = bitOr(carry(a.mid, b.mid, mid), bitAnd(carryLow, cmpEq(mid, splat(-1))));
+    res.mid = sub(mid, carryLow);
+    res.high = sub(add(a.high, b.high), carryMid);
+    return res;
+}
+
+RSP_CP2::Wide RSP_CP2::fracProduct(Vector a, Vector b) {
+    // Multiply two signed vectors and shift the products left by 1 as 48-bit values
+    Vector low = mulLow(a, b), high = mulHigh(a, b);
+    return makeWide(signMask(high), bitOr(shiftLeft1(high), shiftRight15(low)), shiftLeft1(low));
+}
+
+void RSP_CP2::setAccumulator(Wide value) {
+    // Store all slices of the accumulator
+    store(accumulator[0], value.low);
+    store(accumulator[1], value.mid);
+    store(accumulator[2], value.high);
+}
+
+RSP_CP2::Wide RSP_CP2::getAccumulator() {
+    // Load all slices of the accumulator
+    return makeWide(load(accumulator[2]), load(accumulator[1]), load(accumulator[0]));
+}
+
+RSP_CP2::Vector RSP_CP2::clampSigned(Wide value) {
+    // Clamp the upper 32 bits of 48-bit values to the signed 16-bit range
+    return packSat(value.high, value.mid);
+}
+
+RSP_CP2::Vector RSP_CP2::clampUnsigned(Wide value) {
+    // Clamp the upper 32 bits of 48-bit values to the unsigned 16-bit range (bugged)
+    Vector over = bitOr(cmpGt(value.high, splat(0)), signMask(value.mid));
+    return bitAndNot(signMask(value.high), bitOr(value.mid, over));
+}
+
 void RSP_CP2::vmulf(uint32_t opcode) {
     // Decode the operands
-    int16_t *vt = (int16_t*)registers[(opcode >> 16) & 0x1F];
-    int16_t *vs = (int16_t*)registers[(opcode >> 11) & 0x1F];
+    Vector vt = loadVt(opcode);
+    Vector vs = load(registers[(opcode >> 11) & 0x1F]);
     uint16_t *vd = registers[(opcode >> 6) & 0x1F];
-    const uint8_t *e = elements[(opcode >> 21) & 0xF];
 
     // Multiply two signed vector registers with rounding and signed clamping
-    for (int i = 0; i < 8; i++)
-        accumulator[i] = ((vs[i] * vt[e[i]]) << 1) + 0x8000;
-    for (int i = 0; i < 8; i++)
-        vd[i] = clampSigned(accumulator[i] >> 16);
+    Wide acc = addWide(fracProduct(vs, vt), makeWide(splat(0), splat(0), splat(0x8000)));
+    setAccumulator(acc);
+    store(vd, clampSigned(acc));
 }
 
 void RSP_CP2::vmulu(uint32_t opcode) {
     // Decode the operands
-    int16_t *vt = (int16_t*)registers[(opcode >> 16) & 0x1F];
-    int16_t *vs = (int16_t*)registers[(opcode >> 11) & 0x1F];
+    Vector vt = loadVt(opcode);
+    Vector vs = load(registers[(opcode >> 11) & 0x1F]);
     uint16_t *vd = registers[(opcode >> 6) & 0x1F];
-    const uint8_t *e = elements[(opcode >> 21) & 0xF];
 
     // Multiply two signed vector registers with rounding and unsigned clamping
-    for (int i = 0; i < 8; i++)
-        accumulator[i] = ((vs[i] * vt[e[i]]) << 1) + 0x8000;
-    for (int i = 0; i < 8; i++)
-        vd[i] = clampUnsigned(accumulator[i] >> 16);
+    Wide acc = addWide(fracProduct(vs, vt), makeWide(splat(0), splat(0), splat(0x8000)));
+    setAccumulator(acc);
+    store(vd, clampUnsigned(acc));
 }
 
 void RSP_CP2::vmudl(uint32_t opcode) {
     // Decode the operands
-    uint16_t *vt = registers[(opcode >> 16) & 0x1F];
-    uint16_t *vs = registers[(opcode >> 11) & 0x1F];
+    Vector vt = loadVt(opcode);
+    Vector vs = load(registers[(opcode >> 11) & 0x1F]);
     uint16_t *vd = registers[(opcode >> 6) & 0x1F];
-    const uint8_t *e = elements[(opcode >> 21) & 0xF];
 
     // Multiply two unsigned vector registers with signed clamping
-    for (int i = 0; i < 8; i++)
-        accumulator[i] = ((vs[i] * vt[e[i]]) >> 16) & 0xFFFF;
-    for (int i = 0; i < 8; i++)
-        vd[i] = clampSigned(accumulator[i]);
+    Vector low = mulHighU(vs, vt);
+    setAccumulator(makeWide(splat(0), splat(0), low));
+    store(vd, blend(signMask(low), splat(0x7FFF), low));
 }
 
 void RSP_CP2::vmudm(uint32_t opcode) {
     // Decode the operands
-    uint16_t *vt = registers[(opcode >> 16) & 0x1F];
-    int16_t *vs = (int16_t*)registers[(opcode >> 11) & 0x1F];
+    Vector vt = loadVt(opcode);
+    Vector vs = load(registers[(opcode >> 11) & 0x1F]);
     uint16_t *vd = registers[(opcode >> 6) & 0x1F];
-    const uint8_t *e = elements[(opcode >> 21) & 0xF];
 
     // Multiply a signed and an unsigned vector register with signed clamping
-    for (int i = 0; i < 8; i++)
-        accumulator[i] = vs[i] * vt[e[i]];
-    for (int i = 0; i < 8; i++)
-        vd[i] = clampSigned(accumulator[i] >> 16);
+    Vector mid = mulHighSU(vs, vt);
+    setAccumulator(makeWide(signMask(mid), mid, mulLow(vs, vt)));
+    store(vd, mid);
 }
 
 void RSP_CP2::vmudn(uint32_t opcode) {
     // Decode the operands
-    int16_t *vt = (int16_t*)registers[(opcode >> 16) & 0x1F];
-    uint16_t *vs = registers[(opcode >> 11) & 0x1F];
+    Vector vt = loadVt(opcode);
+    Vector vs = load(registers[(opcode >> 11) & 0x1F]);
     uint16_t *vd = registers[(opcode >> 6) & 0x1F];
-    const uint8_t *e = elements[(opcode >> 21) & 0xF];
 
     // Multiply an unsigned and a signed vector register
-    for (int i = 0; i < 8; i++)
-        accumulator[i] = vs[i] * vt[e[i]];
-    for (int i = 0; i < 8; i++)
-        vd[i] = accumulator[i];
+    Vector mid = mulHighSU(vt, vs), low = mulLow(vs, vt);
+    setAccumulator(makeWide(signMask(mid), mid, low));
+    store(vd, low);
 }
 
 void RSP_CP2::vmudh(uint32_t opcode) {
     // Decode the operands
-    int16_t *vt = (int16_t*)registers[(opcode >> 16) & 0x1F];
-    int16_t *vs = (int16_t*)registers[(opcode >> 11) & 0x1F];
+    Vector vt = loadVt(opcode);
+    Vector vs = load(registers[(opcode >> 11) & 0x1F]);
     uint16_t *vd = registers[(opcode >> 6) & 0x1F];
-    const uint8_t *e = elements[(opcode >> 21) & 0xF];
 
     // Multiply two signed vector registers with signed clamping
-    for (int i = 0; i < 8; i++)
-        accumulator[i] = (int64_t)(int32_t)(vs[i] * vt[e[i]]) << 16;
-    for (int i = 0; i < 8; i++)
-        vd[i] = clampSigned(accumulator[i] >> 16);
+    Wide acc = makeWide(mulHigh(vs, vt), mulLow(vs, vt), splat(0));
+    setAccumulator(acc);
+    store(vd, clampSigned(acc));
 }
 
 void RSP_CP2::vmacf(uint32_t opcode) {
     // Decode the operands
-    int16_t *vt = (int16_t*)registers[(opcode >> 16) & 0x1F];
-    int16_t *vs = (int16_t*)registers[(opcode >> 11) & 0x1F];
+    Vector vt = loadVt(opcode);
+    Vector vs = load(registers[(opcode >> 11) & 0x1F]);
     uint16_t *vd = registers[(opcode >> 6) & 0x1F];
-    const uint8_t *e = elements[(opcode >> 21) & 0xF];
 
     // Accumulate the product of two signed vector registers with signed clamping
-    for (int i = 0; i < 8; i++)
-        accumulator[i] += (vs[i] * vt[e[i]]) << 1;
-    for (int i = 0; i < 8; i++)
-        vd[i] = clampSigned(accumulator[i] >> 16);
+    Wide acc = addWide(getAccumulator(), fracProduct(vs, vt));
+    setAccumulator(acc);
+    store(vd, clampSigned(acc));
 }
 
 void RSP_CP2::vmacu(uint32_t opcode) {
     // Decode the operands
-    int16_t *vt = (int16_t*)registers[(opcode >> 16) & 0x1F];
-    int16_t *vs = (int16_t*)registers[(opcode >> 11) & 0x1F];
+    Vector vt = loadVt(opcode);
+    Vector vs = load(registers[(opcode >> 11) & 0x1F]);
     uint16_t *vd = registers[(opcode >> 6) & 0x1F];
-    const uint8_t *e = elements[(opcode >> 21) & 0xF];
 
     // Accumulate the product of two signed vector registers with unsigned clamping
-    for (int i = 0; i < 8; i++)
-        accumulator[i] += (vs[i] * vt[e[i]]) << 1;
-    for (int i = 0; i < 8; i++)
-        vd[i] = clampUnsigned(accumulator[i] >> 16);
+    Wide acc = addWide(getAccumulator(), fracProduct(vs, vt));
+    setAccumulator(acc);
+    store(vd, clampUnsigned(acc));
 }
 
 void RSP_CP2::vmadl(uint32_t opcode) {
     // Decode the operands
-    uint16_t *vt = registers[(opcode >> 16) & 0x1F];
-    uint16_t *vs = registers[(opcode >> 11) & 0x1F];
+    Vector vt = loadVt(opcode);
+    Vector vs = load(registers[(opcode >> 11) & 0x1F]);
     uint16_t *vd = registers[(opcode >> 6) & 0x1F];
-    const uint8_t *e = elements[(opcode >> 21) & 0xF];
 
     // Accumulate the product of two unsigned vector registers
-    for (int i = 0; i < 8; i++)
-        accumulator[i] += ((vs[i] * vt[e[i]]) >> 16) & 0xFFFF;
-    for (int i = 0; i < 8; i++)
-        vd[i] = accumulator[i];
+    Wide acc = addWide(getAccumulator(), makeWide(splat(0), splat(0), mulHighU(vs, vt)));
+    setAccumulator(acc);
+    store(vd, acc.low);
 }
 
 void RSP_CP2::vmadm(uint32_t opcode) {
     // Decode the operands
-    uint16_t *vt = registers[(opcode >> 16) & 0x1F];
-    int16_t *vs = (int16_t*)registers[(opcode >> 11) & 0x1F];
+    Vector vt = loadVt(opcode);
+    Vector vs = load(registers[(opcode >> 11) & 0x1F]);
     uint16_t *vd = registers[(opcode >> 6) & 0x1F];
-    const uint8_t *e = elements[(opcode >> 21) & 0xF];
 
     // Accumulate the product of a signed and an unsigned vector register
-    for (int i = 0; i < 8; i++)
-        accumulator[i] += vs[i] * vt[e[i]];
-    for (int i = 0; i < 8; i++)
-        vd[i] = accumulator[i] >> 16;
+    Vector mid = mulHighSU(vs, vt);
+    Wide acc = addWide(getAccumulator(), makeWide(signMask(mid), mid, mulLow(vs, vt)));
+    setAccumulator(acc);
+    store(vd, acc.mid);
 }
 
 void RSP_CP2::vmadn(uint32_t opcode) {
     // Decode the operands
-    int16_t *vt = (int16_t*)registers[(opcode >> 16) & 0x1F];
-    uint16_t *vs = registers[(opcode >> 11) & 0x1F];
+    Vector vt = loadVt(opcode);
+    Vector vs = load(registers[(opcode >> 11) & 0x1F]);
     uint16_t *vd = registers[(opcode >> 6) & 0x1F];
-    const uint8_t *e = elements[(opcode >> 21) & 0xF];
 
     // Accumulate the product of an unsigned and a signed vector register
-    for (int i = 0; i < 8; i++)
-        accumulator[i] += vs[i] * vt[e[i]];
-    for (int i = 0; i < 8; i++)
-        vd[i] = accumulator[i];
+    Vector mid = mulHighSU(vt, vs);
+    Wide acc = addWide(getAccumulator(), makeWide(signMask(mid), mid, mulLow(vs, vt)));
+    setAccumulator(acc);
+    store(vd, acc.low);
 }
 
 void RSP_CP2::vmadh(uint32_t opcode) {
     // Decode the operands
-    int16_t *vt = (int16_t*)registers[(opcode >> 16) & 0x1F];
-    int16_t *vs = (int16_t*)registers[(opcode >> 11) & 0x1F];
+    Vector vt = loadVt(opcode);
+    Vector vs = load(registers[(opcode >> 11) & 0x1F]);
     uint16_t *vd = registers[(opcode >> 6) & 0x1F];
-    const uint8_t *e = elements[(opcode >> 21) & 0xF];
 
     // Accumulate the product of two signed vector registers
-    for (int i = 0; i < 8; i++)
-        accumulator[i] += (int64_t)(int32_t)(vs[i] * vt[e[i]]) << 16;
-    for (int i = 0; i < 8; i++)
-        vd[i] = clampSigned(accumulator[i] >> 16);
+    Wide acc = addWide(getAccumulator(), makeWide(mulHigh(vs, vt), mulLow(vs, vt), splat(0)));
+    setAccumulator(acc);
+    store(vd, clampSigned(acc));
 }
 
 void RSP_CP2::vadd(uint32_t opcode) {
     // Decode the operands
-    int16_t *vt = (int16_t*)registers[(opcode >> 16) & 0x1F];
-    int16_t *vs = (int16_t*)registers[(opcode >> 11) & 0x1F];
+    Vector vt = loadVt(opcode);
+    Vector vs = load(registers[(opcode >> 11) & 0x1F]);
     uint16_t *vd = registers[(opcode >> 6) & 0x1F];
-    const uint8_t *e = elements[(opcode >> 21) & 0xF];
+    Vector carryIn = fromBits(vco);
 
     // Add two vector registers with signed clamping and modifier for the second
-    for (int i = 0; i < 8; i++)
-        accumulator[i] = vs[i] + vt[e[i]] + ((vco >> i) & 1);
-    for (int i = 0; i < 8; i++) {
-        vd[i] = clampSigned(accumulator[i]);
-        accumulator[i] &= 0xFFFF;
-    }
+    // The carry is added to the smaller operand so that only the last addition can saturate
+    Vector sum = subSat(minimum(vs, vt), carryIn);
+    setAccumulator(makeWide(splat(0), splat(0), sub(add(vs, vt), carryIn)));
+    store(vd, addSat(sum, maximum(vs, vt)));
     vco = 0;
 }
 
 void RSP_CP2::vsub(uint32_t opcode) {
     // Decode the operands
-    int16_t *vt = (int16_t*)registers[(opcode >> 16) & 0x1F];
-    int16_t *vs = (int16_t*)registers[(opcode >> 11) & 0x1F];
+    Vector vt = loadVt(opcode);
+    Vector vs = load(registers[(opcode >> 11) & 0x1F]);
     uint16_t *vd = registers[(opcode >> 6) & 0x1F];
-    const uint8_t *e = elements[(opcode >> 21) & 0xF];
+    Vector carryIn = fromBits(vco);
 
     // Subtract two vector registers with signed clamping and modifier for the second
-    for (int i = 0; i < 8; i++)
-        accumulator[i] = vs[i] - vt[e[i]] - ((vco >> i) & 1);
-    for (int i = 0; i < 8; i++) {
-        vd[i] = clampSigned(accumulator[i]);
-        accumulator[i] &= 0xFFFF;
-    }
+    // If adding the carry saturates the second operand, the missing 1 is subtracted after
+    Vector diff = sub(vt, carryIn), diffSat = subSat(vt, carryIn);
+    Vector res = addSat(subSat(vs, diffSat), cmpGt(diffSat, diff));
+    setAccumulator(makeWide(splat(0), splat(0), sub(vs, diff)));
+    store(vd, res);
     vco = 0;
 }
 
 void RSP_CP2::vabs(uint32_t opcode) {
     // Decode the operands
-    int16_t *vt = (int16_t*)registers[(opcode >> 16) & 0x1F];
-    int16_t *vs = (int16_t*)registers[(opcode >> 11) & 0x1F];
-    int16_t *vd = (int16_t*)registers[(opcode >> 6) & 0x1F];
-    const uint8_t *e = elements[(opcode >> 21) & 0xF];
+    Vector vt = loadVt(opcode);
+    Vector vs = load(registers[(opcode >> 11) & 0x1F]);
+    uint16_t *vd = registers[(opcode >> 6) & 0x1F];
+    Vector zero = splat(0);
 
     // Negate one vector register based on the sign of another register
-    for (int i = 0; i < 8; i++)
-        accumulator[i] = vs[i] ? ((vs[i] < 0) ? -vt[e[i]] : vt[e[i]]) : 0;
-    for (int i = 0; i < 8; i++)
-        vd[i] = accumulator[i];
+    Vector neg = signMask(vs);
+    Vector res = bitAndNot(cmpEq(vs, zero), sub(bitXor(vt, neg), neg));
+    Vector sign = bitOr(bitAnd(cmpGt(vs, zero), cmpLt(vt, zero)), bitAnd(cmpLt(vs, zero), cmpGt(vt, zero)));
+    setAccumulator(makeWide(sign, sign, res));
+    store(vd, res);
 }
 
 void RSP_CP2::vaddc(uint32_t opcode) {
     // Decode the operands
-    uint16_t *vt = registers[(opcode >> 16) & 0x1F];
-    uint16_t *vs = registers[(opcode >> 11) & 0x1F];
+    Vector vt = loadVt(opcode);
+    Vector vs = load(registers[(opcode >> 11) & 0x1F]);
     uint16_t *vd = registers[(opcode >> 6) & 0x1F];
-    const uint8_t *e = elements[(opcode >> 21) & 0xF];
 
     // Add two vector registers with modifier for the second, and set the overflow bits
-    vco = 0;
-    for (int i = 0; i < 8; i++) {
-        accumulator[i] = vs[i] + vt[e[i]];
-        vco |= ((accumulator[i] >> 16) & 1) << i;
-    }
-    for (int i = 0; i < 8; i++)
-        vd[i] = (accumulator[i] &= 0xFFFF);
+    Vector sum = add(vs, vt);
+    vco = toBits(carry(vs, vt, sum));
+    setAccumulator(makeWide(splat(0), splat(0), sum));
+    store(vd, sum);
 }
 
 void RSP_CP2::vsubc(uint32_t opcode) {
     // Decode the operands
-    uint16_t *vt = registers[(opcode >> 16) & 0x1F];
-    uint16_t *vs = registers[(opcode >> 11) & 0x1F];
+    Vector vt = loadVt(opcode);
+    Vector vs = load(registers[(opcode >> 11) & 0x1F]);
     uint16_t *vd = registers[(opcode >> 6) & 0x1F];
-    const uint8_t *e = elements[(opcode >> 21) & 0xF];
+    Vector flip = splat(0x8000);
 
     // Subtract two vector registers with modifier for the second, and set the overflow bits
-    vco = 0;
-    for (int i = 0; i < 8; i++) {
-        accumulator[i] = vs[i] - vt[e[i]];
-        vco |= (((accumulator[i] & 0x1FFF) ? 0x100 : 0) | ((accumulator[i] >> 16) & 1)) << i;
-    }
-    for (int i = 0; i < 8; i++)
-        vd[i] = (accumulator[i] &= 0xFFFF);
+    Vector diff = sub(vs, vt);
+    Vector borrow = cmpLt(bitXor(vs, flip), bitXor(vt, flip));
+    Vector equal = cmpEq(bitAnd(diff, splat(0x1FFF)), splat(0));
+    vco = (toBits(bitAndNot(equal, splat(-1))) << 8) | toBits(borrow);
+    setAccumulator(makeWide(splat(0), splat(0), diff));
+    store(vd, diff);
 }
 
 void RSP_CP2::vsar(uint32_t opcode) {
     // Decode the operands
     uint16_t *vd = registers[(opcode >> 6) & 0x1F];
-    int shift = ((2 - (opcode >> 21)) & 0x3) * 16;
+    int slice = (2 - (opcode >> 21)) & 0x3;
 
     // Load a vector register with 16-bit portions of the accumulator
-    for (int i = 0; i < 8; i++)
-        vd[i] = accumulator[i] >> shift;
+    store(vd, (slice < 3) ? load(accumulator[slice]) : signMask(load(accumulator[2])));
 }
 
 void RSP_CP2::vlt(uint32_t opcode) {
     // Decode the operands
-    int16_t *vt = (int16_t*)registers[(opcode >> 16) & 0x1F];
-    int16_t *vs = (int16_t*)registers[(opcode >> 11) & 0x1F];
+    Vector vt = loadVt(opcode);
+    Vector vs = load(registers[(opcode >> 11) & 0x1F]);
     uint16_t *vd = registers[(opcode >> 6) & 0x1F];
-    const uint8_t *e = elements[(opcode >> 21) & 0xF];
 
     // Perform a less than comparison on two vector registers, and set the compare bits
-    vcc = 0;
-    for (int i = 0; i < 8; i++) {
-        bool res = (vs[i] < vt[e[i]] || (vs[i] == vt[e[i]] && (((vco & (vco >> 8)) >> i) & 1)));
-        accumulator[i] = res ? vs[i] : vt[e[i]];
-        vcc |= res << i;
-    }
-    for (int i = 0; i < 8; i++)
-        vd[i] = accumulator[i];
+    Vector res = bitOr(cmpLt(vs, vt), bitAnd(cmpEq(vs, vt), fromBits(vco & (vco >> 8))));
+    Vector value = blend(res, vs, vt);
+    setAccumulator(makeWide(signMask(value), signMask(value), value));
+    store(vd, value);
+    vcc = toBits(res);
     vco = 0;
 }
 
 void RSP_CP2::veq(uint32_t opcode) {
     // Decode the operands
-    int16_t *vt = (int16_t*)registers[(opcode >> 16) & 0x1F];
-    int16_t *vs = (int16_t*)registers[(opcode >> 11) & 0x1F];
+    Vector vt = loadVt(opcode);
+    Vector vs = load(registers[(opcode >> 11) & 0x1F]);
     uint16_t *vd = registers[(opcode >> 6) & 0x1F];
-    const uint8_t *e = elements[(opcode >> 21) & 0xF];
 
     // Perform an equal comparison on two vector registers, and set the compare bits
-    vcc = 0;
-    for (int i = 0; i < 8; i++) {
-        bool res = (vs[i] == vt[e[i]] && !(vco & (0x100 << i)));
-        accumulator[i] = res ? vs[i] : vt[e[i]];
-        vcc |= res << i;
-    }
-    for (int i = 0; i < 8; i++)
-        vd[i] = accumulator[i];
+    Vector res = bitAndNot(fromBits(vco >> 8), cmpEq(vs, vt));
+    Vector value = blend(res, vs, vt);
+    setAccumulator(makeWide(signMask(value), signMask(value), value));
+    store(vd, value);
+    vcc = toBits(res);
     vco = 0;
 }
 
 void RSP_CP2::vne(uint32_t opcode) {
     // Decode the operands
-    int16_t *vt = (int16_t*)registers[(opcode >> 16) & 0x1F];
-    int16_t *vs = (int16_t*)registers[(opcode >> 11) & 0x1F];
+    Vector vt = loadVt(opcode);
+    Vector vs = load(registers[(opcode >> 11) & 0x1F]);
     uint16_t *vd = registers[(opcode >> 6) & 0x1F];
-    const uint8_t *e = elements[(opcode >> 21) & 0xF];
 
     // Perform a not equal comparison on two vector registers, and set the compare bits
-    vcc = 0;
-    for (int i = 0; i < 8; i++) {
-        bool res = (vs[i] != vt[e[i]] || (vco & (0x100 << i)));
-        accumulator[i] = res ? vs[i] : vt[e[i]];
-        vcc |= res << i;
-    }
-    for (int i = 0; i < 8; i++)
-        vd[i] = accumulator[i];
+    Vector res = bitOr(bitAndNot(cmpEq(vs, vt), splat(-1)), fromBits(vco >> 8));
+    Vector value = blend(res, vs, vt);
+    setAccumulator(makeWide(signMask(value), signMask(value), value));
+    store(vd, value);
+    vcc = toBits(res);
     vco = 0;
 }
 
 void RSP_CP2::vge(uint32_t opcode) {
     // Decode the operands
-    int16_t *vt = (int16_t*)registers[(opcode >> 16) & 0x1F];
-    int16_t *vs = (int16_t*)registers[(opcode >> 11) & 0x1F];
+    Vector vt = loadVt(opcode);
+    Vector vs = load(registers[(opcode >> 11) & 0x1F]);
     uint16_t *vd = registers[(opcode >> 6) & 0x1F];
-    const uint8_t *e = elements[(opcode >> 21) & 0xF];
 
     // Perform a greater or equal comparison on two vector registers, and set the compare bits
-    vcc = 0;
-    for (int i = 0; i < 8; i++) {
-        bool res = (vs[i] > vt[e[i]] || (vs[i] == vt[e[i]] && !(((vco & (vco >> 8)) >> i) & 1)));
-        accumulator[i] = res ? vs[i] : vt[e[i]];
-        vcc |= res << i;
-    }
-    for (int i = 0; i < 8; i++)
-        vd[i] = accumulator[i];
+    Vector res = bitOr(cmpGt(vs, vt), bitAndNot(fromBits(vco & (vco >> 8)), cmpEq(vs, vt)));
+    Vector value = blend(res, vs, vt);
+    setAccumulator(makeWide(signMask(value), signMask(value), value));
+    store(vd, value);
+    vcc = toBits(res);
     vco = 0;
 }
 
 void RSP_CP2::vcl(uint32_t opcode) {
     // Decode the operands
-    uint16_t *vt = registers[(opcode >> 16) & 0x1F];
-    uint16_t *vs = registers[(opcode >> 11) & 0x1F];
+    Vector vt = loadVt(opcode);
+    Vector vs = load(registers[(opcode >> 11) & 0x1F]);
     uint16_t *vd = registers[(opcode >> 6) & 0x1F];
-    const uint8_t *e = elements[(opcode >> 21) & 0xF];
+    Vector flip = splat(0x8000), zero = splat(0);
 
     // Clip a vector register, treating it as the lower half of 32-bit values following VCH
-    for (int i = 0; i < 8; i++) {
-        if (!((vco >> i) & 0x101))
-            vcc = (vcc & ~(0x100 << i)) | ((vs[i] >= vt[e[i]]) << (i + 8));
-        else if (((vco >> i) & 0x101) == 0x1)
-            vcc = (vcc & ~(1 << i)) | ((((vce >> i) & 1) ? (vs[i] <= -vt[e[i]]) : (vs[i] == -vt[e[i]])) << i);
-        bool diff = (vco >> i) & 1;
-        int16_t abs = (diff ? -vt[e[i]] : vt[e[i]]);
-        accumulator[i] = ((vcc >> (!diff * 8 + i)) & 1) ? abs : vs[i];
-    }
-    for (int i = 0; i < 8; i++)
-        vd[i] = accumulator[i];
+    Vector diff = fromBits(vco), upper = fromBits(vco >> 8);
+    Vector ge = bitAndNot(cmpLt(bitXor(vs, flip), bitXor(vt, flip)), splat(-1));
+    Vector le = bitAnd(cmpEq(vs, zero), cmpEq(vt, zero));
+    Vector vccHi = blend(bitOr(diff, upper), fromBits(vcc >> 8), ge);
+    Vector vccLo = blend(bitAndNot(upper, diff), le, fromBits(vcc));
+    Vector abs = sub(bitXor(vt, diff), diff);
+    Vector sel = blend(diff, vccLo, vccHi);
+    Vector sign = bitAnd(sel, signMask(abs));
+    Vector value = blend(sel, abs, vs);
+    setAccumulator(makeWide(sign, sign, value));
+    store(vd, value);
+    vcc = (toBits(vccHi) << 8) | toBits(vccLo);
     vco = vce = 0;
 }
 
 void RSP_CP2::vch(uint32_t opcode) {
     // Decode the operands
-    int16_t *vt = (int16_t*)registers[(opcode >> 16) & 0x1F];
-    int16_t *vs = (int16_t*)registers[(opcode >> 11) & 0x1F];
+    Vector vt = loadVt(opcode);
+    Vector vs = load(registers[(opcode >> 11) & 0x1F]);
     uint16_t *vd = registers[(opcode >> 6) & 0x1F];
-    const uint8_t *e = elements[(opcode >> 21) & 0xF];
+    Vector ones = splat(-1);
 
     // Clip a vector register with respect to another register, and set the status bits
-    vco = vcc = vce = 0;
-    for (int i = 0; i < 8; i++) {
-        bool diff = (vs[i] ^ vt[e[i]]) & 0x8000;
-        bool comp = (diff && vs[i] == -vt[e[i]] - 1);
-        int16_t abs = (diff ? -vt[e[i]] : vt[e[i]]);
-        vco |= (((!comp && vs[i] != abs) << 8) | diff) << i;
-        vcc |= (((vs[i] >= vt[e[i]]) << 8) | (vs[i] <= -vt[e[i]])) << i;
-        vce |= comp << i;
-        accumulator[i] = ((vcc >> (!diff * 8 + i)) & 1) ? abs : vs[i];
-    }
-    for (int i = 0; i < 8; i++)
-        vd[i] = accumulator[i];
+    Vector diff = signMask(bitXor(vs, vt));
+    Vector comp = bitAnd(diff, cmpEq(vs, bitXor(vt, ones)));
+    Vector abs = sub(bitXor(vt, diff), diff);
+    Vector ne = bitAndNot(bitOr(comp, cmpEq(vs, abs)), ones);
+    Vector vccHi = bitAndNot(cmpLt(vs, vt), ones);
+    Vector vccLo = bitOr(bitAndNot(cmpGt(vs, sub(splat(0), vt)), ones), cmpEq(vt, splat(0x8000)));
+    Vector value = blend(blend(diff, vccLo, vccHi), abs, vs);
+    setAccumulator(makeWide(signMask(value), signMask(value), value));
+    store(vd, value);
+    vco = (toBits(ne) << 8) | toBits(diff);
+    vcc = (toBits(vccHi) << 8) | toBits(vccLo);
+    vce = toBits(comp);
 }
 
 void RSP_CP2::vcr(uint32_t opcode) {
     // Decode the operands
-    int16_t *vt = (int16_t*)registers[(opcode >> 16) & 0x1F];
-    int16_t *vs = (int16_t*)registers[(opcode >> 11) & 0x1F];
+    Vector vt = loadVt(opcode);
+    Vector vs = load(registers[(opcode >> 11) & 0x1F]);
     uint16_t *vd = registers[(opcode >> 6) & 0x1F];
-    const uint8_t *e = elements[(opcode >> 21) & 0xF];
+    Vector ones = splat(-1);
 
     // Clip a vector register with respect to another register, using one's complement
-    vco = vcc = vce = 0;
-    for (int i = 0; i < 8; i++) {
-        bool diff = (vs[i] ^ vt[e[i]]) & 0x8000;
-        int16_t abs = (diff ? ~vt[e[i]] : vt[e[i]]);
-        vcc |= (((vs[i] >= vt[e[i]]) << 8) | (vs[i] <= ~vt[e[i]])) << i;
-        accumulator[i] = ((vcc >> (!diff * 8 + i)) & 1) ? abs : vs[i];
-    }
-    for (int i = 0; i < 8; i++)
-        vd[i] = accumulator[i];
+    Vector diff = signMask(bitXor(vs, vt));
+    Vector abs = bitXor(vt, diff);
+    Vector vccHi = bitAndNot(cmpLt(vs, vt), ones);
+    Vector vccLo = bitAndNot(cmpGt(vs, bitXor(vt, ones)), ones);
+    Vector value = blend(blend(diff, vccLo, vccHi), abs, vs);
+    setAccumulator(makeWide(signMask(value), signMask(value), value));
+    store(vd, value);
+    vcc = (toBits(vccHi) << 8) | toBits(vccLo);
+    vco = vce = 0;
 }
 
 void RSP_CP2::vmrg(uint32_t opcode) {
     // Decode the operands
-    uint16_t *vt = registers[(opcode >> 16) & 0x1F];
-    uint16_t *vs = registers[(opcode >> 11) & 0x1F];
+    Vector vt = loadVt(opcode);
+    Vector vs = load(registers[(opcode >> 11) & 0x1F]);
     uint16_t *vd = registers[(opcode >> 6) & 0x1F];
-    const uint8_t *e = elements[(opcode >> 21) & 0xF];
 
     // Merge two vector registers using the compare bits to choose lanes
-    for (int i = 0; i < 8; i++)
-        accumulator[i] = (vcc & (1 << i)) ? vs[i] : vt[e[i]];
-    for (int i = 0; i < 8; i++)
-        vd[i] = accumulator[i];
+    Vector value = blend(fromBits(vcc), vs, vt);
+    setAccumulator(makeWide(splat(0), splat(0), value));
+    store(vd, value);
 }
 
 void RSP_CP2::vand(uint32_t opcode) {
     // Decode the operands
-    uint16_t *vt = registers[(opcode >> 16) & 0x1F];
-    uint16_t *vs = registers[(opcode >> 11) & 0x1F];
+    Vector vt = loadVt(opcode);
+    Vector vs = load(registers[(opcode >> 11) & 0x1F]);
     uint16_t *vd = registers[(opcode >> 6) & 0x1F];
-    const uint8_t *e = elements[(opcode >> 21) & 0xF];
 
     // Bitwise and two vector registers with modifier for the second
-    for (int i = 0; i < 8; i++)
-        accumulator[i] = vs[i] & vt[e[i]];
-    for (int i = 0; i < 8; i++)
-        vd[i] = accumulator[i];
+    Vector value = bitAnd(vs, vt);
+    setAccumulator(makeWide(splat(0), splat(0), value));
+    store(vd, value);
 }
 
 void RSP_CP2::vnand(uint32_t opcode) {
     // Decode the operands
-    uint16_t *vt = registers[(opcode >> 16) & 0x1F];
-    uint16_t *vs = registers[(opcode >> 11) & 0x1F];
+    Vector vt = loadVt(opcode);
+    Vector vs = load(registers[(opcode >> 11) & 0x1F]);
     uint16_t *vd = registers[(opcode >> 6) & 0x1F];
-    const uint8_t *e = elements[(opcode >> 21) & 0xF];
 
     // Negated bitwise and two vector registers with modifier for the second
-    for (int i = 0; i < 8; i++)
-        accumulator[i] = (vs[i] & vt[e[i]]) ^ 0xFFFF;
-    for (int i = 0; i < 8; i++)
-        vd[i] = accumulator[i];
+    Vector value = bitXor(bitAnd(vs, vt), splat(-1));
+    setAccumulator(makeWide(splat(0), splat(0), value));
+    store(vd, value);
 }
 
 void RSP_CP2::vor(uint32_t opcode) {
     // Decode the operands
-    uint16_t *vt = registers[(opcode >> 16) & 0x1F];
-    uint16_t *vs = registers[(opcode >> 11) & 0x1F];
+    Vector vt = loadVt(opcode);
+    Vector vs = load(registers[(opcode >> 11) & 0x1F]);
     uint16_t *vd = registers[(opcode >> 6) & 0x1F];
-    const uint8_t *e = elements[(opcode >> 21) & 0xF];
 
     // Bitwise or two vector registers with modifier for the second
-    for (int i = 0; i < 8; i++)
-        accumulator[i] = vs[i] | vt[e[i]];
-    for (int i = 0; i < 8; i++)
-        vd[i] = accumulator[i];
+    Vector value = bitOr(vs, vt);
+    setAccumulator(makeWide(splat(0), splat(0), value));
+    store(vd, value);
 }
 
 void RSP_CP2::vnor(uint32_t opcode) {
     // Decode the operands
-    uint16_t *vt = registers[(opcode >> 16) & 0x1F];
-    uint16_t *vs = registers[(opcode >> 11) & 0x1F];
+    Vector vt = loadVt(opcode);
+    Vector vs = load(registers[(opcode >> 11) & 0x1F]);
     uint16_t *vd = registers[(opcode >> 6) & 0x1F];
-    const uint8_t *e = elements[(opcode >> 21) & 0xF];
 
     // Negated bitwise or two vector registers with modifier for the second
-    for (int i = 0; i < 8; i++)
-        accumulator[i] = (vs[i] | vt[e[i]]) ^ 0xFFFF;
-    for (int i = 0; i < 8; i++)
-        vd[i] = accumulator[i];
+    Vector value = bitXor(bitOr(vs, vt), splat(-1));
+    setAccumulator(makeWide(splat(0), splat(0), value));
+    store(vd, value);
 }
 
 void RSP_CP2::vxor(uint32_t opcode) {
     // Decode the operands
-    uint16_t *vt = registers[(opcode >> 16) & 0x1F];
-    uint16_t *vs = registers[(opcode >> 11) & 0x1F];
+    Vector vt = loadVt(opcode);
+    Vector vs = load(registers[(opcode >> 11) & 0x1F]);
     uint16_t *vd = registers[(opcode >> 6) & 0x1F];
-    const uint8_t *e = elements[(opcode >> 21) & 0xF];
 
     // Bitwise exclusive or two vector registers with modifier for the second
-    for (int i = 0; i < 8; i++)
-        accumulator[i] = vs[i] ^ vt[e[i]];
-    for (int i = 0; i < 8; i++)
-        vd[i] = accumulator[i];
+    Vector value = bitXor(vs, vt);
+    setAccumulator(makeWide(splat(0), splat(0), value));
+    store(vd, value);
 }
 
 void RSP_CP2::vnxor(uint32_t opcode) {
     // Decode the operands
-    uint16_t *vt = registers[(opcode >> 16) & 0x1F];
-    uint16_t *vs = registers[(opcode >> 11) & 0x1F];
+    Vector vt = loadVt(opcode);
+    Vector vs = load(registers[(opcode >> 11) & 0x1F]);
     uint16_t *vd = registers[(opcode >> 6) & 0x1F];
-    const uint8_t *e = elements[(opcode >> 21) & 0xF];
 
     // Negated bitwise exclusive or two vector registers with modifier for the second
-    for (int i = 0; i < 8; i++)
-        accumulator[i] = (vs[i] ^ vt[e[i]]) ^ 0xFFFF;
-    for (int i = 0; i < 8; i++)
-        vd[i] = accumulator[i];
+    Vector value = bitXor(bitXor(vs, vt), splat(-1));
+    setAccumulator(makeWide(splat(0), splat(0), value));
+    store(vd, value);
 }
 
 void RSP_CP2::vrcp(uint32_t opcode) {
@@ -869,8 +1075,7 @@ void RSP_CP2::vrcp(uint32_t opcode) {
     divIn = 0;
 
     // Lookup the 32-bit reciprocal of a signed 16-bit value
-    for (int i = 0; i < 8; i++)
-        accumulator[i] = vt[i];
+    setAccumulator(makeWide(splat(0), splat(0), load(vt)));
     uint32_t value = abs(vte);
     int shift; for (shift = 0; value >> shift; shift++);
     uint32_t result = rcpTable[((value << (32 - shift)) >> 22) & 0x1FF];
@@ -887,8 +1092,7 @@ void RSP_CP2::vrcpl(uint32_t opcode) {
     divIn = 0;
 
     // Lookup the 32-bit reciprocal of a signed 32-bit value, or 16 if upper isn't set
-    for (int i = 0; i < 8; i++)
-        accumulator[i] = vt[i];
+    setAccumulator(makeWide(splat(0), splat(0), load(vt)));
     uint32_t value = abs(vte);
     int shift; for (shift = 0; value >> shift; shift++);
     uint32_t result = rcpTable[((value << (32 - shift)) >> 22) & 0x1FF];
@@ -903,8 +1107,7 @@ void RSP_CP2::vrcph(uint32_t opcode) {
     uint16_t &vd = registers[(opcode >> 6) & 0x1F][(opcode >> 11) & 0x7];
 
     // Set the upper half of the reciprocal input and get the lower half of the output
-    for (int i = 0; i < 8; i++)
-        accumulator[i] = vt[i];
+    setAccumulator(makeWide(splat(0), splat(0), load(vt)));
     divIn = 0x10000 | vt[(opcode >> 21) & 0x7];
     vd = divOut;
 }
@@ -915,8 +1118,7 @@ void RSP_CP2::vmov(uint32_t opcode) {
     uint16_t &vd = registers[(opcode >> 6) & 0x1F][(opcode >> 11) & 0x7];
 
     // Copy a single lane from one vector register to another
-    for (int i = 0; i < 8; i++)
-        accumulator[i] = vt[i];
+    setAccumulator(makeWide(splat(0), splat(0), load(vt)));
     vd = vt[(opcode >> 21) & 0x7];
 }
 
@@ -928,8 +1130,7 @@ void RSP_CP2::vrsq(uint32_t opcode) {
     divIn = 0;
 
     // Lookup the 32-bit reciprocal of the square root of a signed 16-bit value
-    for (int i = 0; i < 8; i++)
-        accumulator[i] = vt[i];
+    setAccumulator(makeWide(splat(0), splat(0), load(vt)));
     uint32_t value = abs(vte);
     int shift; for (shift = 0; value >> shift; shift++);
     uint32_t result = rsqTable[((~shift & 1) << 8) | (((value << (32 - shift)) >> 23) & 0xFF)];
@@ -945,8 +1146,7 @@ void RSP_CP2::vrsql(uint32_t opcode) {
     divIn = 0;
 
     // Lookup the 32-bit reciprocal of the square root of a signed 32-bit value, or 16 if upper isn't set
-    for (int i = 0; i < 8; i++)
-        accumulator[i] = vt[i];
+    setAccumulator(makeWide(splat(0), splat(0), load(vt)));
     uint32_t value = abs(vte);
     int shift; for (shift = 0; value >> shift; shift++);
     uint32_t result = rsqTable[((~shift & 1) << 8) | (((value << (32 - shift)) >> 23) & 0xFF)];
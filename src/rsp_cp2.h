@@ -22,6 +22,9 @@
 #include <cstdint>
 
 namespace RSP_CP2 {
+    extern uint16_t registers[32][8];
+    extern uint16_t accumulator[3][8];
+    extern uint16_t vco;
     extern void (*vecInstrs[])(uint32_t);
 
     void reset();
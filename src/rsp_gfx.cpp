@@ -0,0 +1,900 @@
+/*
+    Copyright 2022-2026 Hydr8gon
+
+    This file is part of rokuyon.
+
+    rokuyon is free software: you can redistribute it and/or modify it
+    under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    rokuyon is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with rokuyon. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "rsp_gfx.h"
+#include "log.h"
+#include "memory.h"
+#include "rdp.h"
+
+// Geometry mode bits, in the original GBI layout that GBI2 modes are converted to
+#define G_ZBUFFER 0x00001
+#define G_SHADE 0x00004
+#define G_SHADING_SMOOTH 0x00200
+#define G_CULL_FRONT 0x01000
+#define G_CULL_BACK 0x02000
+#define G_FOG 0x10000
+#define G_LIGHTING 0x20000
+#define G_TEXTURE_GEN 0x40000
+#define G_TEXTURE_GEN_LINEAR 0x80000
+
+// Vertex clip flags, for the near plane and guard band that get clipped, and the rest of the view volume
+#define CLIP_NEAR 0x001
+#define CLIP_LEFT 0x002
+#define CLIP_RIGHT 0x004
+#define CLIP_TOP 0x008
+#define CLIP_BOTTOM 0x010
+#define VIEW_LEFT 0x020
+#define VIEW_RIGHT 0x040
+#define VIEW_TOP 0x080
+#define VIEW_BOTTOM 0x100
+#define VIEW_FAR 0x200
+
+#define STACK_SIZE 18
+
+struct Vertex {
+    float x, y, z, w;
+    float r, g, b, a;
+    float s, t;
+    uint16_t clip;
+};
+
+struct ScreenVertex {
+    float x, y;
+    float attr[8]; // R, G, B, A, S, T, 1/W, Z
+};
+
+struct Light {
+    float r, g, b;
+    float x, y, z;
+};
+
+namespace RSP_GFX {
+    std::vector<uint64_t> output;
+    bool gbi2;
+    bool running;
+    uint32_t pc;
+
+    uint32_t segments[16];
+    uint32_t dlStack[STACK_SIZE];
+    int dlIndex;
+    uint32_t rdpHalf1;
+
+    float modelview[STACK_SIZE][4][4];
+    float projection[4][4];
+    float combined[4][4];
+    int mvIndex;
+    bool combinedDirty;
+
+    Vertex vertices[64];
+    Light lights[10];
+    Light lookAt[2];
+    int numLights;
+    int16_t viewport[8];
+
+    uint32_t geometryMode;
+    uint32_t rawMode;
+    uint32_t otherModeH;
+    uint32_t otherModeL;
+    bool texOn;
+    uint8_t texTile;
+    uint8_t texLevel;
+    float texScaleS;
+    float texScaleT;
+    int16_t fogMult;
+    int16_t fogOffset;
+
+    uint32_t read32(uint32_t address);
+    uint32_t segAddr(uint32_t address);
+
+    void runGbi1(uint32_t w0, uint32_t w1);
+    void runGbi2(uint32_t w0, uint32_t w1);
+    void runRdp(uint32_t w0, uint32_t w1);
+
+    void callList(uint32_t address, bool branch);
+    void endList();
+    void cullList(int first, int last);
+    void branchZ(int index, int32_t z);
+
+    void readMatrix(uint32_t address, float (*m)[4]);
+    void multiply(float (*dst)[4], float (*a)[4], float (*b)[4]);
+    void loadMatrix(uint32_t address, bool proj, bool load, bool push);
+    void popMatrix(int count);
+    void loadLight(Light &light, uint32_t address);
+    void loadViewport(uint32_t address);
+    void moveWord(uint8_t index, uint16_t offset, uint32_t value);
+    void setTexture(uint32_t w0, uint32_t w1, bool on);
+    void setOtherMode(bool high, int shift, int length, uint32_t value);
+
+    void loadVertices(uint32_t address, int index, int count);
+    void modifyVertex(int index, int where, uint32_t value);
+    void drawTriangle(int i1, int i2, int i3);
+    int clipPolygon(Vertex *dst, const Vertex *src, int count, uint16_t plane);
+    void emitTriangle(const ScreenVertex &v1, const ScreenVertex &v2, const ScreenVertex &v3);
+    int32_t toFixed(float value);
+    uint64_t packInt(const int32_t *values);
+    uint64_t packFrac(const int32_t *values);
+}
+
+void RSP_GFX::runTask(uint32_t dataPtr, bool gbi2) {
+    // Reset the state that the microcode would initialize at the start of a task
+    RSP_GFX::gbi2 = gbi2;
+    memset(segments, 0, sizeof(segments));
+    memset(modelview, 0, sizeof(modelview));
+    memset(projection, 0, sizeof(projection));
+    for (int i = 0; i < 4; i++)
+        modelview[0][i][i] = projection[i][i] = 1.0f;
+    memset(lights, 0, sizeof(lights));
+    memset(lookAt, 0, sizeof(lookAt));
+    static const int16_t defViewport[] = { 640, 480, 511, 0, 640, 480, 511, 0 };
+    memcpy(viewport, defViewport, sizeof(viewport));
+    dlIndex = mvIndex = numLights = 0;
+    combinedDirty = true;
+    geometryMode = rawMode = 0;
+    otherModeH = otherModeL = 0;
+    texOn = false;
+    texTile = texLevel = 0;
+    texScaleS = texScaleT = 1.0f;
+    fogMult = fogOffset = 0;
+    rdpHalf1 = 0;
+
+    // Run the display list, with a limit in case it loops forever
+    pc = dataPtr & 0xFFFFFF;
+    running = true;
+    for (int i = 0; running && i < 0x100000; i++) {
+        uint32_t w0 = read32(pc);
+        uint32_t w1 = read32(pc + 4);
+        pc += 8;
+        if (gbi2)
+            runGbi2(w0, w1);
+        else
+            runGbi1(w0, w1);
+    }
+
+    // Send everything that was generated to the RDP
+    RDP::sendCommands(output.data(), output.size());
+    output.clear();
+}
+
+inline uint32_t RSP_GFX::read32(uint32_t address) {
+    // Read a word from RDRAM at a physical address
+    return Memory::read<uint32_t>(0x80000000 + (address & 0xFFFFFF));
+}
+
+inline uint32_t RSP_GFX::segAddr(uint32_t address) {
+    // Convert a segmented address to a physical one
+    return (segments[(address >> 24) & 0xF] + address) & 0xFFFFFF;
+}
+
+void RSP_GFX::runGbi1(uint32_t w0, uint32_t w1) {
+    // Execute a display list command for F3DEX, which uses the original GBI
+    switch (w0 >> 24) {
+    case 0x00: // G_SPNOOP
+        return;
+
+    case 0x01: // G_MTX
+        return loadMatrix(segAddr(w1), w0 & 0x10000, w0 & 0x20000, w0 & 0x40000);
+
+    case 0x03: { // G_MOVEMEM
+        uint8_t index = w0 >> 16;
+        if (index == 0x80)
+            return loadViewport(segAddr(w1));
+        else if (index == 0x82 || index == 0x84)
+            return loadLight(lookAt[(0x84 - index) >> 1], segAddr(w1));
+        else if (index >= 0x86 && index <= 0x94)
+            return loadLight(lights[(index - 0x86) >> 1], segAddr(w1));
+        return;
+    }
+
+    case 0x04: // G_VTX
+        return loadVertices(segAddr(w1), (w0 >> 17) & 0x7F, (w0 >> 10) & 0x3F);
+
+    case 0x06: // G_DL
+        return callList(segAddr(w1), w0 & 0x10000);
+
+    case 0xAF: // G_LOAD_UCODE
+        LOG_WARN("Unsupported microcode switch in graphics HLE\n");
+        running = false;
+        return;
+
+    case 0xB0: // G_BRANCH_Z
+        return branchZ((w0 & 0xFFF) >> 1, w1);
+
+    case 0xB1: // G_TRI2
+        drawTriangle((w0 >> 17) & 0x7F, (w0 >> 9) & 0x7F, (w0 >> 1) & 0x7F);
+        return drawTriangle((w1 >> 17) & 0x7F, (w1 >> 9) & 0x7F, (w1 >> 1) & 0x7F);
+
+    case 0xB2: // G_MODIFYVTX
+        return modifyVertex((w0 & 0xFFFF) >> 1, (w0 >> 16) & 0xFF, w1);
+
+    case 0xB3: // G_RDPHALF_2
+    case 0xB5: // G_LINE3D
+        return;
+
+    case 0xB4: // G_RDPHALF_1
+        rdpHalf1 = w1;
+        return;
+
+    case 0xB6: // G_CLEARGEOMETRYMODE
+        geometryMode &= ~w1;
+        return;
+
+    case 0xB7: // G_SETGEOMETRYMODE
+        geometryMode |= w1;
+        return;
+
+    case 0xB8: // G_ENDDL
+        return endList();
+
+    case 0xB9: // G_SETOTHERMODE_L
+    case 0xBA: // G_SETOTHERMODE_H
+        return setOtherMode((w0 >> 24) == 0xBA, (w0 >> 8) & 0xFF, w0 & 0xFF, w1);
+
+    case 0xBB: // G_TEXTURE
+        return setTexture(w0, w1, w0 & 0xFF);
+
+    case 0xBC: // G_MOVEWORD
+        return moveWord(w0, w0 >> 8, w1);
+
+    case 0xBD: // G_POPMTX
+        return popMatrix(1);
+
+    case 0xBE: // G_CULLDL
+        return cullList((w0 & 0xFFFF) >> 1, (w1 & 0xFFFF) >> 1);
+
+    case 0xBF: // G_TRI1
+        return drawTriangle((w1 >> 17) & 0x7F, (w1 >> 9) & 0x7F, (w1 >> 1) & 0x7F);
+
+    default:
+        if ((w0 >> 24) >= 0xE4)
+            return runRdp(w0, w1);
+        LOG_WARN("Unknown F3DEX command: 0x%08X%08X\n", w0, w1);
+        return;
+    }
+}
+
+void RSP_GFX::runGbi2(uint32_t w0, uint32_t w1) {
+    // Execute a display list command for F3DEX2, which uses GBI2
+    switch (w0 >> 24) {
+    case 0x00: // G_NOOP
+    case 0x08: // G_LINE3D
+    case 0xD3: case 0xD4: case 0xD5: // G_SPECIAL
+    case 0xD6: // G_DMA_IO
+    case 0xE0: // G_SPNOOP
+    case 0xF1: // G_RDPHALF_2
+        return;
+
+    case 0x01: // G_VTX
+        return loadVertices(segAddr(w1), ((w0 >> 1) & 0x7F) - ((w0 >> 12) & 0xFF), (w0 >> 12) & 0xFF);
+
+    case 0x02: // G_MODIFYVTX
+        return modifyVertex((w0 & 0xFFFF) >> 1, (w0 >> 16) & 0xFF, w1);
+
+    case 0x03: // G_CULLDL
+        return cullList((w0 & 0xFFFF) >> 1, (w1 & 0xFFFF) >> 1);
+
+    case 0x04: // G_BRANCH_Z
+        return branchZ((w0 & 0xFFF) >> 1, w1);
+
+    case 0x05: // G_TRI1
+        return drawTriangle((w0 >> 17) & 0x7F, (w0 >> 9) & 0x7F, (w0 >> 1) & 0x7F);
+
+    case 0x06: // G_TRI2
+    case 0x07: // G_QUAD
+        drawTriangle((w0 >> 17) & 0x7F, (w0 >> 9) & 0x7F, (w0 >> 1) & 0x7F);
+        return drawTriangle((w1 >> 17) & 0x7F, (w1 >> 9) & 0x7F, (w1 >> 1) & 0x7F);
+
+    case 0xD7: // G_TEXTURE
+        return setTexture(w0, w1, (w0 >> 1) & 0x7F);
+
+    case 0xD8: // G_POPMTX
+        return popMatrix(w1 >> 6);
+
+    case 0xD9: // G_GEOMETRYMODE
+        // Apply the mode in GBI2 layout, and convert it to the original GBI layout
+        rawMode = (rawMode & w0 & 0xFFFFFF) | w1;
+        geometryMode = (rawMode & ~0x200600) | ((rawMode & 0x200000) >> 12) | ((rawMode & 0x600) << 3);
+        return;
+
+    case 0xDA: // G_MTX
+        // The push flag is inverted in GBI2
+        return loadMatrix(segAddr(w1), w0 & 0x4, w0 & 0x2, !(w0 & 0x1));
+
+    case 0xDB: // G_MOVEWORD
+        return moveWord(w0 >> 16, w0, w1);
+
+    case 0xDC: { // G_MOVEMEM
+        uint32_t offset = ((w0 >> 8) & 0xFF) << 3;
+        switch (w0 & 0xFF) {
+        case 8: // G_MV_VIEWPORT
+            return loadViewport(segAddr(w1));
+
+        case 10: // G_MV_LIGHT
+            // Look-at vectors come first, followed by the lights
+            if (offset < 48)
+                return loadLight(lookAt[offset / 24], segAddr(w1));
+            else if (offset / 24 - 2 < 10)
+                return loadLight(lights[offset / 24 - 2], segAddr(w1));
+            return;
+
+        case 14: // G_MV_MATRIX
+            // Force the combined matrix until another matrix is loaded
+            readMatrix(segAddr(w1), combined);
+            combinedDirty = false;
+            return;
+        }
+        return;
+    }
+
+    case 0xDD: // G_LOAD_UCODE
+        LOG_WARN("Unsupported microcode switch in graphics HLE\n");
+        running = false;
+        return;
+
+    case 0xDE: // G_DL
+        return callList(segAddr(w1), w0 & 0x10000);
+
+    case 0xDF: // G_ENDDL
+        return endList();
+
+    case 0xE1: // G_RDPHALF_1
+        rdpHalf1 = w1;
+        return;
+
+    case 0xE2: // G_SETOTHERMODE_L
+    case 0xE3: { // G_SETOTHERMODE_H
+        int length = (w0 & 0xFF) + 1;
+        return setOtherMode((w0 >> 24) == 0xE3, 32 - ((w0 >> 8) & 0xFF) - length, length, w1);
+    }
+
+    default:
+        if ((w0 >> 24) >= 0xE4)
+            return runRdp(w0, w1);
+        LOG_WARN("Unknown F3DEX2 command: 0x%08X%08X\n", w0, w1);
+        return;
+    }
+}
+
+void RSP_GFX::runRdp(uint32_t w0, uint32_t w1) {
+    // Pass a command through to the RDP, with some adjustments like the microcode would make
+    switch (w0 >> 24) {
+    case 0xE4: case 0xE5: // G_TEXRECT, G_TEXRECTFLIP
+        // Take the second parameter from the next two commands
+        output.push_back(((uint64_t)w0 << 32) | w1);
+        output.push_back(((uint64_t)read32(pc + 4) << 32) | read32(pc + 12));
+        pc += 16;
+        return;
+
+    case 0xEF: // G_RDPSETOTHERMODE
+        // Keep track of the other modes so they can be partially updated
+        otherModeH = w0 & 0xFFFFFF;
+        otherModeL = w1;
+        break;
+
+    case 0xFD: case 0xFE: case 0xFF: // G_SETTIMG, G_SETZIMG, G_SETCIMG
+        // Resolve segmented image addresses
+        w1 = segAddr(w1);
+        break;
+    }
+    output.push_back(((uint64_t)w0 << 32) | w1);
+}
+
+void RSP_GFX::callList(uint32_t address, bool branch) {
+    // Jump to another display list, saving the return address unless branching
+    if (!branch) {
+        if (dlIndex == STACK_SIZE) {
+            LOG_WARN("Display list stack overflow in graphics HLE\n");
+            return;
+        }
+        dlStack[dlIndex++] = pc;
+    }
+    pc = address;
+}
+
+void RSP_GFX::endList() {
+    // Return to the calling display list, or finish the task if there is none
+    if (dlIndex)
+        pc = dlStack[--dlIndex];
+    else
+        running = false;
+}
+
+void RSP_GFX::cullList(int first, int last) {
+    // End the display list if all vertices in a range are outside the same side of the view volume
+    uint16_t clip = 0xFFFF;
+    for (int i = first; i <= last; i++)
+        clip &= vertices[i & 0x3F].clip;
+    if (clip)
+        endList();
+}
+
+void RSP_GFX::branchZ(int index, int32_t z) {
+    // Branch to the list from G_RDPHALF_1 if a vertex's screen depth is closer than a value
+    Vertex &v = vertices[index & 0x3F];
+    float depth = (v.z / v.w) * viewport[2] + viewport[6];
+    if (depth > 0x3FF || depth * 65536.0f <= z)
+        pc = segAddr(rdpHalf1);
+}
+
+void RSP_GFX::readMatrix(uint32_t address, float (*m)[4]) {
+    // Read a matrix of 16.16 fixed-point values, with all integer parts before the fractional parts
+    for (int i = 0; i < 16; i += 2) {
+        uint32_t whole = read32(address + i * 2);
+        uint32_t frac = read32(address + 32 + i * 2);
+        m[i >> 2][(i & 3) + 0] = (int32_t)((whole & 0xFFFF0000) | (frac >> 16)) / 65536.0f;
+        m[i >> 2][(i & 3) + 1] = (int32_t)((whole << 16) | (frac & 0xFFFF)) / 65536.0f;
+    }
+}
+
+void RSP_GFX::multiply(float (*dst)[4], float (*a)[4], float (*b)[4]) {
+    // Multiply two matrices, allowing the destination to overlap
+    float result[4][4];
+    for (int i = 0; i < 4; i++)
+        for (int j = 0; j < 4; j++)
+            result[i][j] = a[i][0] * b[0][j] + a[i][1] * b[1][j] + a[i][2] * b[2][j] + a[i][3] * b[3][j];
+    memcpy(dst, result, sizeof(result));
+}
+
+void RSP_GFX::loadMatrix(uint32_t address, bool proj, bool load, bool push) {
+    // Read a matrix from memory
+    float m[4][4];
+    readMatrix(address, m);
+    combinedDirty = true;
+
+    // Load or multiply the projection matrix
+    if (proj) {
+        if (load)
+            memcpy(projection, m, sizeof(m));
+        else
+            multiply(projection, m, projection);
+        return;
+    }
+
+    // Push the modelview matrix if requested, and load or multiply it
+    if (push && mvIndex < STACK_SIZE - 1) {
+        memcpy(modelview[mvIndex + 1], modelview[mvIndex], sizeof(m));
+        mvIndex++;
+    }
+    if (load)
+        memcpy(modelview[mvIndex], m, sizeof(m));
+    else
+        multiply(modelview[mvIndex], m, modelview[mvIndex]);
+}
+
+void RSP_GFX::popMatrix(int count) {
+    // Pop matrices off the modelview stack
+    mvIndex = std::max(0, mvIndex - count);
+    combinedDirty = true;
+}
+
+void RSP_GFX::loadLight(Light &light, uint32_t address) {
+    // Read a light's color and normalized direction from memory
+    uint32_t color = read32(address);
+    uint32_t dir = read32(address + 8);
+    light.r = (color >> 24) & 0xFF;
+    light.g = (color >> 16) & 0xFF;
+    light.b = (color >> 8) & 0xFF;
+    light.x = (int8_t)(dir >> 24);
+    light.y = (int8_t)(dir >> 16);
+    light.z = (int8_t)(dir >> 8);
+    if (float length = sqrtf(light.x * light.x + light.y * light.y + light.z * light.z)) {
+        light.x /= length;
+        light.y /= length;
+        light.z /= length;
+    }
+}
+
+void RSP_GFX::loadViewport(uint32_t address) {
+    // Read the viewport scale and translation values from memory
+    for (int i = 0; i < 8; i += 2) {
+        uint32_t value = read32(address + i * 2);
+        viewport[i + 0] = value >> 16;
+        viewport[i + 1] = value;
+    }
+}
+
+void RSP_GFX::moveWord(uint8_t index, uint16_t offset, uint32_t value) {
+    // Write a value to some part of the microcode state
+    switch (index) {
+    case 0x02: // G_MW_NUMLIGHT
+        numLights = std::min(7, std::max(0, gbi2 ? int(value / 24) : int(((value - 0x80000000) >> 5) - 1)));
+        return;
+
+    case 0x06: // G_MW_SEGMENT
+        segments[(offset >> 2) & 0xF] = value & 0xFFFFFF;
+        return;
+
+    case 0x08: // G_MW_FOG
+        fogMult = value >> 16;
+        fogOffset = value;
+        return;
+
+    case 0x0A: { // G_MW_LIGHTCOL
+        // Only update lights on their first color word, ignoring the copy
+        int stride = gbi2 ? 24 : 32;
+        if (!(offset % stride) && offset / stride < 10) {
+            Light &light = lights[offset / stride];
+            light.r = (value >> 24) & 0xFF;
+            light.g = (value >> 16) & 0xFF;
+            light.b = (value >> 8) & 0xFF;
+        }
+        return;
+    }
+
+    case 0x0C: // G_MW_POINTS
+        // Modify a vertex in F3DEX; this index is used to force matrices in F3DEX2
+        if (!gbi2)
+            modifyVertex(offset / 40, offset % 40, value);
+        return;
+    }
+}
+
+void RSP_GFX::setTexture(uint32_t w0, uint32_t w1, bool on) {
+    // Set the texture tile and level for triangles, and the scale for texture coordinates
+    texOn = on;
+    texTile = (w0 >> 8) & 0x7;
+    texLevel = (w0 >> 11) & 0x7;
+    texScaleS = (w1 >> 16) / 65536.0f;
+    texScaleT = (w1 & 0xFFFF) / 65536.0f;
+}
+
+void RSP_GFX::setOtherMode(bool high, int shift, int length, uint32_t value) {
+    // Update part of the RDP other modes and send them all to the RDP
+    uint32_t &mode = high ? otherModeH : otherModeL;
+    uint32_t mask = (uint32_t)(((1ULL << length) - 1) << shift);
+    mode = (mode & ~mask) | (value & mask);
+    output.push_back((0xEFULL << 56) | ((uint64_t)(otherModeH & 0xFFFFFF) << 32) | otherModeL);
+}
+
+void RSP_GFX::loadVertices(uint32_t address, int index, int count) {
+    // Update the combined matrix if it changed
+    if (combinedDirty) {
+        multiply(combined, modelview[mvIndex], projection);
+        combinedDirty = false;
+    }
+
+    for (int i = 0; i < count; i++) {
+        // Read a vertex from memory
+        Vertex &v = vertices[(index + i) & 0x3F];
+        uint32_t pos = read32(address + i * 16 + 0);
+        uint32_t posZ = read32(address + i * 16 + 4);
+        uint32_t tex = read32(address + i * 16 + 8);
+        uint32_t color = read32(address + i * 16 + 12);
+        float x = (int16_t)(pos >> 16), y = (int16_t)pos, z = (int16_t)(posZ >> 16);
+
+        // Transform the position into clip space
+        float (*m)[4] = combined;
+        v.x = x * m[0][0] + y * m[1][0] + z * m[2][0] + m[3][0];
+        v.y = x * m[0][1] + y * m[1][1] + z * m[2][1] + m[3][1];
+        v.z = x * m[0][2] + y * m[1][2] + z * m[2][2] + m[3][2];
+        v.w = x * m[0][3] + y * m[1][3] + z * m[2][3] + m[3][3];
+
+        // Use the vertex color and scaled texture coordinates as they are by default
+        v.r = (color >> 24) & 0xFF;
+        v.g = (color >> 16) & 0xFF;
+        v.b = (color >> 8) & 0xFF;
+        v.a = (color >> 0) & 0xFF;
+        v.s = (int16_t)(tex >> 16) * texScaleS;
+        v.t = (int16_t)tex * texScaleT;
+
+        if (geometryMode & G_LIGHTING) {
+            // Transform the normal from the color bytes by the modelview matrix
+            float (*mv)[4] = modelview[mvIndex];
+            float nx = (int8_t)(color >> 24), ny = (int8_t)(color >> 16), nz = (int8_t)(color >> 8);
+            float tx = nx * mv[0][0] + ny * mv[1][0] + nz * mv[2][0];
+            float ty = nx * mv[0][1] + ny * mv[1][1] + nz * mv[2][1];
+            float tz = nx * mv[0][2] + ny * mv[1][2] + nz * mv[2][2];
+            if (float length = sqrtf(tx * tx + ty * ty + tz * tz)) {
+                tx /= length;
+                ty /= length;
+                tz /= length;
+            }
+
+            // Add the directional lights that face the normal to the ambient light after them
+            float r = lights[numLights].r, g = lights[numLights].g, b = lights[numLights].b;
+            for (int j = 0; j < numLights; j++) {
+                float dot = tx * lights[j].x + ty * lights[j].y + tz * lights[j].z;
+                if (dot <= 0) continue;
+                r += lights[j].r * dot;
+                g += lights[j].g * dot;
+                b += lights[j].b * dot;
+            }
+            v.r = std::min(r, 255.0f);
+            v.g = std::min(g, 255.0f);
+            v.b = std::min(b, 255.0f);
+
+            // Generate texture coordinates from the normal and the look-at vectors if enabled
+            if (geometryMode & G_TEXTURE_GEN) {
+                float dx = tx * lookAt[0].x + ty * lookAt[0].y + tz * lookAt[0].z;
+                float dy = tx * lookAt[1].x + ty * lookAt[1].y + tz * lookAt[1].z;
+                if (geometryMode & G_TEXTURE_GEN_LINEAR) {
+                    dx = 1.0f - acosf(std::max(-1.0f, std::min(1.0f, dx))) * (2.0f / float(M_PI));
+                    dy = 1.0f - acosf(std::max(-1.0f, std::min(1.0f, dy))) * (2.0f / float(M_PI));
+                }
+                v.s = (dx + 1.0f) * 0x4000 * texScaleS;
+                v.t = (dy + 1.0f) * 0x4000 * texScaleT;
+            }
+        }
+
+        // Replace the alpha with a fog factor based on depth if enabled
+        if (geometryMode & G_FOG) {
+            float fog = (v.w > 0) ? ((v.z / v.w) * fogMult + fogOffset) : 0;
+            v.a = std::max(0.0f, std::min(255.0f, fog));
+        }
+
+        // Set flags for the planes the vertex is outside of
+        v.clip = 0;
+        if (v.z < -v.w) v.clip |= CLIP_NEAR;
+        if (v.x < -2 * v.w) v.clip |= CLIP_LEFT;
+        if (v.x > 2 * v.w) v.clip |= CLIP_RIGHT;
+        if (v.y > 2 * v.w) v.clip |= CLIP_TOP;
+        if (v.y < -2 * v.w) v.clip |= CLIP_BOTTOM;
+        if (v.x < -v.w) v.clip |= VIEW_LEFT;
+        if (v.x > v.w) v.clip |= VIEW_RIGHT;
+        if (v.y > v.w) v.clip |= VIEW_TOP;
+        if (v.y < -v.w) v.clip |= VIEW_BOTTOM;
+        if (v.z > v.w) v.clip |= VIEW_FAR;
+    }
+}
+
+void RSP_GFX::modifyVertex(int index, int where, uint32_t value) {
+    // Change part of a vertex that was already loaded
+    Vertex &v = vertices[index & 0x3F];
+    switch (where) {
+    case 0x10: // G_MWO_POINT_RGBA
+        v.r = (value >> 24) & 0xFF;
+        v.g = (value >> 16) & 0xFF;
+        v.b = (value >> 8) & 0xFF;
+        v.a = (value >> 0) & 0xFF;
+        return;
+
+    case 0x14: // G_MWO_POINT_ST
+        v.s = (int16_t)(value >> 16);
+        v.t = (int16_t)value;
+        return;
+
+    case 0x18: // G_MWO_POINT_XYSCREEN
+        // Move the vertex in clip space so it lands on the given screen position
+        v.x = ((int16_t)(value >> 16) - viewport[4]) / float(viewport[0]) * v.w;
+        v.y = -((int16_t)value - viewport[5]) / float(viewport[1]) * v.w;
+        return;
+    }
+}
+
+void RSP_GFX::drawTriangle(int i1, int i2, int i3) {
+    // Skip triangles that are entirely outside one side of the view volume
+    Vertex poly[2][16] = { { vertices[i1 & 0x3F], vertices[i2 & 0x3F], vertices[i3 & 0x3F] } };
+    if (poly[0][0].clip & poly[0][1].clip & poly[0][2].clip)
+        return;
+
+    // Use the first vertex color for the whole triangle without smooth shading
+    if (!(geometryMode & G_SHADING_SMOOTH)) {
+        for (int i = 1; i < 3; i++) {
+            poly[0][i].r = poly[0][0].r;
+            poly[0][i].g = poly[0][0].g;
+            poly[0][i].b = poly[0][0].b;
+            poly[0][i].a = poly[0][0].a;
+        }
+    }
+
+    // Clip the triangle against the near plane and the guard band, which can turn it into a polygon
+    int count = 3, cur = 0;
+    uint16_t clip = (poly[0][0].clip | poly[0][1].clip | poly[0][2].clip) & 0x1F;
+    for (uint16_t plane = 1; clip && count >= 3; plane <<= 1) {
+        if (!(clip & plane)) continue;
+        count = clipPolygon(poly[cur ^ 1], poly[cur], count, plane);
+        cur ^= 1;
+        clip &= ~plane;
+    }
+    if (count < 3)
+        return;
+
+    // Project the polygon to the screen
+    ScreenVertex screen[16];
+    for (int i = 0; i < count; i++) {
+        Vertex &v = poly[cur][i];
+        if (v.w <= 0) return;
+        float w = 1.0f / v.w;
+        screen[i].x = (v.x * w * viewport[0] + viewport[4]) / 4;
+        screen[i].y = (-v.y * w * viewport[1] + viewport[5]) / 4;
+        screen[i].attr[0] = v.r;
+        screen[i].attr[1] = v.g;
+        screen[i].attr[2] = v.b;
+        screen[i].attr[3] = v.a;
+        screen[i].attr[4] = v.s;
+        screen[i].attr[5] = v.t;
+        screen[i].attr[6] = w;
+        screen[i].attr[7] = (v.z * w * viewport[2] + viewport[6]) * 32;
+    }
+
+    // Cull the polygon by its winding, which is counter-clockwise for front faces with Y pointing up
+    float area = 0;
+    for (int i = 0; i < count; i++) {
+        ScreenVertex &a = screen[i], &b = screen[(i + 1) % count];
+        area += a.x * b.y - b.x * a.y;
+    }
+    if (area == 0 || (geometryMode & ((area < 0) ? G_CULL_FRONT : G_CULL_BACK)))
+        return;
+
+    // Draw the polygon as a fan of triangles
+    for (int i = 1; i < count - 1; i++)
+        emitTriangle(screen[0], screen[i], screen[i + 1]);
+}
+
+int RSP_GFX::clipPolygon(Vertex *dst, const Vertex *src, int count, uint16_t plane) {
+    // Get the signed distance of each vertex from the plane, with positive values inside
+    float dist[16];
+    for (int i = 0; i < count; i++) {
+        const Vertex &v = src[i];
+        switch (plane) {
+            case CLIP_NEAR: dist[i] = v.z + v.w; break;
+            case CLIP_LEFT: dist[i] = v.x + 2 * v.w; break;
+            case CLIP_RIGHT: dist[i] = 2 * v.w - v.x; break;
+            case CLIP_TOP: dist[i] = 2 * v.w - v.y; break;
+            default: dist[i] = v.y + 2 * v.w; break;
+        }
+    }
+
+    // Keep vertices inside the plane, and add new ones where edges cross it
+    int size = 0;
+    for (int i = 0; i < count && size < 15; i++) {
+        int j = (i + 1) % count;
+        if (dist[i] >= 0)
+            dst[size++] = src[i];
+        if ((dist[i] >= 0) != (dist[j] >= 0)) {
+            const Vertex &a = src[i], &b = src[j];
+            float t = dist[i] / (dist[i] - dist[j]);
+            Vertex &v = dst[size++];
+            v.x = a.x + (b.x - a.x) * t;
+            v.y = a.y + (b.y - a.y) * t;
+            v.z = a.z + (b.z - a.z) * t;
+            v.w = a.w + (b.w - a.w) * t;
+            v.r = a.r + (b.r - a.r) * t;
+            v.g = a.g + (b.g - a.g) * t;
+            v.b = a.b + (b.b - a.b) * t;
+            v.a = a.a + (b.a - a.a) * t;
+            v.s = a.s + (b.s - a.s) * t;
+            v.t = a.t + (b.t - a.t) * t;
+            v.clip = 0;
+        }
+    }
+    return size;
+}
+
+void RSP_GFX::emitTriangle(const ScreenVertex &v1, const ScreenVertex &v2, const ScreenVertex &v3) {
+    // Sort the vertices from top to bottom
+    const ScreenVertex *h = &v1, *m = &v2, *l = &v3;
+    if (m->y < h->y) std::swap(h, m);
+    if (l->y < m->y) std::swap(m, l);
+    if (m->y < h->y) std::swap(h, m);
+
+    // Get the Y-coords in 11.2 fixed-point, and skip triangles without any area
+    int32_t yh = std::max(-0x2000, std::min(0x1FFF, int32_t(lroundf(h->y * 4))));
+    int32_t ym = std::max(-0x2000, std::min(0x1FFF, int32_t(lroundf(m->y * 4))));
+    int32_t yl = std::max(-0x2000, std::min(0x1FFF, int32_t(lroundf(l->y * 4))));
+    float dx1 = m->x - h->x, dy1 = m->y - h->y;
+    float dx2 = l->x - h->x, dy2 = l->y - h->y;
+    float area = dx1 * dy2 - dx2 * dy1;
+    if (yh == yl || fabsf(area) < 1e-6f)
+        return;
+
+    // Calculate the edge slopes, and the X-coords where each edge starts on a whole scanline
+    // The high edge spans the whole triangle, the middle edge is above the middle vertex, and the low edge is below it
+    float dxhdy = dx2 / dy2;
+    float dxmdy = dy1 ? (dx1 / dy1) : 0;
+    float dxldy = (l->y != m->y) ? ((l->x - m->x) / (l->y - m->y)) : 0;
+    float top = floorf(h->y), mid = floorf(m->y);
+    float xh = h->x + dxhdy * (top - h->y);
+    float xm = h->x + dxmdy * (top - h->y);
+    float xl = m->x + dxldy * (mid - m->y);
+
+    // Gather the attributes, with texture coordinates divided by W normalized to the closest vertex
+    float attr[3][8];
+    const ScreenVertex *sorted[] = { h, m, l };
+    float maxW = std::max(h->attr[6], std::max(m->attr[6], l->attr[6]));
+    for (int i = 0; i < 3; i++) {
+        memcpy(attr[i], sorted[i]->attr, sizeof(attr[i]));
+        float w = attr[i][6] / maxW;
+        attr[i][4] *= w;
+        attr[i][5] *= w;
+        attr[i][6] = w * 0x7FFF;
+    }
+
+    // Calculate the attribute values at the start of the high edge, and their gradients along X, the edge, and Y
+    int32_t base[8], dadx[8], dade[8], dady[8];
+    for (int i = 0; i < 8; i++) {
+        float da1 = attr[1][i] - attr[0][i], da2 = attr[2][i] - attr[0][i];
+        float dx = (da1 * dy2 - da2 * dy1) / area;
+        float dy = (da2 * dx1 - da1 * dx2) / area;
+        float de = dy + dx * dxhdy;
+        base[i] = toFixed(attr[0][i] + de * (top - h->y));
+        dadx[i] = toFixed(dx);
+        dade[i] = toFixed(de);
+        dady[i] = toFixed(dy);
+    }
+
+    // Emit the edge coefficients, choosing the triangle type based on what's enabled
+    bool shade = geometryMode & G_SHADE;
+    bool texture = texOn;
+    bool depth = geometryMode & G_ZBUFFER;
+    output.push_back(((uint64_t)(0xC8 | (shade << 2) | (texture << 1) | depth) << 56) |
+        ((uint64_t)(area > 0) << 55) | ((uint64_t)texLevel << 51) | ((uint64_t)texTile << 48) |
+        ((uint64_t)(yl & 0x3FFF) << 32) | ((ym & 0x3FFF) << 16) | (yh & 0x3FFF));
+    output.push_back(((uint64_t)(uint32_t)toFixed(xl) << 32) | (uint32_t)toFixed(dxldy));
+    output.push_back(((uint64_t)(uint32_t)toFixed(xh) << 32) | (uint32_t)toFixed(dxhdy));
+    output.push_back(((uint64_t)(uint32_t)toFixed(xm) << 32) | (uint32_t)toFixed(dxmdy));
+
+    // Emit the shade coefficients, with integer and fractional parts split up
+    if (shade) {
+        output.push_back(packInt(&base[0]));
+        output.push_back(packInt(&dadx[0]));
+        output.push_back(packFrac(&base[0]));
+        output.push_back(packFrac(&dadx[0]));
+        output.push_back(packInt(&dade[0]));
+        output.push_back(packInt(&dady[0]));
+        output.push_back(packFrac(&dade[0]));
+        output.push_back(packFrac(&dady[0]));
+    }
+
+    // Emit the texture coefficients, with the last value unused
+    if (texture) {
+        base[7] = dadx[7] = dade[7] = dady[7] = 0;
+        output.push_back(packInt(&base[4]));
+        output.push_back(packInt(&dadx[4]));
+        output.push_back(packFrac(&base[4]));
+        output.push_back(packFrac(&dadx[4]));
+        output.push_back(packInt(&dade[4]));
+        output.push_back(packInt(&dady[4]));
+        output.push_back(packFrac(&dade[4]));
+        output.push_back(packFrac(&dady[4]));
+    }
+
+    // Emit the depth coefficients, as whole 16.16 values
+    if (depth) {
+        float z = attr[0][7], dzdx, dzdy;
+        float dz1 = attr[1][7] - z, dz2 = attr[2][7] - z;
+        dzdx = (dz1 * dy2 - dz2 * dy1) / area;
+        dzdy = (dz2 * dx1 - dz1 * dx2) / area;
+        float dzde = dzdy + dzdx * dxhdy;
+        output.push_back(((uint64_t)(uint32_t)toFixed(z + dzde * (top - h->y)) << 32) | (uint32_t)toFixed(dzdx));
+        output.push_back(((uint64_t)(uint32_t)toFixed(dzde) << 32) | (uint32_t)toFixed(dzdy));
+    }
+}
+
+inline int32_t RSP_GFX::toFixed(float value) {
+    // Convert a value to 16.16 fixed-point, saturating instead of overflowing
+    double fixed = value * 65536.0;
+    return (int32_t)std::max(-2147483648.0, std::min(2147483647.0, fixed));
+}
+
+inline uint64_t RSP_GFX::packInt(const int32_t *values) {
+    // Pack the integer parts of four 16.16 values into a parameter
+    return ((uint64_t)(values[0] >> 16 & 0xFFFF) << 48) | ((uint64_t)(values[1] >> 16 & 0xFFFF) << 32) |
+        ((uint64_t)(values[2] >> 16 & 0xFFFF) << 16) | ((uint64_t)(values[3] >> 16 & 0xFFFF) << 0);
+}
+
+inline uint64_t RSP_GFX::packFrac(const int32_t *values) {
+    // Pack the fractional parts of four 16.16 values into a parameter
+    return ((uint64_t)(values[0] & 0xFFFF) << 48) | ((uint64_t)(values[1] & 0xFFFF) << 32) |
+        ((uint64_t)(values[2] & 0xFFFF) << 16) | ((uint64_t)(values[3] & 0xFFFF) << 0);
+}
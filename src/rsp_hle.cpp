@@ -0,0 +1,127 @@
+/*
+    Copyright 2022-2026 Hydr8gon
+
+    This file is part of rokuyon.
+
+    rokuyon is free software: you can redistribute it and/or modify it
+    under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    rokuyon is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with rokuyon. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+
+#include "rsp_hle.h"
+#include "log.h"
+#include "memory.h"
+#include "rsp.h"
+#include "rsp_audio.h"
+#include "rsp_cp0.h"
+#include "rsp_gfx.h"
+#include "settings.h"
+
+enum Ucode {
+    UCODE_LLE = 0,
+    UCODE_F3DEX,
+    UCODE_F3DEX2,
+    UCODE_AUDIO
+};
+
+namespace RSP_HLE {
+    std::unordered_map<uint64_t, Ucode> ucodes;
+
+    Ucode identify(uint32_t text, uint32_t data, uint32_t dataSize);
+}
+
+void RSP_HLE::reset() {
+    // Forget any microcode that was identified
+    ucodes.clear();
+}
+
+bool RSP_HLE::runTask() {
+    // Only consider tasks that start from the beginning of IMEM, like the libultra boot code
+    if (RSP::readPC() != 0)
+        return false;
+
+    // Read the task header that libultra places at the end of DMEM
+    uint32_t type = Memory::read<uint32_t>(0xA4000FC0);
+    uint32_t ucode = Memory::read<uint32_t>(0xA4000FD0);
+    uint32_t ucodeData = Memory::read<uint32_t>(0xA4000FD8);
+    uint32_t ucodeSize = Memory::read<uint32_t>(0xA4000FDC);
+    uint32_t dataPtr = Memory::read<uint32_t>(0xA4000FF0);
+    uint32_t dataSize = Memory::read<uint32_t>(0xA4000FF4);
+
+    // Only consider graphics and audio tasks when HLE is enabled for them
+    if (!(type == 1 && Settings::gfxHle) && !(type == 2 && Settings::audioHle))
+        return false;
+
+    // Run the task natively if the microcode is supported, or fall back to the RSP
+    switch (identify(ucode, ucodeData, ucodeSize)) {
+        case UCODE_F3DEX: RSP_GFX::runTask(dataPtr, false); break;
+        case UCODE_F3DEX2: RSP_GFX::runTask(dataPtr, true); break;
+
+        case UCODE_AUDIO:
+            // Audio lists can still use things that aren't supported
+            if (!RSP_AUDIO::runTask(dataPtr, dataSize, ucodeData, ucodeSize))
+                return false;
+            break;
+
+        default:
+            return false;
+    }
+
+    // Finish the task like the microcode would, by signaling that it's done and breaking
+    RSP_CP0::write(4, 0x4000); // Set SIG2
+    RSP_CP0::triggerBreak();
+    return true;
+}
+
+Ucode RSP_HLE::identify(uint32_t text, uint32_t data, uint32_t dataSize) {
+    // Hash the microcode's text and data with FNV-1a
+    uint64_t hash = 0xCBF29CE484222325;
+    dataSize = std::min(dataSize, 0x1000U);
+    for (uint32_t i = 0; i < 0x1000; i += 4)
+        hash = (hash ^ Memory::read<uint32_t>(0x80000000 + ((text + i) & 0xFFFFFF))) * 0x100000001B3;
+    for (uint32_t i = 0; i < dataSize; i += 4)
+        hash = (hash ^ Memory::read<uint32_t>(0x80000000 + ((data + i) & 0xFFFFFF))) * 0x100000001B3;
+
+    // Reuse the result if this microcode has been seen before
+    auto entry = ucodes.find(hash);
+    if (entry != ucodes.end())
+        return entry->second;
+
+    // Look for the ID string that graphics microcode keeps in its data
+    std::string string(dataSize, '\0');
+    for (uint32_t i = 0; i < dataSize; i++)
+        string[i] = Memory::read<uint8_t>(0x80000000 + ((data + i) & 0xFFFFFF));
+    size_t index = string.find("RSP Gfx ucode ");
+
+    // Identify the F3DEX family by name, with version 1.x using the original GBI and 2.x using GBI2
+    // Anything else, like the original Fast3D or 2D microcode, is left to the RSP
+    Ucode ucode = UCODE_LLE;
+    if (index != std::string::npos && string.compare(index + 14, 3, "F3D") == 0) {
+        size_t version = string.find(" 1.", index);
+        size_t version2 = string.find(" 2.", index);
+        if (version2 < version)
+            ucode = UCODE_F3DEX2;
+        else if (version != std::string::npos)
+            ucode = UCODE_F3DEX;
+        LOG_INFO("Identified graphics microcode: %s\n", string.c_str() + index);
+    }
+    else if (RSP_AUDIO::findTable(data, dataSize) >= 0) {
+        // Identify the standard audio microcode by the resample table in its data
+        ucode = UCODE_AUDIO;
+        LOG_INFO("Identified standard audio microcode\n");
+    }
+    return ucodes[hash] = ucode;
+}
@@ -0,0 +1,1010 @@
+/*
+    Copyright 2022-2026 Hydr8gon
+
+    This file is part of rokuyon.
+
+    rokuyon is free software: you can redistribute it and/or modify it
+    under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    rokuyon is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with rokuyon. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <atomic>
+#include <cstring>
+#include <unordered_map>
+
+#include "rsp_jit.h"
+#include "log.h"
+#include "memory.h"
+#include "rsp.h"
+#include "rsp_cp2.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#define CODE_SIZE 0x400000
+#define BLOCK_SIZE 64
+#define MAX_TABLES 0x100
+
+typedef uint32_t (*Block)();
+typedef void (*Instr)(uint32_t);
+
+enum VecResult {
+    RES_LOW,
+    RES_MID,
+    RES_CLAMP_LOW,
+    RES_SIGNED,
+    RES_UNSIGNED
+};
+
+struct CodeTable {
+    uint32_t imem[0x400];
+    Block blocks[0x400];
+};
+
+namespace RSP_JIT {
+    uint8_t *codeBuffer;
+    uint8_t *codePtr;
+    uint8_t *epilogue;
+
+    std::unordered_map<uint64_t, CodeTable*> tables;
+    CodeTable *table;
+    std::atomic<bool> dirty;
+
+    alignas(16) const uint16_t carryLanes[8] = { 0x1, 0x2, 0x4, 0x8, 0x10, 0x20, 0x40, 0x80 };
+
+    uint32_t interpret();
+    void fetchNext();
+    void clearBlocks();
+    void findTable();
+    Block compileBlock(uint32_t index);
+
+    bool isBranch(uint32_t opcode);
+    bool isSync(uint32_t opcode);
+    Instr getInstr(uint32_t opcode);
+    void compileOpcode(uint32_t opcode);
+    bool compileAlu(uint32_t opcode);
+    bool compileVector(uint32_t opcode);
+    bool compileTransfer(uint32_t opcode);
+    void compileProduct(uint32_t opcode);
+    void compileAccumulate();
+    void compileResult(VecResult result);
+    void compileBranch(uint32_t opcode, uint32_t delay, uint32_t address, uint32_t count);
+    void compileExit(uint32_t count);
+
+    void emit8(uint8_t value);
+    void emit32(uint32_t value);
+    void emit64(uint64_t value);
+    void emitMem(uint8_t op, uint8_t reg, void *ptr);
+    void emitLoad(uint8_t reg, void *ptr);
+    void emitStore(void *ptr);
+    void emitStoreImm(void *ptr, uint32_t value);
+    void emitCmpImm(void *ptr, uint32_t value);
+    void emitCall(uintptr_t function, uint32_t arg);
+    void emitImm(uint8_t op, uint32_t value);
+    void emitReg(uint8_t op);
+    void emitShift(uint8_t ext, int amount);
+    void emitSet(uint8_t cond);
+    void emitVec(uint8_t op, uint8_t reg, uint8_t rm);
+    void emitVecMem(uint8_t op, uint8_t reg, void *ptr, uint8_t prefix = 0x66);
+    void emitVecDmem(uint8_t prefix, uint8_t op, uint8_t reg);
+    void emitVecShift(uint8_t ext, uint8_t reg, uint8_t amount);
+    void emitVecShuffle(uint8_t prefix, uint8_t reg, uint8_t order);
+    void emitElements(uint8_t reg, uint8_t e);
+}
+
+void RSP_JIT::reset() {
+    // Allocate executable memory for compiled code on first use
+    if (!codeBuffer) {
+#ifdef _WIN32
+        codeBuffer = (uint8_t*)VirtualAlloc(nullptr, CODE_SIZE, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
+#else
+        void *buffer = mmap(nullptr, CODE_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        codeBuffer = (buffer != MAP_FAILED) ? (uint8_t*)buffer : nullptr;
+#endif
+        if (!codeBuffer)
+            LOG_WARN("Failed to allocate RSP JIT memory; falling back to the interpreter\n");
+    }
+
+    // Start with an empty code buffer
+    clearBlocks();
+}
+
+uint32_t RSP_JIT::runBlock() {
+    // Fall back to the interpreter if there's nowhere to put compiled code
+    if (!codeBuffer)
+        return interpret();
+
+    // Switch to the blocks for the current IMEM contents if it was written
+    if (dirty)
+        findTable();
+
+    // Compile the block if it doesn't exist yet, and run it
+    uint32_t index = (RSP::programCounter & 0xFFC) >> 2;
+    if (!table->blocks[index]) {
+        // Start fresh if the code buffer is close to full
+        if (codePtr - codeBuffer > CODE_SIZE - 0x10000) {
+            clearBlocks();
+            findTable();
+        }
+        table->blocks[index] = compileBlock(index);
+    }
+    if (uint32_t count = (*table->blocks[index])())
+        return count;
+    return interpret();
+}
+
+void RSP_JIT::invalidate() {
+    // Look up blocks again on the next run, since IMEM might have a different microcode now
+    dirty = true;
+}
+
+uint32_t RSP_JIT::interpret() {
+    // Run a single opcode with the interpreter, in place of a block
+    RSP::runOpcode();
+    return 1;
+}
+
+void RSP_JIT::fetchNext() {
+    // Fetch the next opcode into the pipeline, as the interpreter would before executing
+    RSP::nextOpcode = Memory::read<uint32_t>(RSP::programCounter);
+}
+
+void RSP_JIT::clearBlocks() {
+    // Remove all blocks and reuse the code buffer from the start
+    for (auto &entry : tables)
+        delete entry.second;
+    tables.clear();
+    table = nullptr;
+    dirty = true;
+    codePtr = codeBuffer;
+}
+
+void RSP_JIT::findTable() {
+    // Copy IMEM and hash its contents with FNV-1a
+    uint32_t imem[0x400];
+    uint64_t hash = 0xCBF29CE484222325;
+    dirty = false;
+    for (int i = 0; i < 0x400; i++) {
+        imem[i] = Memory::read<uint32_t>(0xA4001000 + (i << 2));
+        hash = (hash ^ imem[i]) * 0x100000001B3;
+    }
+
+    // Reuse blocks compiled for the same microcode, so they survive being uploaded again by later tasks
+    auto entry = tables.find(hash);
+    if (entry != tables.end() && !memcmp(entry->second->imem, imem, sizeof(imem))) {
+        table = entry->second;
+        return;
+    }
+
+    // Make a new table for unseen microcode, replacing the old one on a hash collision
+    // Everything is thrown out if too many tables build up, so memory use stays bounded
+    if (entry == tables.end() && tables.size() >= MAX_TABLES) {
+        clearBlocks();
+        dirty = false;
+    }
+    CodeTable *&slot = tables[hash];
+    if (!slot) slot = new CodeTable();
+    table = slot;
+    memcpy(table->imem, imem, sizeof(imem));
+    memset(table->blocks, 0, sizeof(table->blocks));
+}
+
+Block RSP_JIT::compileBlock(uint32_t index) {
+    // Emit an epilogue for exits to jump back to
+    uint8_t *start = codePtr;
+    epilogue = codePtr;
+    emit32(0x20C48348); // add rsp,32
+    emit8(0x5B); // pop rbx
+    emit8(0xC3); // ret
+
+    // Emit a prologue that keeps the RSP register base in RBX, with shadow space for calls
+    Block block = (Block)codePtr;
+    emit8(0x53); // push rbx
+    emit32(0x20EC8348); // sub rsp,32
+    emit8(0x48); // mov rbx,registersR
+    emit8(0xBB);
+    emit64((uintptr_t)RSP::registersR);
+
+    // Exit without running anything if the pipeline holds a different opcode than IMEM
+    // This happens after the program counter is written, or after a branch in a delay slot
+    emitCmpImm(&RSP::nextOpcode, table->imem[index]);
+    emit8(0x74); // je over the exit
+    emit8(10);
+    compileExit(0);
+
+    // Compile opcodes until a branch, an opcode that needs syncing, or the end of IMEM
+    uint32_t count = 0;
+    uint32_t address = index << 2;
+    for (;; address += 4) {
+        uint32_t opcode = table->imem[address >> 2];
+
+        // Stop before COP0 opcodes and breaks, so the threaded RSP can hand them over on their own
+        if (isSync(opcode))
+            break;
+
+        if (isBranch(opcode)) {
+            // Stop before branches whose delay slot can't be compiled alongside them
+            if (address == 0xFFC) break;
+            uint32_t delay = table->imem[(address + 4) >> 2];
+            if (isBranch(delay) || isSync(delay))
+                break;
+
+            // Finish the block with the branch and its delay slot
+            compileBranch(opcode, delay, address, count);
+            return block;
+        }
+
+        // Emit an opcode inline if possible, or fall back to its interpreter handler
+        // Other opcodes don't depend on the program counter, and can't halt the RSP or write IMEM
+        compileOpcode(opcode);
+        count++;
+
+        // End the block at the size limit or the end of IMEM
+        if (count == BLOCK_SIZE || address == 0xFFC) {
+            address += 4;
+            break;
+        }
+    }
+
+    // Discard the block and use the interpreter if nothing could be compiled
+    if (!count) {
+        codePtr = start;
+        return interpret;
+    }
+
+    // Exit to the next opcode, fetching it into the pipeline
+    emitStoreImm(&RSP::programCounter, 0xA4001000 | (address & 0xFFC));
+    emitCall((uintptr_t)fetchNext, 0);
+    compileExit(count);
+    return block;
+}
+
+bool RSP_JIT::isBranch(uint32_t opcode) {
+    // Check if an opcode has a delay slot
+    switch (opcode >> 26) {
+        case 0x00: return (opcode & 0x3E) == 0x08; // JR, JALR
+        case 0x01: case 0x02: case 0x03: case 0x04:
+        case 0x05: case 0x06: case 0x07: return true;
+        default: return false;
+    }
+}
+
+bool RSP_JIT::isSync(uint32_t opcode) {
+    // Check if an opcode accesses state outside the RSP, matching RSP::needsSync
+    return (opcode >> 26) == 0x10 || (opcode & 0xFC00003F) == 0xD;
+}
+
+Instr RSP_JIT::getInstr(uint32_t opcode) {
+    // Look up the interpreter handler for an opcode, going straight to vector handlers
+    if ((opcode >> 25) == 0x25)
+        return RSP_CP2::vecInstrs[opcode & 0x3F];
+    switch (opcode >> 26) {
+        default: return RSP::immInstrs[opcode >> 26];
+        case 0: return RSP::regInstrs[opcode & 0x3F];
+        case 1: return RSP::extInstrs[(opcode >> 16) & 0x1F];
+    }
+}
+
+void RSP_JIT::compileOpcode(uint32_t opcode) {
+    // Emit an opcode inline, or call its interpreter handler
+    if (!compileAlu(opcode) && !compileVector(opcode) && !compileTransfer(opcode))
+        emitCall((uintptr_t)getInstr(opcode), opcode);
+}
+
+bool RSP_JIT::compileAlu(uint32_t opcode) {
+    // Get the operands of the opcode
+    uint32_t *rs = &RSP::registersR[(opcode >> 21) & 0x1F];
+    uint32_t *rt = &RSP::registersR[(opcode >> 16) & 0x1F];
+    uint32_t *rd = &RSP::registersR[(opcode >> 11) & 0x1F];
+    uint8_t sa = (opcode >> 6) & 0x1F;
+    uint8_t *start = codePtr;
+    uint32_t *dest;
+
+    // Emit simple opcodes, calculating the result in EAX
+    // Immediate-type opcodes are keyed by bits 26-31, and register-type by bits 0-5 plus 0x40
+    switch ((opcode >> 26) ? (opcode >> 26) : (0x40 | (opcode & 0x3F))) {
+        case 0x08: case 0x09: // ADDIU
+            emitLoad(0, rs);
+            emitImm(0x05, (int16_t)opcode);
+            dest = rt;
+            break;
+
+        case 0x0A: // SLTI
+            emitLoad(0, rs);
+            emitImm(0x3D, (int16_t)opcode);
+            emitSet(0x9C);
+            dest = rt;
+            break;
+
+        case 0x0B: // SLTIU
+            emitLoad(0, rs);
+            emitImm(0x3D, (int16_t)opcode);
+            emitSet(0x92);
+            dest = rt;
+            break;
+
+        case 0x0C: // ANDI
+            emitLoad(0, rs);
+            emitImm(0x25, opcode & 0xFFFF);
+            dest = rt;
+            break;
+
+        case 0x0D: // ORI
+            emitLoad(0, rs);
+            emitImm(0x0D, opcode & 0xFFFF);
+            dest = rt;
+            break;
+
+        case 0x0E: // XORI
+            emitLoad(0, rs);
+            emitImm(0x35, opcode & 0xFFFF);
+            dest = rt;
+            break;
+
+        case 0x0F: // LUI
+            emit8(0xB8); // mov eax,imm
+            emit32(opcode << 16);
+            dest = rt;
+            break;
+
+        case 0x40: // SLL
+            emitLoad(0, rt);
+            emitShift(4, sa);
+            dest = rd;
+            break;
+
+        case 0x42: // SRL
+            emitLoad(0, rt);
+            emitShift(5, sa);
+            dest = rd;
+            break;
+
+        case 0x43: // SRA
+            emitLoad(0, rt);
+            emitShift(7, sa);
+            dest = rd;
+            break;
+
+        case 0x44: // SLLV
+            emitLoad(1, rs);
+            emitLoad(0, rt);
+            emitShift(4, -1);
+            dest = rd;
+            break;
+
+        case 0x46: // SRLV
+            emitLoad(1, rs);
+            emitLoad(0, rt);
+            emitShift(5, -1);
+            dest = rd;
+            break;
+
+        case 0x47: // SRAV
+            emitLoad(1, rs);
+            emitLoad(0, rt);
+            emitShift(7, -1);
+            dest = rd;
+            break;
+
+        case 0x60: case 0x61: // ADDU
+            emitLoad(0, rs);
+            emitLoad(1, rt);
+            emitReg(0x01);
+            dest = rd;
+            break;
+
+        case 0x62: case 0x63: // SUBU
+            emitLoad(0, rs);
+            emitLoad(1, rt);
+            emitReg(0x29);
+            dest = rd;
+            break;
+
+        case 0x64: // AND
+            emitLoad(0, rs);
+            emitLoad(1, rt);
+            emitReg(0x21);
+            dest = rd;
+            break;
+
+        case 0x65: // OR
+            emitLoad(0, rs);
+            emitLoad(1, rt);
+            emitReg(0x09);
+            dest = rd;
+            break;
+
+        case 0x66: // XOR
+            emitLoad(0, rs);
+            emitLoad(1, rt);
+            emitReg(0x31);
+            dest = rd;
+            break;
+
+        case 0x67: // NOR
+            emitLoad(0, rs);
+            emitLoad(1, rt);
+            emitReg(0x09);
+            emit8(0xF7); // not eax
+            emit8(0xD0);
+            dest = rd;
+            break;
+
+        case 0x6A: // SLT
+            emitLoad(0, rs);
+            emitLoad(1, rt);
+            emitReg(0x39);
+            emitSet(0x9C);
+            dest = rd;
+            break;
+
+        case 0x6B: // SLTU
+            emitLoad(0, rs);
+            emitLoad(1, rt);
+            emitReg(0x39);
+            emitSet(0x92);
+            dest = rd;
+            break;
+
+        default:
+            return false;
+    }
+
+    // Store the result, or discard the opcode entirely if it writes to r0
+    if (dest == &RSP::registersR[0])
+        codePtr = start;
+    else
+        emitStore(dest);
+    return true;
+}
+
+bool RSP_JIT::compileVector(uint32_t opcode) {
+    // Only vector unit opcodes are handled here
+    if ((opcode >> 25) != 0x25)
+        return false;
+
+    // Get the operands of the opcode
+    uint16_t *vs = RSP_CP2::registers[(opcode >> 11) & 0x1F];
+    uint16_t *vt = RSP_CP2::registers[(opcode >> 16) & 0x1F];
+    uint16_t *vd = RSP_CP2::registers[(opcode >> 6) & 0x1F];
+    uint8_t e = (opcode >> 21) & 0xF;
+    VecResult result;
+
+    // Check that the opcode can be emitted, and decide how a multiply's result is taken from the accumulator
+    switch (opcode & 0x3F) {
+        case 0x00: case 0x07: case 0x08: case 0x0F: result = RES_SIGNED; break; // VMULF, VMUDH, VMACF, VMADH
+        case 0x01: case 0x09: result = RES_UNSIGNED; break; // VMULU, VMACU
+        case 0x04: result = RES_CLAMP_LOW; break; // VMUDL
+        case 0x05: case 0x0D: result = RES_MID; break; // VMUDM, VMADM
+        case 0x06: case 0x0C: case 0x0E: result = RES_LOW; break; // VMUDN, VMADL, VMADN
+        case 0x10: case 0x11: case 0x28: case 0x29: case 0x2A: // VADD, VSUB, VAND, VNAND, VOR
+        case 0x2B: case 0x2C: case 0x2D: result = RES_LOW; break; // VNOR, VXOR, VNXOR
+        default: return false;
+    }
+
+    // Load VS into XMM0 and VT into XMM1 with its lanes rearranged by the element modifier
+    // Only XMM0-5 are used, since the rest have to be preserved on Windows
+    emitVecMem(0x6F, 0, vs); // movdqa xmm0,vs
+    emitVecMem(0x6F, 1, vt); // movdqa xmm1,vt
+    emitElements(1, e);
+
+    switch (opcode & 0x3F) {
+        case 0x00: case 0x01: case 0x04: case 0x05: case 0x06: case 0x07: // VMULF, VMULU, VMUDx
+            // Calculate the product in XMM4:XMM2:XMM3, and replace the accumulator with it
+            compileProduct(opcode);
+            emitVecMem(0x7F, 3, RSP_CP2::accumulator[0]); // movdqa acc[0],xmm3
+            emitVecMem(0x7F, 2, RSP_CP2::accumulator[1]); // movdqa acc[1],xmm2
+            emitVecMem(0x7F, 4, RSP_CP2::accumulator[2]); // movdqa acc[2],xmm4
+            compileResult(result);
+            emitVecMem(0x7F, 0, vd); // movdqa vd,xmm0
+            return true;
+
+        case 0x08: case 0x09: case 0x0C: case 0x0D: case 0x0E: case 0x0F: // VMACF, VMACU, VMADx
+            // Calculate the product in XMM4:XMM2:XMM3, and add it to the accumulator
+            compileProduct(opcode);
+            compileAccumulate();
+            compileResult(result);
+            emitVecMem(0x7F, 0, vd); // movdqa vd,xmm0
+            return true;
+
+        case 0x10: case 0x11: // VADD, VSUB
+            // Expand the carry bits from VCO into a lane mask in XMM2, and clear them
+            emit8(0x0F); // movzx eax,word vco
+            emitMem(0xB7, 0, &RSP_CP2::vco);
+            emitVec(0x6E, 2, 0); // movd xmm2,eax
+            emitVecShuffle(0xF2, 2, 0x00); // pshuflw xmm2,xmm2,0x00
+            emitVecShuffle(0x66, 2, 0x00); // pshufd xmm2,xmm2,0x00
+            emitVecMem(0xDB, 2, (void*)carryLanes); // pand xmm2,carryLanes
+            emitVecMem(0x75, 2, (void*)carryLanes); // pcmpeqw xmm2,carryLanes
+            emit8(0x66); // mov word vco,0
+            emitMem(0xC7, 0, &RSP_CP2::vco);
+            emit8(0);
+            emit8(0);
+
+            if ((opcode & 0x3F) == 0x10) {
+                // Add with signed clamping, putting the result in XMM3 and the wrapped sum in XMM4
+                // The carry is added to the smaller operand so that only the last addition can saturate
+                emitVec(0x6F, 3, 0); // movdqa xmm3,xmm0
+                emitVec(0xEA, 3, 1); // pminsw xmm3,xmm1
+                emitVec(0xE9, 3, 2); // psubsw xmm3,xmm2
+                emitVec(0x6F, 4, 0); // movdqa xmm4,xmm0
+                emitVec(0xFD, 4, 1); // paddw xmm4,xmm1
+                emitVec(0xF9, 4, 2); // psubw xmm4,xmm2
+                emitVec(0x6F, 5, 0); // movdqa xmm5,xmm0
+                emitVec(0xEE, 5, 1); // pmaxsw xmm5,xmm1
+                emitVec(0xED, 3, 5); // paddsw xmm3,xmm5
+            }
+            else {
+                // Subtract with signed clamping, putting the result in XMM3 and the wrapped difference in XMM4
+                // If adding the carry saturates the second operand, the missing 1 is subtracted after
+                emitVec(0x6F, 4, 1); // movdqa xmm4,xmm1
+                emitVec(0xF9, 4, 2); // psubw xmm4,xmm2
+                emitVec(0xE9, 1, 2); // psubsw xmm1,xmm2
+                emitVec(0x6F, 3, 0); // movdqa xmm3,xmm0
+                emitVec(0xE9, 3, 1); // psubsw xmm3,xmm1
+                emitVec(0x65, 1, 4); // pcmpgtw xmm1,xmm4
+                emitVec(0xED, 3, 1); // paddsw xmm3,xmm1
+                emitVec(0xF9, 0, 4); // psubw xmm0,xmm4
+                emitVec(0x6F, 4, 0); // movdqa xmm4,xmm0
+            }
+
+            // Store the wrapped value in the low accumulator slice and the clamped value in VD
+            emitVec(0xEF, 5, 5); // pxor xmm5,xmm5
+            emitVecMem(0x7F, 4, RSP_CP2::accumulator[0]); // movdqa acc[0],xmm4
+            emitVecMem(0x7F, 5, RSP_CP2::accumulator[1]); // movdqa acc[1],xmm5
+            emitVecMem(0x7F, 5, RSP_CP2::accumulator[2]); // movdqa acc[2],xmm5
+            emitVecMem(0x7F, 3, vd); // movdqa vd,xmm3
+            return true;
+
+        default: // VAND, VNAND, VOR, VNOR, VXOR, VNXOR
+            // Apply the bitwise operation, negating the result for odd opcodes
+            static const uint8_t ops[] = { 0xDB, 0xEB, 0xEF }; // pand, por, pxor
+            emitVec(ops[((opcode & 0x3F) - 0x28) >> 1], 0, 1);
+            if (opcode & 0x1) {
+                emitVec(0x75, 1, 1); // pcmpeqw xmm1,xmm1
+                emitVec(0xEF, 0, 1); // pxor xmm0,xmm1
+            }
+
+            // Store the value in the low accumulator slice and in VD
+            emitVec(0xEF, 5, 5); // pxor xmm5,xmm5
+            emitVecMem(0x7F, 0, RSP_CP2::accumulator[0]); // movdqa acc[0],xmm0
+            emitVecMem(0x7F, 5, RSP_CP2::accumulator[1]); // movdqa acc[1],xmm5
+            emitVecMem(0x7F, 5, RSP_CP2::accumulator[2]); // movdqa acc[2],xmm5
+            emitVecMem(0x7F, 0, vd); // movdqa vd,xmm0
+            return true;
+    }
+}
+
+void RSP_JIT::compileProduct(uint32_t opcode) {
+    // Multiply XMM0 and XMM1 into 48-bit values split across XMM4 (high), XMM2 (mid), and XMM3 (low)
+    switch (opcode & 0x7) {
+        case 0x0: case 0x1: // VMULF, VMULU, VMACF, VMACU
+            // Multiply as signed values, shifting the products left by 1
+            emitVec(0x6F, 3, 0); // movdqa xmm3,xmm0
+            emitVec(0xD5, 3, 1); // pmullw xmm3,xmm1
+            emitVec(0x6F, 4, 0); // movdqa xmm4,xmm0
+            emitVec(0xE5, 4, 1); // pmulhw xmm4,xmm1
+            emitVec(0x6F, 2, 4); // movdqa xmm2,xmm4
+            emitVecShift(6, 2, 1); // psllw xmm2,1
+            emitVec(0x6F, 5, 3); // movdqa xmm5,xmm3
+            emitVecShift(2, 5, 15); // psrlw xmm5,15
+            emitVec(0xEB, 2, 5); // por xmm2,xmm5
+            emitVecShift(6, 3, 1); // psllw xmm3,1
+            emitVecShift(4, 4, 15); // psraw xmm4,15
+            if (opcode & 0x8)
+                return;
+
+            // Round the product for VMULF and VMULU, adding 0x8000 and carrying into the upper slices
+            emitVec(0x6F, 5, 3); // movdqa xmm5,xmm3
+            emitVecShift(4, 5, 15); // psraw xmm5,15
+            emitVec(0x75, 0, 0); // pcmpeqw xmm0,xmm0
+            emitVecShift(6, 0, 15); // psllw xmm0,15
+            emitVec(0xEF, 3, 0); // pxor xmm3,xmm0
+            emitVec(0x75, 0, 0); // pcmpeqw xmm0,xmm0
+            emitVec(0x75, 0, 2); // pcmpeqw xmm0,xmm2
+            emitVec(0xDB, 0, 5); // pand xmm0,xmm5
+            emitVec(0xF9, 2, 5); // psubw xmm2,xmm5
+            emitVec(0xF9, 4, 0); // psubw xmm4,xmm0
+            return;
+
+        case 0x4: // VMUDL, VMADL
+            // Keep the upper half of an unsigned product in the low slice
+            emitVec(0x6F, 3, 0); // movdqa xmm3,xmm0
+            emitVec(0xE4, 3, 1); // pmulhuw xmm3,xmm1
+            emitVec(0xEF, 2, 2); // pxor xmm2,xmm2
+            emitVec(0xEF, 4, 4); // pxor xmm4,xmm4
+            return;
+
+        case 0x5: case 0x6: { // VMUDM, VMUDN, VMADM, VMADN
+            // Multiply a signed by an unsigned value, correcting an unsigned multiply for the sign
+            uint8_t s = (opcode & 0x1) ? 0 : 1, u = s ^ 1;
+            emitVec(0x6F, 2, s); // movdqa xmm2,s
+            emitVec(0xE4, 2, u); // pmulhuw xmm2,u
+            emitVec(0x6F, 5, s); // movdqa xmm5,s
+            emitVecShift(4, 5, 15); // psraw xmm5,15
+            emitVec(0xDB, 5, u); // pand xmm5,u
+            emitVec(0xF9, 2, 5); // psubw xmm2,xmm5
+            emitVec(0x6F, 3, 0); // movdqa xmm3,xmm0
+            emitVec(0xD5, 3, 1); // pmullw xmm3,xmm1
+            emitVec(0x6F, 4, 2); // movdqa xmm4,xmm2
+            emitVecShift(4, 4, 15); // psraw xmm4,15
+            return;
+        }
+
+        default: // VMUDH, VMADH
+            // Keep a signed product in the upper slices
+            emitVec(0x6F, 4, 0); // movdqa xmm4,xmm0
+            emitVec(0xE5, 4, 1); // pmulhw xmm4,xmm1
+            emitVec(0x6F, 2, 0); // movdqa xmm2,xmm0
+            emitVec(0xD5, 2, 1); // pmullw xmm2,xmm1
+            emitVec(0xEF, 3, 3); // pxor xmm3,xmm3
+            return;
+    }
+}
+
+void RSP_JIT::compileAccumulate() {
+    // Add the low slices, keeping a mask of lanes that carried out in XMM3
+    emitVecMem(0x6F, 0, RSP_CP2::accumulator[0]); // movdqa xmm0,acc[0]
+    emitVec(0x6F, 1, 0); // movdqa xmm1,xmm0
+    emitVec(0xFD, 1, 3); // paddw xmm1,xmm3
+    emitVec(0x6F, 5, 0); // movdqa xmm5,xmm0
+    emitVec(0xDB, 5, 3); // pand xmm5,xmm3
+    emitVec(0xEB, 0, 3); // por xmm0,xmm3
+    emitVec(0x6F, 3, 1); // movdqa xmm3,xmm1
+    emitVec(0xDF, 3, 0); // pandn xmm3,xmm0
+    emitVec(0xEB, 3, 5); // por xmm3,xmm5
+    emitVecShift(4, 3, 15); // psraw xmm3,15
+    emitVecMem(0x7F, 1, RSP_CP2::accumulator[0]); // movdqa acc[0],xmm1
+
+    // Add the middle slices, keeping a mask of lanes that carried out in XMM2
+    // A carry from the low slice also carries out if the middle sum is 0xFFFF
+    emitVecMem(0x6F, 0, RSP_CP2::accumulator[1]); // movdqa xmm0,acc[1]
+    emitVec(0x6F, 1, 0); // movdqa xmm1,xmm0
+    emitVec(0xFD, 1, 2); // paddw xmm1,xmm2
+    emitVec(0x6F, 5, 0); // movdqa xmm5,xmm0
+    emitVec(0xDB, 5, 2); // pand xmm5,xmm2
+    emitVec(0xEB, 0, 2); // por xmm0,xmm2
+    emitVec(0x6F, 2, 1); // movdqa xmm2,xmm1
+    emitVec(0xDF, 2, 0); // pandn xmm2,xmm0
+    emitVec(0xEB, 2, 5); // por xmm2,xmm5
+    emitVecShift(4, 2, 15); // psraw xmm2,15
+    emitVec(0x75, 5, 5); // pcmpeqw xmm5,xmm5
+    emitVec(0x75, 5, 1); // pcmpeqw xmm5,xmm1
+    emitVec(0xDB, 5, 3); // pand xmm5,xmm3
+    emitVec(0xEB, 2, 5); // por xmm2,xmm5
+    emitVec(0xF9, 1, 3); // psubw xmm1,xmm3
+    emitVecMem(0x7F, 1, RSP_CP2::accumulator[1]); // movdqa acc[1],xmm1
+
+    // Add the high slices with the carry from the middle
+    emitVecMem(0x6F, 0, RSP_CP2::accumulator[2]); // movdqa xmm0,acc[2]
+    emitVec(0xFD, 0, 4); // paddw xmm0,xmm4
+    emitVec(0xF9, 0, 2); // psubw xmm0,xmm2
+    emitVecMem(0x7F, 0, RSP_CP2::accumulator[2]); // movdqa acc[2],xmm0
+}
+
+void RSP_JIT::compileResult(VecResult result) {
+    // Get the value for VD from the accumulator in XMM0
+    switch (result) {
+        case RES_LOW:
+            emitVecMem(0x6F, 0, RSP_CP2::accumulator[0]); // movdqa xmm0,acc[0]
+            return;
+
+        case RES_MID:
+            emitVecMem(0x6F, 0, RSP_CP2::accumulator[1]); // movdqa xmm0,acc[1]
+            return;
+
+        case RES_CLAMP_LOW:
+            // Clamp the low slice to 0x7FFF if its top bit is set
+            emitVecMem(0x6F, 0, RSP_CP2::accumulator[0]); // movdqa xmm0,acc[0]
+            emitVec(0x6F, 1, 0); // movdqa xmm1,xmm0
+            emitVecShift(4, 1, 15); // psraw xmm1,15
+            emitVec(0xDF, 1, 0); // pandn xmm1,xmm0
+            emitVecShift(4, 0, 15); // psraw xmm0,15
+            emitVecShift(2, 0, 1); // psrlw xmm0,1
+            emitVec(0xEB, 0, 1); // por xmm0,xmm1
+            return;
+
+        case RES_SIGNED:
+            // Clamp the upper 32 bits to the signed 16-bit range by packing them with saturation
+            emitVecMem(0x6F, 1, RSP_CP2::accumulator[1]); // movdqa xmm1,acc[1]
+            emitVecMem(0x6F, 2, RSP_CP2::accumulator[2]); // movdqa xmm2,acc[2]
+            emitVec(0x6F, 0, 1); // movdqa xmm0,xmm1
+            emitVec(0x61, 0, 2); // punpcklwd xmm0,xmm2
+            emitVec(0x69, 1, 2); // punpckhwd xmm1,xmm2
+            emitVec(0x6B, 0, 1); // packssdw xmm0,xmm1
+            return;
+
+        case RES_UNSIGNED:
+            // Clamp the upper 32 bits to the unsigned 16-bit range (bugged)
+            emitVecMem(0x6F, 1, RSP_CP2::accumulator[1]); // movdqa xmm1,acc[1]
+            emitVecMem(0x6F, 0, RSP_CP2::accumulator[2]); // movdqa xmm0,acc[2]
+            emitVec(0xEF, 3, 3); // pxor xmm3,xmm3
+            emitVec(0x6F, 2, 0); // movdqa xmm2,xmm0
+            emitVec(0x65, 2, 3); // pcmpgtw xmm2,xmm3
+            emitVec(0x6F, 4, 1); // movdqa xmm4,xmm1
+            emitVecShift(4, 4, 15); // psraw xmm4,15
+            emitVec(0xEB, 2, 4); // por xmm2,xmm4
+            emitVec(0xEB, 2, 1); // por xmm2,xmm1
+            emitVecShift(4, 0, 15); // psraw xmm0,15
+            emitVec(0xDF, 0, 2); // pandn xmm0,xmm2
+            return;
+    }
+}
+
+bool RSP_JIT::compileTransfer(uint32_t opcode) {
+    // Only LWC2 and SWC2 opcodes are handled here
+    bool load = (opcode >> 26) == 0x32;
+    if (!load && (opcode >> 26) != 0x3A)
+        return false;
+
+    // Handle LQV/SQV from the first byte, and LDV/SDV from an even byte that keeps all 8 in the register
+    uint8_t byte = (opcode >> 7) & 0xF;
+    uint32_t size;
+    switch ((opcode >> 11) & 0x1F) {
+        case 0x03: if ((byte & 0x1) || byte > 8) return false; size = 8; break;
+        case 0x04: if (byte) return false; size = 16; break;
+        default: return false;
+    }
+
+    // Calculate the address in EAX, and fall back to the interpreter if it isn't aligned to the size
+    // Misaligned quads are partial and misaligned doubles can wrap, so they aren't worth emitting
+    uint8_t *reg = (uint8_t*)RSP_CP2::registers[(opcode >> 16) & 0x1F] + byte;
+    emitLoad(0, &RSP::registersR[(opcode >> 21) & 0x1F]);
+    emitImm(0x05, (int8_t)(opcode << 1) * (int32_t)(size >> 1));
+    emit8(0xA8); // test al,size-1
+    emit8(size - 1);
+    emit8(0x75); // jnz slow
+    emit8(0);
+    uint8_t *slow = codePtr;
+    emitImm(0x25, 0xFFF); // and eax,0xFFF
+
+    // Transfer between DMEM and the register, swapping the halfwords within each host-endian word
+    if (load) {
+        emitVecDmem(0xF3, (size == 16) ? 0x6F : 0x7E, 0); // movdqu/movq xmm0,dmem
+        emitVecShuffle(0xF2, 0, 0xB1); // pshuflw xmm0,xmm0,0xB1
+        if (size == 16) {
+            emitVecShuffle(0xF3, 0, 0xB1); // pshufhw xmm0,xmm0,0xB1
+            emitVecMem(0x7F, 0, reg); // movdqa reg,xmm0
+        }
+        else
+            emitVecMem(0xD6, 0, reg); // movq reg,xmm0
+    }
+    else {
+        if (size == 16)
+            emitVecMem(0x6F, 0, reg); // movdqa xmm0,reg
+        else
+            emitVecMem(0x7E, 0, reg, 0xF3); // movq xmm0,reg
+        emitVecShuffle(0xF2, 0, 0xB1); // pshuflw xmm0,xmm0,0xB1
+        if (size == 16) {
+            emitVecShuffle(0xF3, 0, 0xB1); // pshufhw xmm0,xmm0,0xB1
+            emitVecDmem(0xF3, 0x7F, 0); // movdqu dmem,xmm0
+        }
+        else
+            emitVecDmem(0x66, 0xD6, 0); // movq dmem,xmm0
+    }
+
+    // Skip over the interpreter call, which handles addresses that weren't aligned
+    emit8(0xEB); // jmp done
+    emit8(0);
+    uint8_t *done = codePtr;
+    slow[-1] = codePtr - slow;
+    emitCall((uintptr_t)getInstr(opcode), opcode);
+    done[-1] = codePtr - done;
+    return true;
+}
+
+void RSP_JIT::compileBranch(uint32_t opcode, uint32_t delay, uint32_t address, uint32_t count) {
+    // Call the branch handler with the program counter set as it would be in the pipeline
+    emitStoreImm(&RSP::programCounter, 0xA4001000 | (address + 4));
+    emitCall((uintptr_t)getInstr(opcode), opcode);
+
+    // Move to the delay slot, wrapping the target within IMEM, and fetch the opcode after it
+    emitLoad(0, &RSP::programCounter);
+    emitImm(0x05, 4); // add eax,4
+    emitImm(0x25, 0xFFC); // and eax,0xFFC
+    emitImm(0x0D, 0xA4001000); // or eax,0xA4001000
+    emitStore(&RSP::programCounter);
+    emitCall((uintptr_t)fetchNext, 0);
+
+    // Run the delay slot opcode and exit the block
+    compileOpcode(delay);
+    compileExit(count + 2);
+}
+
+void RSP_JIT::compileExit(uint32_t count) {
+    // Return the number of opcodes run through the epilogue (always 10 bytes)
+    emit8(0xB8); // mov eax,count
+    emit32(count);
+    emit8(0xE9); // jmp epilogue
+    emit32(epilogue - (codePtr + 4));
+}
+
+void RSP_JIT::emit8(uint8_t value) {
+    // Write a byte to the code buffer
+    *codePtr++ = value;
+}
+
+void RSP_JIT::emit32(uint32_t value) {
+    // Write a little-endian word to the code buffer
+    memcpy(codePtr, &value, sizeof(value));
+    codePtr += sizeof(value);
+}
+
+void RSP_JIT::emit64(uint64_t value) {
+    // Write a little-endian double word to the code buffer
+    memcpy(codePtr, &value, sizeof(value));
+    codePtr += sizeof(value);
+}
+
+void RSP_JIT::emitMem(uint8_t op, uint8_t reg, void *ptr) {
+    // Emit an opcode that addresses RSP state relative to the register base in RBX
+    emit8(op);
+    emit8(0x83 | (reg << 3));
+    emit32((uint8_t*)ptr - (uint8_t*)RSP::registersR);
+}
+
+void RSP_JIT::emitLoad(uint8_t reg, void *ptr) {
+    // Load a 32-bit value into EAX (0) or ECX (1)
+    emitMem(0x8B, reg, ptr);
+}
+
+void RSP_JIT::emitStore(void *ptr) {
+    // Store a 32-bit value from EAX
+    emitMem(0x89, 0, ptr);
+}
+
+void RSP_JIT::emitStoreImm(void *ptr, uint32_t value) {
+    // Store a 32-bit immediate
+    emitMem(0xC7, 0, ptr);
+    emit32(value);
+}
+
+void RSP_JIT::emitCmpImm(void *ptr, uint32_t value) {
+    // Compare a 32-bit value with an immediate
+    emitMem(0x81, 7, ptr);
+    emit32(value);
+}
+
+void RSP_JIT::emitCall(uintptr_t function, uint32_t arg) {
+    // Pass an argument in the first parameter register for the host ABI
+#ifdef _WIN32
+    emit8(0xB9); // mov ecx,arg
+#else
+    emit8(0xBF); // mov edi,arg
+#endif
+    emit32(arg);
+
+    // Call a function through RAX
+    emit8(0x48); // mov rax,function
+    emit8(0xB8);
+    emit64(function);
+    emit8(0xFF); // call rax
+    emit8(0xD0);
+}
+
+void RSP_JIT::emitImm(uint8_t op, uint32_t value) {
+    // Emit a 32-bit ALU opcode on EAX with a 32-bit immediate
+    emit8(op);
+    emit32(value);
+}
+
+void RSP_JIT::emitReg(uint8_t op) {
+    // Emit a 32-bit ALU opcode on EAX with ECX
+    emit8(op);
+    emit8(0xC8);
+}
+
+void RSP_JIT::emitShift(uint8_t ext, int amount) {
+    // Emit a 32-bit shift on EAX, by an immediate or by CL if negative
+    emit8((amount < 0) ? 0xD3 : 0xC1);
+    emit8(0xC0 | (ext << 3));
+    if (amount >= 0) emit8(amount);
+}
+
+void RSP_JIT::emitSet(uint8_t cond) {
+    // Set EAX to 1 or 0 based on a condition from the last comparison
+    emit8(0x0F); // setcc al
+    emit8(cond);
+    emit8(0xC0);
+    emit8(0x0F); // movzx eax,al
+    emit8(0xB6);
+    emit8(0xC0);
+}
+
+void RSP_JIT::emitVec(uint8_t op, uint8_t reg, uint8_t rm) {
+    // Emit an SSE2 integer opcode between two XMM registers, or with a general register as the source
+    emit8(0x66);
+    emit8(0x0F);
+    emit8(op);
+    emit8(0xC0 | (reg << 3) | rm);
+}
+
+void RSP_JIT::emitVecMem(uint8_t op, uint8_t reg, void *ptr, uint8_t prefix) {
+    // Emit an SSE2 opcode that addresses RSP state relative to the register base in RBX
+    emit8(prefix);
+    emit8(0x0F);
+    emitMem(op, reg, ptr);
+}
+
+void RSP_JIT::emitVecDmem(uint8_t prefix, uint8_t op, uint8_t reg) {
+    // Emit an SSE2 opcode that addresses DMEM at the offset in EAX
+    emit8(prefix);
+    emit8(0x0F);
+    emit8(op);
+    emit8(0x84 | (reg << 3));
+    emit8(0x03); // [rbx+rax]
+    emit32(Memory::rspMem - (uint8_t*)RSP::registersR);
+}
+
+void RSP_JIT::emitVecShift(uint8_t ext, uint8_t reg, uint8_t amount) {
+    // Emit a 16-bit lane shift on an XMM register by an immediate
+    emit8(0x66);
+    emit8(0x0F);
+    emit8(0x71);
+    emit8(0xC0 | (ext << 3) | reg);
+    emit8(amount);
+}
+
+void RSP_JIT::emitVecShuffle(uint8_t prefix, uint8_t reg, uint8_t order) {
+    // Emit a lane shuffle on an XMM register, with the prefix selecting words (F2 low, F3 high) or dwords (66)
+    emit8(prefix);
+    emit8(0x0F);
+    emit8(0x70);
+    emit8(0xC0 | (reg << 3) | reg);
+    emit8(order);
+}
+
+void RSP_JIT::emitElements(uint8_t reg, uint8_t e) {
+    // Rearrange the lanes of an XMM register for an element modifier, matching RSP_CP2::elements
+    if (e < 2) {
+        return;
+    }
+    else if (e < 4) {
+        // Repeat even or odd lanes in pairs
+        uint8_t order = (e == 2) ? 0xA0 : 0xF5;
+        emitVecShuffle(0xF2, reg, order);
+        emitVecShuffle(0xF3, reg, order);
+    }
+    else if (e < 8) {
+        // Repeat one lane across each half
+        emitVecShuffle(0xF2, reg, (e - 4) * 0x55);
+        emitVecShuffle(0xF3, reg, (e - 4) * 0x55);
+    }
+    else {
+        // Repeat one lane across its half, then that half's dword across the register
+        emitVecShuffle((e < 12) ? 0xF2 : 0xF3, reg, (e & 0x3) * 0x55);
+        emitVecShuffle(0x66, reg, (e < 12) ? 0x00 : 0xFF);
+    }
+}
+
+#else
+
+void RSP_JIT::reset() {
+    // The JIT is only available on x86-64 hosts
+}
+
+uint32_t RSP_JIT::runBlock() {
+    // Fall back to the interpreter on hosts without JIT support
+    RSP::runOpcode();
+    return 1;
+}
+
+void RSP_JIT::invalidate() {
+    // There are no compiled blocks to invalidate
+}
+
+#endif
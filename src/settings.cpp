@@ -33,14 +33,32 @@ namespace Settings {
     std::string filename;
     int fpsLimiter = 1;
     int expansionPak = 1;
+    int cachedInterp = 0;
+    int cpuJit = 0;
+    int rspJit = 0;
+    int gfxHle = 0;
+    int audioHle = 0;
+    int syncQuantum = 0;
+    int threadedRsp = 0;
     int threadedRdp = 0;
+    int parallelRdp = 0;
     int texFilter = 1;
+    int audioResampler = 1;
 
     std::vector<Setting> settings = {
         Setting("fpsLimiter", &fpsLimiter, false),
         Setting("expansionPak", &expansionPak, false),
+        Setting("cachedInterp", &cachedInterp, false),
+        Setting("cpuJit", &cpuJit, false),
+        Setting("rspJit", &rspJit, false),
+        Setting("gfxHle", &gfxHle, false),
+        Setting("audioHle", &audioHle, false),
+        Setting("syncQuantum", &syncQuantum, false),
+        Setting("threadedRsp", &threadedRsp, false),
         Setting("threadedRdp", &threadedRdp, false),
-        Setting("texFilter", &texFilter, false)
+        Setting("parallelRdp", &parallelRdp, false),
+        Setting("texFilter", &texFilter, false),
+        Setting("audioResampler", &audioResampler, false)
     };
 }
 
@@ -28,6 +28,15 @@ namespace Settings {
 
     extern int fpsLimiter;
     extern int expansionPak;
+    extern int cachedInterp;
+    extern int cpuJit;
+    extern int rspJit;
+    extern int gfxHle;
+    extern int audioHle;
+    extern int syncQuantum;
+    extern int threadedRsp;
     extern int threadedRdp;
+    extern int parallelRdp;
     extern int texFilter;
+    extern int audioResampler;
 }
@@ -80,10 +80,15 @@ void SI::performReadDma(uint32_t address) {
     // TODO: properly look into how PIF command triggers work
     PIF::runCommand();
 
-    // Copy 64 bytes from PIF RAM to RDRAM
-    for (uint32_t i = 0; i < 0x40; i++) {
+    // Copy 64 bytes from PIF RAM to RDRAM, in bulk where possible and byte by byte otherwise
+    for (uint32_t i = 0; i < 0x40;) {
+        if (uint32_t count = Memory::copyDma(0x80000000 + dramAddr + i, 0x9FC00000 + address + i, 0x40 - i)) {
+            i += count;
+            continue;
+        }
         uint8_t value = Memory::read<uint8_t>(0x9FC00000 + address + i);
         Memory::write<uint8_t>(0x80000000 + dramAddr + i, value);
+        i++;
     }
 
     // Request an SI interrupt when the DMA finishes
@@ -94,10 +99,15 @@ void SI::performReadDma(uint32_t address) {
 void SI::performWriteDma(uint32_t address) {
     LOG_INFO("SI DMA from RDRAM 0x%X to PIF 0x%X with size 0x40\n", dramAddr, address);
 
-    // Copy 64 bytes from RDRAM to PIF RAM
-    for (uint32_t i = 0; i < 0x40; i++) {
+    // Copy 64 bytes from RDRAM to PIF RAM, in bulk where possible and byte by byte otherwise
+    for (uint32_t i = 0; i < 0x40;) {
+        if (uint32_t count = Memory::copyDma(0x9FC00000 + address + i, 0x80000000 + dramAddr + i, 0x40 - i)) {
+            i += count;
+            continue;
+        }
         uint8_t value = Memory::read<uint8_t>(0x80000000 + dramAddr + i);
         Memory::write<uint8_t>(0x9FC00000 + address + i, value);
+        i++;
     }
 
     // Request an SI interrupt when the DMA finishes
@@ -87,6 +87,8 @@ void stopCore() {
 
 void settingsMenu() {
     const std::vector<std::string> toggle = { "Off", "On" };
+    const std::vector<std::string> sync = { "Exact", "Short Batches", "Long Batches" };
+    const std::vector<std::string> resampler = { "Nearest", "Linear", "Cubic", "Sinc" };
     size_t index = 0;
 
     while (true) {
@@ -94,8 +96,15 @@ void settingsMenu() {
         std::vector<ListItem> settings = {
             ListItem("FPS Limiter", toggle[Settings::fpsLimiter]),
             ListItem("Expansion Pak", toggle[Settings::expansionPak]),
+            ListItem("Cached Interpreter", toggle[Settings::cachedInterp]),
+            ListItem("Graphics HLE", toggle[Settings::gfxHle]),
+            ListItem("Audio HLE", toggle[Settings::audioHle]),
+            ListItem("CPU/RSP Sync", sync[(Settings::syncQuantum >= 1536) ? 2 : (Settings::syncQuantum ? 1 : 0)]),
+            ListItem("Threaded RSP", toggle[Settings::threadedRsp]),
             ListItem("Threaded RDP", toggle[Settings::threadedRdp]),
-            ListItem("Texture Filter", toggle[Settings::texFilter])
+            ListItem("Parallel RDP", toggle[Settings::parallelRdp]),
+            ListItem("Texture Filter", toggle[Settings::texFilter]),
+            ListItem("Audio Resampler", resampler[(Settings::audioResampler & ~0x3) ? 1 : Settings::audioResampler])
         };
 
         // Create the settings menu
@@ -108,8 +117,15 @@ void settingsMenu() {
             switch (index) {
                 case 0: Settings::fpsLimiter = !Settings::fpsLimiter; break;
                 case 1: Settings::expansionPak = !Settings::expansionPak; break;
-                case 2: Settings::threadedRdp = !Settings::threadedRdp; break;
-                case 3: Settings::texFilter = !Settings::texFilter; break;
+                case 2: Settings::cachedInterp = !Settings::cachedInterp; break;
+                case 3: Settings::gfxHle = !Settings::gfxHle; break;
+                case 4: Settings::audioHle = !Settings::audioHle; break;
+                case 5: Settings::syncQuantum = (Settings::syncQuantum >= 1536) ? 0 : (Settings::syncQuantum ? 1536 : 192); break;
+                case 6: Settings::threadedRsp = !Settings::threadedRsp; break;
+                case 7: Settings::threadedRdp = !Settings::threadedRdp; break;
+                case 8: Settings::parallelRdp = !Settings::parallelRdp; break;
+                case 9: Settings::texFilter = !Settings::texFilter; break;
+                case 10: Settings::audioResampler = (Settings::audioResampler + 1) & 0x3; break;
             }
         }
         else {
@@ -327,6 +343,7 @@ int main() {
 
     // Open the file browser
     fileBrowser();
+    _Framebuffer *frame = nullptr;
 
     while (appletMainLoop() && Core::running) {
         // Maintain the CPU overclock if it was reset from ex. leaving the app
@@ -352,13 +369,16 @@ int main() {
         // Send joystick input to the core
         PIF::setStick(stick.x >> 8, stick.y >> 8);
 
-        // Draw a new frame if one is ready
-        if (_Framebuffer *fb = VI::getFramebuffer()) {
+        // Draw a new frame if one is ready, or the previous one again, presenting once per refresh
+        // The previous frame stays valid until a new one is received
+        _Framebuffer *fb = VI::getFramebuffer();
+        if (fb || frame) VI::frameShown(fb != nullptr);
+        if (fb) frame = fb;
+        if (frame) {
             SwitchUI::clear(Color(0, 0, 0));
-            SwitchUI::drawImage(fb->data, fb->width, fb->height, 160, 0, 960, 720, true, 0);
+            SwitchUI::drawImage(frame->data, frame->width, frame->height, 160, 0, 960, 720, true, 0);
             if (showFps) SwitchUI::drawString(std::to_string(Core::fps) + " FPS", 5, 0, 48, Color(255, 255, 255));
             SwitchUI::update();
-            delete fb;
         }
 
         // Toggle showing FPS or open the pause menu if hotkeys are pressed
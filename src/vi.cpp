@@ -20,8 +20,12 @@
 #include <atomic>
 #include <cstddef>
 #include <cstring>
-#include <queue>
-#include <mutex>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
 
 #include "vi.h"
 #include "core.h"
@@ -31,9 +35,14 @@
 #include "rdp.h"
 
 namespace VI {
-    std::queue<_Framebuffer*> framebuffers;
-    std::atomic<bool> ready;
-    std::mutex mutex;
+    // Triple-buffered frames, where the mailbox holds the newest completed slot and bit 2 marks it unread
+    _Framebuffer framebuffers[3];
+    std::atomic<uint8_t> mailbox(1);
+    uint8_t backSlot = 0;
+    uint8_t frontSlot = 2;
+
+    std::atomic<uint32_t> droppedFrames;
+    std::atomic<uint32_t> repeatedFrames;
 
     uint32_t control;
     uint32_t origin;
@@ -43,21 +52,112 @@ namespace VI {
     uint32_t xScale;
     uint32_t yScale;
 
+    inline uint32_t pixel16(uint16_t color) {
+        // Translate an RGBA5551 pixel to RGBA8888, expanding channels by replicating their top bits
+        uint8_t r = ((color >> 11) & 0x1F) * 0x21 >> 2;
+        uint8_t g = ((color >>  6) & 0x1F) * 0x21 >> 2;
+        uint8_t b = ((color >>  1) & 0x1F) * 0x21 >> 2;
+        return (0xFF << 24) | (b << 16) | (g << 8) | r;
+    }
+
+    inline uint32_t pixel32(uint32_t color) {
+        // Translate an RGBA8888 pixel value to byte order with full alpha
+        uint8_t r = (color >> 24) & 0xFF;
+        uint8_t g = (color >> 16) & 0xFF;
+        uint8_t b = (color >>  8) & 0xFF;
+        return (0xFF << 24) | (b << 16) | (g << 8) | r;
+    }
+
+#if defined(__SSE2__)
+    inline __m128i expand5(__m128i c) {
+        // Expand 5-bit channels in 16-bit lanes to 8 bits by replicating their top bits
+        return _mm_or_si128(_mm_slli_epi16(c, 3), _mm_srli_epi16(c, 2));
+    }
+
+    inline void convert16(uint32_t *dst, const uint8_t *src) {
+        // Translate 8 RGBA5551 pixels from host-endian words to RGBA8888 with full alpha
+        __m128i c = _mm_loadu_si128((const __m128i*)src), mask = _mm_set1_epi16(0x1F);
+        c = _mm_shufflehi_epi16(_mm_shufflelo_epi16(c, 0xB1), 0xB1);
+        __m128i r = expand5(_mm_and_si128(_mm_srli_epi16(c, 11), mask));
+        __m128i g = expand5(_mm_and_si128(_mm_srli_epi16(c, 6), mask));
+        __m128i b = expand5(_mm_and_si128(_mm_srli_epi16(c, 1), mask));
+        __m128i rg = _mm_or_si128(r, _mm_slli_epi16(g, 8));
+        __m128i ba = _mm_or_si128(b, _mm_set1_epi16(0xFF00));
+        _mm_storeu_si128((__m128i*)&dst[0], _mm_unpacklo_epi16(rg, ba));
+        _mm_storeu_si128((__m128i*)&dst[4], _mm_unpackhi_epi16(rg, ba));
+    }
+
+    inline void convert32(uint32_t *dst, const uint8_t *src) {
+        // Translate 4 RGBA8888 pixels from host-endian words to byte order with full alpha
+        __m128i c = _mm_loadu_si128((const __m128i*)src);
+        c = _mm_shufflehi_epi16(_mm_shufflelo_epi16(c, 0xB1), 0xB1);
+        c = _mm_or_si128(_mm_slli_epi16(c, 8), _mm_srli_epi16(c, 8));
+        _mm_storeu_si128((__m128i*)dst, _mm_or_si128(c, _mm_set1_epi32(0xFF000000)));
+    }
+#elif defined(__aarch64__)
+    inline uint16x8_t expand5(uint16x8_t c) {
+        // Expand 5-bit channels in 16-bit lanes to 8 bits by replicating their top bits
+        return vorrq_u16(vshlq_n_u16(c, 3), vshrq_n_u16(c, 2));
+    }
+
+    inline void convert16(uint32_t *dst, const uint8_t *src) {
+        // Translate 8 RGBA5551 pixels from host-endian words to RGBA8888 with full alpha
+        uint16x8_t c = vrev32q_u16(vld1q_u16((const uint16_t*)src)), mask = vdupq_n_u16(0x1F);
+        uint16x8_t r = expand5(vandq_u16(vshrq_n_u16(c, 11), mask));
+        uint16x8_t g = expand5(vandq_u16(vshrq_n_u16(c, 6), mask));
+        uint16x8_t b = expand5(vandq_u16(vshrq_n_u16(c, 1), mask));
+        uint16x8x2_t p = vzipq_u16(vorrq_u16(r, vshlq_n_u16(g, 8)), vorrq_u16(b, vdupq_n_u16(0xFF00)));
+        vst1q_u32(&dst[0], vreinterpretq_u32_u16(p.val[0]));
+        vst1q_u32(&dst[4], vreinterpretq_u32_u16(p.val[1]));
+    }
+
+    inline void convert32(uint32_t *dst, const uint8_t *src) {
+        // Translate 4 RGBA8888 pixels from host-endian words to byte order with full alpha
+        uint32x4_t c = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(src)));
+        vst1q_u32(dst, vorrq_u32(c, vdupq_n_u32(0xFF000000)));
+    }
+#else
+    inline void convert16(uint32_t *dst, const uint8_t *src) {
+        // Translate 8 RGBA5551 pixels from host-endian words to RGBA8888 with full alpha
+        for (int i = 0; i < 8; i++)
+            dst[i] = pixel16(((const uint16_t*)src)[i ^ 1]);
+    }
+
+    inline void convert32(uint32_t *dst, const uint8_t *src) {
+        // Translate 4 RGBA8888 pixels from host-endian words to byte order with full alpha
+        for (int i = 0; i < 4; i++)
+            dst[i] = pixel32(((const uint32_t*)src)[i]);
+    }
+#endif
+
+    void convertRow(uint32_t *dst, const uint8_t *src, uint32_t offset, uint32_t count, bool rgba16);
     void drawFrame();
 }
 
 _Framebuffer *VI::getFramebuffer() {
-    // Wait until a new frame is ready
-    if (!ready.load())
+    // Show nothing new if a frame hasn't been completed since the last one
+    if (!(mailbox.load(std::memory_order_relaxed) & 0x4))
         return nullptr;
 
-    // Get the next frame in the queue
-    mutex.lock();
-    _Framebuffer *fb = framebuffers.front();
-    framebuffers.pop();
-    ready.store(!framebuffers.empty());
-    mutex.unlock();
-    return fb;
+    // Swap the front slot with the newest frame, which stays valid until the next call
+    frontSlot = mailbox.exchange(frontSlot, std::memory_order_acq_rel) & 0x3;
+    return &framebuffers[frontSlot];
+}
+
+void VI::frameShown(bool newFrame) {
+    // Count a repeated frame if the presenter showed the previous frame again at a refresh
+    if (!newFrame)
+        repeatedFrames.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint32_t VI::getDroppedFrames() {
+    // Get the number of frames that were replaced before they could be shown
+    return droppedFrames.load(std::memory_order_relaxed);
+}
+
+uint32_t VI::getRepeatedFrames() {
+    // Get the number of refreshes that showed the previous frame again because no new one was ready
+    return repeatedFrames.load(std::memory_order_relaxed);
 }
 
 void VI::reset() {
@@ -70,6 +170,10 @@ void VI::reset() {
     xScale = 0;
     yScale = 0;
 
+    // Reset the frame pacing counters
+    droppedFrames.store(0, std::memory_order_relaxed);
+    repeatedFrames.store(0, std::memory_order_relaxed);
+
     // Schedule the first frame to be drawn
     Core::schedule(drawFrame, (93750000 / 60) * 2);
 }
@@ -141,68 +245,90 @@ void VI::write(uint32_t address, uint32_t value) {
     }
 }
 
-void VI::drawFrame() {
-    // Ensure the RDP thread has finished drawing
-    RDP::finishThread();
-
-    // Allow up to 2 framebuffers to be queued, to preserve frame pacing if emulation runs ahead
-    if (framebuffers.size() < 2) {
-        // Create a new framebuffer
-        _Framebuffer *fb = new _Framebuffer();
-        fb->width = ((xScale ? xScale : 0x200) * hVideo) >> 10;
-        fb->height = ((yScale ? yScale : 0x200) * vVideo) >> 10;
-        fb->data = new uint32_t[fb->width * fb->height];
-
-        // Clear the screen if there's nothing to display
-        if (fb->width == 0 || fb->height == 0) {
-            fb->width = 8;
-            fb->height = 8;
-            delete[] fb->data;
-            fb->data = new uint32_t[fb->width * fb->height];
-            goto clear;
+void VI::convertRow(uint32_t *dst, const uint8_t *src, uint32_t offset, uint32_t count, bool rgba16) {
+    // Translate a row of pixels from host-endian RDRAM words, starting at a byte offset
+    uint32_t x = 0;
+    if (rgba16) {
+        // Convert a leading pixel on its own if the row starts in the middle of a word
+        if ((offset & 0x2) && count) {
+            dst[x++] = pixel16(*(const uint16_t*)&src[offset ^ 2]);
+            offset += 2;
         }
 
-        // Read the framebuffer from N64 memory
-        switch (control & 0x3) { // Type
-        case 0x3: // 32-bit
-            // Translate pixels from RGB_8888 to ARGB8888
-            for (uint32_t y = 0; y < fb->height; y++) {
-                for (uint32_t x = 0; x < fb->width; x++) {
-                    uint32_t color = Memory::read<uint32_t>(origin + ((y * width + x) << 2));
-                    uint8_t r = (color >> 24) & 0xFF;
-                    uint8_t g = (color >> 16) & 0xFF;
-                    uint8_t b = (color >>  8) & 0xFF;
-                    fb->data[y * fb->width + x] = (0xFF << 24) | (b << 16) | (g << 8) | r;
-                }
+        // Convert RGBA5551 pixels in batches of 8, then finish the remainder
+        for (; x + 8 <= count; x += 8, offset += 16)
+            convert16(&dst[x], &src[offset]);
+        for (; x < count; x++, offset += 2)
+            dst[x] = pixel16(*(const uint16_t*)&src[offset ^ 2]);
+    }
+    else {
+        // Convert RGBA8888 pixels in batches of 4, then finish the remainder
+        for (; x + 4 <= count; x += 4, offset += 16)
+            convert32(&dst[x], &src[offset]);
+        for (; x < count; x++, offset += 4)
+            dst[x] = pixel32(*(const uint32_t*)&src[offset]);
+    }
+}
+
+void VI::drawFrame() {
+    // Ensure the RDP threads have finished drawing
+    RDP::finishCommands();
+
+    // Draw into the back slot, which only the emulator touches until it's published
+    _Framebuffer *fb = &framebuffers[backSlot];
+
+    // Size the framebuffer, falling back to a blank screen if there's nothing to display
+    uint32_t type = control & 0x3;
+    fb->width = ((xScale ? xScale : 0x200) * hVideo) >> 10;
+    fb->height = ((yScale ? yScale : 0x200) * vVideo) >> 10;
+    if (fb->width == 0 || fb->height == 0) {
+        fb->width = 8;
+        fb->height = 8;
+        type = 0;
+    }
+
+    // Only reallocate the pixel data if the frame has grown
+    if (fb->width * fb->height > fb->capacity) {
+        delete[] fb->data;
+        fb->capacity = fb->width * fb->height;
+        fb->data = new uint32_t[fb->capacity];
+    }
+
+    if (type & 0x2) { // 16-bit or 32-bit
+        // Try to get a pointer to the whole framebuffer in RDRAM
+        uint32_t shift = (type == 0x3) ? 2 : 1;
+        uint32_t size = ((fb->height - 1) * width + fb->width) << shift;
+        uint8_t *src = (origin & 0x3) ? nullptr : Memory::getRdram(origin & 0x1FFFFFFF, size);
+
+        for (uint32_t y = 0; y < fb->height; y++) {
+            uint32_t *dst = &fb->data[y * fb->width];
+            uint32_t offset = (y * width) << shift;
+
+            if (src) {
+                // Translate rows of pixels directly from RDRAM
+                convertRow(dst, src, offset, fb->width, type == 0x2);
             }
-            break;
-
-        case 0x2: // 16-bit
-            // Translate pixels from RGB_5551 to ARGB8888
-            for (uint32_t y = 0; y < fb->height; y++) {
-                for (uint32_t x = 0; x < fb->width; x++) {
-                    uint16_t color = Memory::read<uint16_t>(origin + ((y * width + x) << 1));
-                    uint8_t r = ((color >> 11) & 0x1F) * 255 / 31;
-                    uint8_t g = ((color >>  6) & 0x1F) * 255 / 31;
-                    uint8_t b = ((color >>  1) & 0x1F) * 255 / 31;
-                    fb->data[y * fb->width + x] = (0xFF << 24) | (b << 16) | (g << 8) | r;
-                }
+            else if (type == 0x3) {
+                // Translate pixels from RGB_8888 to ARGB8888 through memory reads
+                for (uint32_t x = 0; x < fb->width; x++)
+                    dst[x] = pixel32(Memory::read<uint32_t>(origin + offset + (x << 2)));
+            }
+            else {
+                // Translate pixels from RGB_5551 to ARGB8888 through memory reads
+                for (uint32_t x = 0; x < fb->width; x++)
+                    dst[x] = pixel16(Memory::read<uint16_t>(origin + offset + (x << 1)));
             }
-            break;
-
-        default:
-        clear:
-            // Don't show anything
-            memset(fb->data, 0, fb->width * fb->height * sizeof(uint32_t));
-            break;
         }
-
-        // Add the frame to the queue
-        mutex.lock();
-        framebuffers.push(fb);
-        ready.store(true);
-        mutex.unlock();
     }
+    else {
+        // Don't show anything
+        memset(fb->data, 0, fb->width * fb->height * sizeof(uint32_t));
+    }
+
+    // Publish the frame as the newest one, counting a drop if the previous one was never shown
+    uint8_t old = mailbox.exchange(backSlot | 0x4, std::memory_order_acq_rel);
+    if (old & 0x4) droppedFrames.fetch_add(1, std::memory_order_relaxed);
+    backSlot = old & 0x3;
 
     // Finish the frame and request a VI interrupt
     // TODO: request interrupt at the proper time
@@ -24,13 +24,17 @@
 struct _Framebuffer {
     ~_Framebuffer() { delete[] data; }
 
-    uint32_t *data;
-    uint32_t width;
-    uint32_t height;
+    uint32_t *data = nullptr;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t capacity = 0;
 };
 
 namespace VI {
     _Framebuffer *getFramebuffer();
+    void frameShown(bool newFrame);
+    uint32_t getDroppedFrames();
+    uint32_t getRepeatedFrames();
 
     void reset();
     uint32_t read(uint32_t address);